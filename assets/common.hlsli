@@ -17,12 +17,68 @@ struct Instance
 struct Material
 {
     uint4 tex;
+    uint4 layers; // 0xffffffff: tex is a Texture2D, 0xfffffffe: a VirtualTexture, else the layer of a Texture2DArray
     uint alphaMode;
     float3 baseColor;
     float alphaCutOff;
     uint3 pad;
 };
 
+struct VirtualTexture
+{
+    uint firstEntry;
+    uint width;
+    uint height;
+    uint mipCount;
+    uint cache;
+    uint indirection;
+    uint feedback;
+    uint pad;
+};
+
+static const uint kPageSize = 256;
+static const uint kPageBorder = 4;
+static const uint kPagePayload = kPageSize - 2 * kPageBorder;
+static const uint kCachePages = 16;
+
+// Flags the page wanted at this pixel and samples the finest resident page covering it
+float4 sampleVirtual(VirtualTexture vt, SamplerState s, float2 uv)
+{
+    const uint2 size = uint2(vt.width, vt.height);
+    const float2 dx = ddx(uv * size);
+    const float2 dy = ddy(uv * size);
+    const float lod = 0.5f * log2(max(dot(dx, dx), dot(dy, dy)));
+    const uint mip = min(uint(max(lod, 0.f)), vt.mipCount - 1);
+    uv = frac(uv);
+
+    uint first = 0;
+    uint2 pages = uint2(1, 1);
+    for (uint m = 0; m <= mip; ++m)
+    {
+        pages = (max(size >> m, 1) + kPagePayload - 1) / kPagePayload;
+        if (m < mip)
+            first += pages.x * pages.y;
+    }
+
+    const uint2 page = min(uint2(uv * max(size >> mip, 1)) / kPagePayload, pages - 1);
+    const uint entry = vt.firstEntry + first + page.y * pages.x + page.x;
+    RWStructuredBuffer<uint> feedback = ResourceDescriptorHeap[vt.feedback];
+    feedback[entry] = 1;
+
+    StructuredBuffer<uint> indirection = ResourceDescriptorHeap[vt.indirection];
+    const uint packed = indirection[entry];
+    if (packed == 0xffffffff)
+        return float4(0.5f, 0.5f, 0.5f, 1.f);
+
+    // The page may come from a coarser mip, the texel is located again in that mip
+    const uint2 slot = uint2(packed & 0xff, (packed >> 8) & 0xff);
+    const float2 texel = uv * max(size >> (packed >> 16), 1);
+    const float2 inPage = texel - floor(texel / kPagePayload) * kPagePayload;
+    const float2 cacheUv = (slot * kPageSize + kPageBorder + inPage) / float(kCachePages * kPageSize);
+    Texture2D<float4> cache = ResourceDescriptorHeap[vt.cache];
+    return cache.SampleLevel(s, cacheUv, 0);
+}
+
 struct Mesh
 {
     float4 bbMin;
@@ -31,8 +87,40 @@ struct Mesh
     uint firstIndex;
     uint firstVertex;
     uint countVertex;
+    uint impostorMesh;
+    uint impostorTexture;
+    uint impostorFrames;
+    uint pad;
 };
 
+static const uint kNoImpostor = 0xffffffff;
+static const uint kImpostorFlag = 0x80000000; // Set on Command.instId when the impostor quad is drawn
+
+// Octahedral mapping of the impostor views, +y is the top of the octahedron as baked by lerPak
+float2 octEncode(float3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    float2 p = n.xz;
+    if (n.y < 0.f)
+        p = (1.f - abs(p.yx)) * float2(p.x >= 0.f ? 1.f : -1.f, p.y >= 0.f ? 1.f : -1.f);
+    return p;
+}
+
+float3 octDecode(float2 p)
+{
+    float3 n = float3(p.x, 1.f - abs(p.x) - abs(p.y), p.y);
+    if (n.y < 0.f)
+        n.xz = (1.f - abs(p.yx)) * float2(p.x >= 0.f ? 1.f : -1.f, p.y >= 0.f ? 1.f : -1.f);
+    return normalize(n);
+}
+
+void impostorBasis(float3 dir, out float3 right, out float3 up)
+{
+    const float3 up0 = abs(dir.y) > 0.99f ? float3(0.f, 0.f, 1.f) : float3(0.f, 1.f, 0.f);
+    right = normalize(cross(up0, dir));
+    up = cross(dir, right);
+}
+
 #ifdef __spirv__
 struct Command
 {
@@ -8,6 +8,7 @@ struct Frustum
     float4 planes[6];
     float4 corners[8];
     uint num;
+    float4 eye; // w: distance beyond which meshes with an impostor draw it instead
 };
 
 struct CullResources
@@ -115,6 +116,14 @@ void CSMain(uint3 DTid : SV_DispatchThreadID, uint3 GTid : SV_GroupThreadID)
 
         GroupMemoryBarrierWithGroupSync();
 
+        // Far meshes draw the quad of their impostor, the vertex shader turns it to the eye
+        if(bDrawMesh && mesh.impostorTexture != kNoImpostor &&
+           distance((mi + ma) * 0.5f, frustum.eye.xyz) > frustum.eye.w)
+        {
+            mesh = meshes[mesh.impostorMesh];
+            instId |= kImpostorFlag;
+        }
+
         if(bDrawMesh)
         {
             Command drawCommand;
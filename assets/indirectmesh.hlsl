@@ -19,7 +19,8 @@ struct UBO
     uint drawsIndex;
     uint instIndex;
     uint matIndex;
-    uint padb;
+    uint virtualIndex;
+    uint meshIndex;
 };
 
 struct DrawArg
@@ -52,11 +53,28 @@ PSInput VSMain(VSInput input)
     Command cmd = draws[gl.drawId];
 #endif
 
-    Instance inst = props[cmd.instId];
+    Instance inst = props[cmd.instId & ~kImpostorFlag];
 
     float4 tmpPos = float4(input.pos, 1.0);
-    result.pos = mul(pc.proj, mul(pc.view, mul(inst.model, tmpPos)));
     result.uv = input.uv.xy;
+    if(cmd.instId & kImpostorFlag)
+    {
+        // Quad of the view baked closest to the direction of the eye, in the object space of the instance
+        StructuredBuffer<Mesh> meshes = ResourceDescriptorHeap[pc.meshIndex];
+        Mesh mesh = meshes[inst.meshId];
+        float3 center = (mesh.bbMin.xyz + mesh.bbMax.xyz) * 0.5f;
+        float radius = length(mesh.bbMax.xyz - mesh.bbMin.xyz) * 0.5f;
+        float3 eye = -mul(transpose((float3x3)pc.view), float3(pc.view._m03, pc.view._m13, pc.view._m23));
+        float3 dir = normalize(mul(transpose((float3x3)inst.model), eye - mul(inst.model, float4(center, 1.f)).xyz));
+
+        float frames = float(mesh.impostorFrames);
+        float2 frame = min(floor((octEncode(dir) * 0.5f + 0.5f) * frames), frames - 1.f);
+        float3 right, up;
+        impostorBasis(octDecode((frame + 0.5f) / frames * 2.f - 1.f), right, up);
+        tmpPos = float4(center + (right * input.pos.x + up * input.pos.y) * radius, 1.f);
+        result.uv = (frame + input.uv.xy) / frames;
+    }
+    result.pos = mul(pc.proj, mul(pc.view, mul(inst.model, tmpPos)));
     result.instId = cmd.instId;
 
     return result;
@@ -66,12 +84,37 @@ float4 PSMain(PSInput input) : SV_TARGET
 {
     StructuredBuffer<Instance> props = ResourceDescriptorHeap[pc.drawsIndex];
     StructuredBuffer<Material> mats = ResourceDescriptorHeap[pc.matIndex];
-    Instance inst = props[input.instId];
+    Instance inst = props[input.instId & ~kImpostorFlag];
     Material m = mats[inst.skinId];
 
     SamplerState g_sampler = SamplerDescriptorHeap[0];
-    Texture2D<float4> texture = ResourceDescriptorHeap[m.tex.y];
-    float4 baseColor = texture.Sample(g_sampler, input.uv) * float4(m.baseColor, 1.f);
+    if(input.instId & kImpostorFlag)
+    {
+        StructuredBuffer<Mesh> meshes = ResourceDescriptorHeap[pc.meshIndex];
+        Texture2DArray<float4> views = ResourceDescriptorHeap[meshes[inst.meshId].impostorTexture];
+        float4 albedo = views.Sample(g_sampler, float3(input.uv, 0));
+        if(albedo.a < 0.5f)
+            discard;
+        return albedo;
+    }
+
+    float4 baseColor;
+    if(m.layers.y == 0xfffffffe)
+    {
+        StructuredBuffer<VirtualTexture> virtuals = ResourceDescriptorHeap[pc.virtualIndex];
+        baseColor = sampleVirtual(virtuals[m.tex.y], g_sampler, input.uv);
+    }
+    else if(m.layers.y != 0xffffffff)
+    {
+        Texture2DArray<float4> textures = ResourceDescriptorHeap[m.tex.y];
+        baseColor = textures.Sample(g_sampler, float3(input.uv, m.layers.y));
+    }
+    else
+    {
+        Texture2D<float4> texture = ResourceDescriptorHeap[m.tex.y];
+        baseColor = texture.Sample(g_sampler, input.uv);
+    }
+    baseColor *= float4(m.baseColor, 1.f);
 
     /*if(m.alphaMode == 0)
         baseColor.a = 1.f;
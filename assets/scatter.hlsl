@@ -0,0 +1,30 @@
+#include "common.hlsli"
+
+struct ScatterEntry
+{
+    Instance inst;
+    uint index;
+    uint3 pad;
+};
+
+struct ScatterResources
+{
+    uint srcIndex;
+    uint dstIndex;
+    uint count;
+};
+
+VkPush ConstantBuffer<ScatterResources> scatterResource : register(b0);
+
+[numthreads(64, 1, 1)]
+void CSMain(uint3 DTid : SV_DispatchThreadID)
+{
+    StructuredBuffer<ScatterEntry> entries = ResourceDescriptorHeap[scatterResource.srcIndex];
+    RWStructuredBuffer<Instance> props = ResourceDescriptorHeap[scatterResource.dstIndex];
+
+    if (DTid.x < scatterResource.count)
+    {
+        ScatterEntry entry = entries[DTid.x];
+        props[entry.index] = entry.inst;
+    }
+}
@@ -82,7 +82,7 @@ class TestLoadOneTex final : public rhi::IRenderPass
         async::sync_wait(*latch);*/
 
         render::ResourceManager mgr;
-        mgr.setup(storage, table);
+        mgr.setup(device, storage, table);
         mgr.openArchive(device, sys::ASSETS_DIR / "fat.pak");
     }
 
@@ -229,6 +229,8 @@ class TestIndirect final : public rhi::IRenderPass, public render::IMeshRenderer
     //CullIndex cullRes;
     uint32_t cullRes[6] = {};
     std::array<rhi::ResourceViewPtr,6> cullViews;
+    std::vector<std::pair<uint64_t, rhi::ResourceViewPtr>> retiredViews;
+    uint64_t frame = 0;
 
     rhi::BufferPtr drawConstant;
     rhi::BufferPtr cullConstant;
@@ -308,10 +310,31 @@ class TestIndirect final : public rhi::IRenderPass, public render::IMeshRenderer
     static constexpr std::array<uint32_t,4> kPattern = {0, 0, 1, 1};
     static constexpr std::span<const uint32_t> kClearer = kPattern;
 
+    // Mesh and skin tables are replaced when they grow, the old slots are freed once no frame reads them
+    void refreshView(uint32_t index, const rhi::BufferPtr& buffer)
+    {
+        if (params.table->getBuffer(cullRes[index]) == buffer)
+            return;
+        retiredViews.emplace_back(frame + rhi::ISwapChain::FrameCount, std::move(cullViews[index]));
+        cullViews[index] = params.table->createResourceView(buffer);
+        cullRes[index] = cullViews[index]->getBindlessIndex();
+    }
+
     void render(rhi::TexturePtr& backBuffer, rhi::CommandPtr& command) override
     {
         render::RenderMeshList* meshList = params.meshList;
 
+        ++frame;
+        std::erase_if(retiredViews, [&](const auto& retired) {
+            if (retired.first > frame)
+                return false;
+            std::lock_guard lock = params.table->lock();
+            params.table->freeBindlessIndex(retired.second->getBindlessIndex());
+            return true;
+        });
+        refreshView(1, meshList->getMeshBuffer());
+        refreshView(5, meshList->getSkinBuffer());
+
         command->addBufferBarrier(countBuffer, rhi::CopySrc);
         command->copyBuffer(countBuffer, readback, 16, 0);
         command->syncBuffer(countBuffer, kClearer.data(), kClearer.size_bytes());
@@ -327,6 +350,7 @@ class TestIndirect final : public rhi::IRenderPass, public render::IMeshRenderer
         getFrustumCorners(params.proj * params.view, f.corners);
         getFrustumPlanes(params.proj * params.view, f.planes);
         f.num = meshList->getInstanceCount();
+        f.eye = glm::vec4(glm::vec3(glm::inverse(params.view)[3]), params.impostorDistance);
         command->syncBuffer(frustBuffer, &f, sizeof(render::Frustum));
 
         command->bindPipeline(cullPass, params.table, cullConstant);
@@ -353,6 +377,8 @@ class TestIndirect final : public rhi::IRenderPass, public render::IMeshRenderer
         data.drawIndex = cullRes[0];
         data.instIndex = cullRes[2];
         data.matIndex = cullRes[5];
+        data.virtualIndex = params.virtualTextures;
+        data.meshIndex = cullRes[1];
         command->syncBuffer(drawConstant, &data, sizeof(render::DrawConstant));
 
         rhi::EncodeIndirectIndexedDrawDesc encoder;
@@ -388,6 +414,7 @@ class TestIndirect final : public rhi::IRenderPass, public render::IMeshRenderer
         getFrustumCorners(params.proj * params.view, f.corners);
         getFrustumPlanes(params.proj * params.view, f.planes);
         f.num = meshList.getInstanceCount();
+        f.eye = glm::vec4(glm::vec3(glm::inverse(params.view)[3]), params.impostorDistance);
         staging->uploadFromMemory(&f, sizeof(render::Frustum));
         command->addBufferBarrier(frustBuffer, rhi::CopyDest);
         command->copyBuffer(staging, frustBuffer, sizeof(render::Frustum), 0);
@@ -427,6 +454,8 @@ class TestIndirect final : public rhi::IRenderPass, public render::IMeshRenderer
         data.drawIndex = cullRes[0];
         data.instIndex = cullRes[2];
         data.matIndex = cullRes[5];
+        data.virtualIndex = params.virtualTextures;
+        data.meshIndex = cullRes[1];
         //command->syncBuffer(drawConstant, &data, sizeof(render::DrawConstant));
         drawConstant->uploadFromMemory(&data, sizeof(render::DrawConstant));
 
@@ -544,6 +573,7 @@ int main()
     cfg.height = 720;
     cfg.api = rhi::GraphicsAPI::D3D12;
     cfg.vsync = true;
+    cfg.hotReload = true;
     app::DesktopApp app(cfg);
     app.loadScene(sys::ASSETS_DIR / "fat.pak");
     //app.addPass<pass::DeferredScene>();
@@ -10,15 +10,17 @@
 #include "rhi/metal.hpp"
 #endif
 #include "img/loader.hpp"
+#include "render/telemetry.hpp"
 #include "rhi/vulkan.hpp"
 
 #define GLFW_INCLUDE_NONE // Do not include any OpenGL/Vulkan headers
 #include <GLFW/glfw3.h>
 #include <imgui_impl_glfw.h>
+#include <iomanip>
 
 namespace ler::app
 {
-DesktopApp::DesktopApp(AppConfig cfg)
+DesktopApp::DesktopApp(AppConfig cfg) : m_telemetry(cfg.telemetry), m_telemetryDump(std::move(cfg.telemetryDump))
 {
     log::setup(log::level::debug);
     log::info("LER DesktopApp Init");
@@ -47,6 +49,8 @@ DesktopApp::DesktopApp(AppConfig cfg)
     rhi::DeviceConfig devConfig;
     devConfig.debug = cfg.debug;
     devConfig.hostBuffer = !cfg.debug;
+    devConfig.directIo = cfg.directIo;
+    devConfig.verifyContent = cfg.verifyContent;
     devConfig.extensions.assign(extensions, extensions + count);
 
     if (cfg.api == rhi::GraphicsAPI::VULKAN)
@@ -82,7 +86,8 @@ DesktopApp::DesktopApp(AppConfig cfg)
     ImGui::StyleColorsDark();
 
     m_table = m_device->createBindlessTable(1024);
-    m_resourceMgr.setup(m_device->getStorage(), m_table);
+    m_resourceMgr.setup(m_device, m_device->getStorage(), m_table);
+    m_resourceMgr.setHotReload(cfg.hotReload);
 
     rhi::SamplerDesc sd;
     sd.filter = true;
@@ -126,6 +131,9 @@ struct EmptyMeshRenderer final : public render::IMeshRenderer
 
 void DesktopApp::run()
 {
+    if (m_telemetry)
+        addPass<render::TelemetryPanel>();
+
     if (m_device->getGraphicsAPI() == rhi::GraphicsAPI::VULKAN)
     {
         ImGui_ImplGlfw_InitForVulkan(m_window, true);
@@ -149,6 +157,7 @@ void DesktopApp::run()
     render::RenderParams params;
     params.meshList = m_meshList;
     params.table = m_table;
+    params.virtualTextures = m_resourceMgr.getVirtualTextures().getBindlessIndex();
     for (const auto& pass : m_renderPasses)
     {
         /*auto* graph = dynamic_cast<render::RenderGraph*>(pass.get());
@@ -179,12 +188,17 @@ void DesktopApp::run()
 
         params.proj = m_camera->getProjMatrix();
         params.view = m_camera->getViewMatrix();
+        m_resourceMgr.streamCells(m_device, glm::vec3(glm::inverse(params.view)[3]));
 
         // for (const auto& pass : m_renderPasses)
         // pass->begin();
 
         m_swapChain->present([&](rhi::TexturePtr& backBuffer, rhi::CommandPtr& command) {
             command->addImageBarrier(backBuffer, rhi::RenderTarget);
+            m_resourceMgr.getMeshBuffers().flush(command);
+            if (m_meshList != nullptr)
+                m_meshList->flush(command);
+            m_resourceMgr.getVirtualTextures().flush(command);
             for (const std::shared_ptr<rhi::IRenderPass>& pass : m_renderPasses)
                 pass->begin(backBuffer);
 
@@ -199,9 +213,12 @@ void DesktopApp::run()
         });
 
         m_device->runGarbageCollection();
+        m_resourceMgr.update(m_device);
+        updateLoadProgress();
     }
 
     m_device->waitIdle();
+    dumpTelemetry();
     m_renderPasses.clear();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -209,6 +226,44 @@ void DesktopApp::run()
     glfwTerminate();
 }
 
+void DesktopApp::updateLoadProgress()
+{
+    const render::LoadProgress progress = m_resourceMgr.getLoadProgress();
+    const int percent = progress.loads == 0 ? -1 : static_cast<int>(progress.completed * 100 / std::max<uint64_t>(progress.requests, 1));
+    if (percent == m_loadPercent)
+        return;
+
+    m_loadPercent = percent;
+    if (percent < 0)
+        glfwSetWindowTitle(m_window, "LER");
+    else
+        glfwSetWindowTitle(m_window, fmt::format("LER - Loading {}%", percent).c_str());
+}
+
+void DesktopApp::dumpTelemetry() const
+{
+    if (m_telemetryDump.empty())
+        return;
+
+    std::ofstream file(m_telemetryDump);
+    if (!file.is_open())
+    {
+        log::error("Failed to write telemetry to {}", m_telemetryDump.string());
+        return;
+    }
+    json telemetry = m_device->getStorage()->getTelemetry();
+    if (m_meshList != nullptr)
+    {
+        const render::RenderMeshList::Stats& stats = m_meshList->getStats();
+        telemetry["mesh_list"] = json{ { "flushes", stats.flushes },
+                                       { "ranges", stats.ranges },
+                                       { "scatters", stats.scatters },
+                                       { "uploaded_bytes", stats.uploadedBytes } };
+    }
+    file << std::setw(4) << telemetry;
+    log::info("Telemetry written to {}", m_telemetryDump.string());
+}
+
 void DesktopApp::loadScene(const fs::path& path)
 {
     m_resourceMgr.openArchive(m_device, path);
@@ -22,6 +22,12 @@ struct AppConfig
     bool debug = true;
     bool vsync = true;
     bool msaa = true;
+    bool directIo = false;
+    bool verifyContent = false; // Reject pak entries whose checksum does not match
+    bool hotReload = false; // Swap in archives re-cooked on disk
+    // Streaming panel, counters are dumped to telemetryDump on exit (empty to disable)
+    bool telemetry = true;
+    fs::path telemetryDump;
 };
 
 class DesktopApp
@@ -56,6 +62,8 @@ class DesktopApp
     static void glfw_size_callback(GLFWwindow* window, int width, int height);
 
     void notifyResize();
+    void dumpTelemetry() const;
+    void updateLoadProgress();
 
     GLFWwindow* m_window = nullptr;
     rhi::DevicePtr m_device;
@@ -66,6 +74,9 @@ class DesktopApp
     std::vector<render::IMeshRenderer*> m_meshRenderer;
     render::ResourceManager m_resourceMgr;
     render::RenderMeshList* m_meshList = nullptr;
+    int m_loadPercent = -1; // Shown in the title, -1 once everything landed
     cam::CameraPtr m_camera;
+    bool m_telemetry = true;
+    fs::path m_telemetryDump;
 };
 } // namespace ler::app
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include "archive_generated.h"
+#include "sys/ioring.hpp"
+#include "sys/utils.hpp"
+
+#include <argparse/argparse.hpp>
+#include <fcntl.h>
+#include <fstream>
+
+using namespace ler;
+
+static constexpr uint32_t kStagingCount = 8;
+static constexpr uint32_t kStagingSize = 64u << 20;
+
+using Batch = std::vector<sys::IoService::FileLoadRequest>;
+
+// Same slicing as the streaming path: entries packed in staging sized batches
+static std::vector<Batch> makeBatches(const pak::PakArchive* archive, sys::ReadOnlyFile* file)
+{
+    std::vector<Batch> batches(1);
+    uint32_t used = 0;
+    for (const pak::PakEntry* entry : *archive->entries())
+    {
+        uint64_t offset = entry->byte_offset();
+        uint64_t remaining = entry->byte_length();
+        while (remaining > 0)
+        {
+            if (used == kStagingSize)
+            {
+                batches.emplace_back();
+                used = 0;
+            }
+            const auto length = static_cast<uint32_t>(std::min<uint64_t>(remaining, kStagingSize - used));
+            batches.back().emplace_back(file, length, offset, used, 0);
+            constexpr uint32_t kAlign = sys::ReadOnlyFile::kDirectAlignment;
+            used = std::min((used + length + kAlign - 1) & ~(kAlign - 1), kStagingSize);
+            offset += length;
+            remaining -= length;
+        }
+    }
+    return batches;
+}
+
+// Each lane owns one staging buffer and walks every kStagingCount-th batch
+static coro::task<> makeLane(coro::thread_pool& tp, sys::IoService& ios, std::vector<Batch>& batches, uint32_t lane,
+                             coro::latch& latch)
+{
+    co_await tp.schedule();
+    for (size_t i = lane; i < batches.size(); i += kStagingCount)
+    {
+        for (sys::IoService::FileLoadRequest& req : batches[i])
+            req.buffIndex = static_cast<int32_t>(lane);
+        co_await ios.submit(batches[i]);
+    }
+    latch.count_down();
+}
+
+static const pak::PakArchive* readHeader(const fs::path& path, std::vector<uint8_t>& buffer)
+{
+    std::ifstream file(path, std::ios::binary);
+    char header[4];
+    file.read(header, 4);
+    if (!file || std::string_view(header, 4) != "LEPK")
+        return nullptr;
+
+    int64_t fbSize;
+    file.read(reinterpret_cast<char*>(&fbSize), 8);
+    buffer.resize(fbSize);
+    file.read(reinterpret_cast<char*>(buffer.data()), fbSize);
+
+    flatbuffers::Verifier v(buffer.data(), buffer.size());
+    if (!file || !pak::VerifyPakArchiveBuffer(v))
+        return nullptr;
+    return pak::GetPakArchive(buffer.data());
+}
+
+int main(int argc, char* argv[])
+{
+    log::setup(log::level::info);
+
+    argparse::ArgumentParser program("ioBench");
+    program.add_argument("pak").metavar("FILE").help("archive to stream");
+    program.add_argument("-n", "--iterations").default_value(5).scan<'i', int>().help("passes per backend");
+    program.add_argument("--direct").default_value(false).implicit_value(true).help("bypass the page cache");
+    program.add_argument("--warm").default_value(false).implicit_value(true).help("keep the page cache between passes");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::exception& err)
+    {
+        log::error(err.what());
+        std::cerr << program;
+        return EXIT_FAILURE;
+    }
+
+    const fs::path path = program.get<std::string>("pak");
+    const int iterations = program.get<int>("--iterations");
+    const bool direct = program.get<bool>("--direct");
+    const bool warm = program.get<bool>("--warm");
+
+    std::vector<uint8_t> header;
+    const pak::PakArchive* archive = readHeader(path, header);
+    if (archive == nullptr)
+    {
+        log::error("Invalid archive: {}", path.string());
+        return EXIT_FAILURE;
+    }
+
+    log::info("CPU: {}, {} Threads", sys::getCpuName(), std::thread::hardware_concurrency());
+    log::info("Archive: {} ({} entries)", path.string(), archive->entries()->size());
+
+    std::vector<sys::IoService::BufferInfo> buffers;
+    for (uint32_t i = 0; i < kStagingCount; ++i)
+        buffers.emplace_back(std::aligned_alloc(sys::ReadOnlyFile::kDirectAlignment, kStagingSize), kStagingSize);
+
+    using Backend = sys::IoService::Backend;
+    for (const Backend backend : { Backend::IoRing, Backend::ThreadPool })
+    {
+        auto tp = std::make_shared<coro::thread_pool>(coro::thread_pool::options{ .thread_count = kStagingCount });
+        sys::IoService ios(tp, backend);
+        if (ios.getBackend() != backend)
+        {
+            log::warn("{} backend unavailable, skipped", sys::toString(backend));
+            continue;
+        }
+
+        sys::ReadOnlyFile file(path, direct);
+        std::vector<Batch> batches = makeBatches(archive, &file);
+        ios.registerBuffers(buffers, false);
+
+        uint64_t bytes = 0;
+        for (const Batch& batch : batches)
+            for (const sys::IoService::FileLoadRequest& req : batch)
+                bytes += req.fileLength;
+
+        double best = 0.0;
+        double total = 0.0;
+        for (int i = 0; i < iterations; ++i)
+        {
+            if (!warm)
+                posix_fadvise(file.getNativeHandle(), 0, 0, POSIX_FADV_DONTNEED);
+
+            const auto start = std::chrono::steady_clock::now();
+            coro::latch latch(kStagingCount);
+            for (uint32_t lane = 0; lane < kStagingCount; ++lane)
+                tp->spawn(makeLane(*tp, ios, batches, lane, latch));
+            coro::sync_wait(latch);
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            const double gbps = static_cast<double>(bytes) / elapsed.count() / 1e9;
+            best = std::max(best, gbps);
+            total += gbps;
+        }
+
+        const sys::LatencyHistogram::Snapshot latency = ios.getStats().batchLatency.snapshot();
+        log::info("{:>10}: avg {:.2f} GB/s, best {:.2f} GB/s, batch p50 {:.0f} us, p99 {:.0f} us",
+                  sys::toString(backend), total / iterations, best, latency.p50, latency.p99);
+    }
+
+    for (const sys::IoService::BufferInfo& b : buffers)
+        std::free(b.address);
+
+    return EXIT_SUCCESS;
+}
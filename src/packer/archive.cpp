@@ -8,11 +8,16 @@
 #include <flatbuffers/flatbuffers.h>
 #include <flatbuffers/idl.h>
 #include <fstream>
+#include <map>
+#include <xxhash.h>
 
 namespace ler::pak
 {
 static constexpr int64_t ALIGNMENT = 64 * 1024; // 64 KB en bytes
 static constexpr int64_t METADATA = ALIGNMENT * 4;
+static constexpr uint32_t kAtlasMaxSize = 128;   // Textures up to this size are packed in arrays
+static constexpr uint32_t kAtlasMaxLayers = 256; // Lowest maxImageArrayLayers a Vulkan device may report
+static constexpr uint64_t kLayerAlignment = 512; // D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT
 
 static void appendPadding(std::ofstream& outFile, uint64_t paddingSize)
 {
@@ -49,14 +54,39 @@ void PakPacker::setParentDir(const fs::path& root)
 
 void PakPacker::finish()
 {
+    deduplicateMaterials();
+    if (m_batchSize > 0.f)
+        batchInstances();
+    if (m_impostorVertices > 0)
+        bakeImpostors();
+    if (m_cellSize > 0.f)
+        partitionCells();
+    else if (!m_batchSources.empty())
+        moveBatchSources();
+
     Buffer buffer(BufferType_Index);
     int64_t currentPos = m_outFile.tellp();
 
+    constexpr uint16_t atlasSize = kImpostorFrames * kImpostorFrameSize;
+    for (const ImpostorAtlas& atlas : m_impostorAtlases)
+    {
+        alignOutput(m_outFile, currentPos);
+        currentPos = m_outFile.tellp();
+        m_outFile.write(atlas.content.data(), static_cast<std::streamsize>(atlas.content.size()));
+        auto t = CreateTexture(m_builder, m_builder.CreateString("impostor_" + std::to_string(atlas.id)), atlasSize,
+                               atlasSize, kImpostorMips, TextureFormat_Rgba8,
+                               m_builder.CreateVectorOfStructs(atlas.footprints), atlas.id, 2);
+        m_entries.emplace_back(CreatePakEntry(m_builder, atlas.content.size(), currentPos, ResourceType_Texture,
+                                              t.Union(), XXH3_64bits(atlas.content.data(), atlas.content.size())));
+        currentPos += static_cast<int64_t>(atlas.content.size());
+    }
+
     alignOutput(m_outFile, currentPos);
     currentPos = m_outFile.tellp();
     auto currentSize = static_cast<int64_t>(m_indexBuffer.size() * sizeof(uint32_t));
     m_entries.emplace_back(CreatePakEntry(m_builder, currentSize, currentPos, ResourceType_Buffer,
-                                          m_builder.CreateStruct(buffer).Union()));
+                                          m_builder.CreateStruct(buffer).Union(),
+                                          XXH3_64bits(m_indexBuffer.data(), currentSize)));
     m_outFile.write(reinterpret_cast<const char*>(m_indexBuffer.data()), currentSize);
     currentPos += currentSize;
 
@@ -69,7 +99,8 @@ void PakPacker::finish()
         currentSize = static_cast<int64_t>(b.size() * sizeof(aiVector3D));
         m_outFile.write(reinterpret_cast<const char*>(b.data()), currentSize);
         m_entries.emplace_back(CreatePakEntry(m_builder, currentSize, currentPos, ResourceType_Buffer,
-                                              m_builder.CreateStruct(buffer).Union()));
+                                              m_builder.CreateStruct(buffer).Union(),
+                                              XXH3_64bits(b.data(), currentSize)));
         currentPos += currentSize;
     }
 
@@ -79,7 +110,23 @@ void PakPacker::finish()
     auto me = m_builder.CreateVectorOfStructs(m_meshVector);
     auto ma = m_builder.CreateVectorOfStructs(m_materialVector);
     auto in = m_builder.CreateVectorOfStructs(m_instanceVector);
-    flatbuffers::Offset<PakArchive> archive = CreatePakArchive(m_builder, en, ma, in, me);
+
+    std::vector<flatbuffers::Offset<Cell>> cells;
+    for (const CellInfo& c : m_cells)
+    {
+        const Vec3 bbMin(c.bbMin.x, c.bbMin.y, c.bbMin.z);
+        const Vec3 bbMax(c.bbMax.x, c.bbMax.y, c.bbMax.z);
+        const std::vector<uint64_t> textures(c.textures.begin(), c.textures.end());
+        cells.emplace_back(CreateCell(m_builder, &bbMin, &bbMax, c.firstInstance, c.instanceCount, c.firstMesh,
+                                      c.meshCount, m_builder.CreateVector(textures)));
+    }
+    auto ce = m_builder.CreateVector(cells);
+    auto mi = m_builder.CreateVector(m_meshIds);
+    auto si = m_builder.CreateVector(m_materialIds);
+    auto bs = m_builder.CreateVectorOfStructs(m_batchSources);
+    auto im = m_builder.CreateVectorOfStructs(m_impostors);
+    flatbuffers::Offset<PakArchive> archive =
+        CreatePakArchive(m_builder, en, ma, in, me, ce, m_cellSize, mi, si, bs, im, m_sourceMeshCount);
     FinishPakArchiveBuffer(m_builder, archive);
 
     /*flatbuffers::ToStringVisitor stringVisitor("\n", true, "  ", true);
@@ -100,34 +147,138 @@ void PakPacker::finish()
     m_outFile.close();
 }
 
+static bool readCookedTexture(const fs::path& path, std::vector<char>& content)
+{
+    std::error_code ec;
+    const auto size = static_cast<uint64_t>(fs::file_size(path, ec));
+    if (ec.value())
+    {
+        log::error("File Not Found: " + ec.message());
+        return false;
+    }
+
+    content.resize(size);
+    std::ifstream inFile(path, std::ios::binary);
+    if (!inFile.read(content.data(), static_cast<std::streamsize>(size)))
+    {
+        log::error("Failed to read: {}", path.string());
+        return false;
+    }
+    return true;
+}
+
 void PakPacker::concatenateFilesWithAlignment(std::ofstream& outFile, flatbuffers::FlatBufferBuilder& builder,
                                               std::vector<flatbuffers::Offset<PakEntry>>& entries)
 {
     int64_t currentPos = m_outFile.tellp();
     entries.reserve(m_textureMap.size());
-    for (auto& tex : std::views::values(m_textureMap))
-    {
-        std::string filename = tex.gpuFile.stem().string();
-        auto t = CreateTexture(builder, builder.CreateString(filename), tex.width, tex.height, tex.mipLevels,
-                               convertCMPFormat(tex.format));
 
-        std::error_code ec;
-        const auto currentSize = static_cast<uint64_t>(fs::file_size(tex.gpuFile, ec));
-        if (ec.value())
-        {
-            log::error("File Not Found: " + ec.message());
-            continue;
-        }
-
-        std::ifstream inFile(tex.gpuFile, std::ios::binary);
+    const auto writeEntry = [&](flatbuffers::Offset<Texture> t, const std::vector<char>& content) {
         alignOutput(outFile, currentPos);
         currentPos = outFile.tellp();
-        outFile << inFile.rdbuf();
-        log::info("Packing: {}", tex.gpuFile.string());
+        outFile.write(content.data(), static_cast<std::streamsize>(content.size()));
         if (currentPos % ALIGNMENT != 0)
             log::error("Padding is wrong");
-        entries.emplace_back(CreatePakEntry(builder, currentSize, currentPos, ResourceType_Texture, t.Union()));
-        currentPos += inFile.tellg();
+        entries.emplace_back(CreatePakEntry(builder, content.size(), currentPos, ResourceType_Texture, t.Union(),
+                                            XXH3_64bits(content.data(), content.size())));
+        currentPos += static_cast<int64_t>(content.size());
+    };
+
+    // Small textures of the same format, size and mip count become the layers of one array,
+    // they only have a footprint layout once cooked
+    using AtlasKey = std::tuple<CMP_FORMAT, uint16_t, uint16_t, uint8_t>;
+    std::map<AtlasKey, std::vector<const PackedTextureMetadata*>> groups;
+    std::vector<const PackedTextureMetadata*> singles;
+    std::vector<const PackedTextureMetadata*> virtuals;
+    for (const PackedTextureMetadata& tex : std::views::values(m_textureMap))
+    {
+        // Duplicates were not cooked, an earlier scene may also have packed the same texture
+        if (tex.gpuFile.empty() || !m_packedTextures.emplace(sys::makeAssetId(tex.gpuFile.stem().string())).second)
+            continue;
+        if (isPageable(tex))
+            virtuals.emplace_back(&tex);
+        else if (tex.width <= kAtlasMaxSize && tex.height <= kAtlasMaxSize && !tex.footprints.empty())
+            groups[AtlasKey(tex.format, tex.width, tex.height, tex.mipLevels)].emplace_back(&tex);
+        else
+            singles.emplace_back(&tex);
+    }
+
+    std::vector<char> content;
+    for (auto& [key, group] : groups)
+    {
+        const auto [format, width, height, mipLevels] = key;
+        for (size_t first = 0; first < group.size(); first += kAtlasMaxLayers)
+        {
+            const size_t count = std::min<size_t>(group.size() - first, kAtlasMaxLayers);
+            if (count == 1)
+            {
+                singles.emplace_back(group[first]);
+                continue;
+            }
+
+            // Layers follow each other, each one aligned like a subresource
+            std::vector<char> layerContent;
+            std::vector<CopyFootprint> footprints;
+            std::vector<uint64_t> layers;
+            std::vector<const PackedTextureMetadata*> members;
+            content.clear();
+            for (const PackedTextureMetadata* tex : std::span(group).subspan(first, count))
+            {
+                if (!readCookedTexture(tex->gpuFile, layerContent))
+                    continue;
+                members.emplace_back(tex);
+                const uint64_t base = (content.size() + kLayerAlignment - 1) & ~(kLayerAlignment - 1);
+                content.resize(base);
+                content.insert(content.end(), layerContent.begin(), layerContent.end());
+                for (const CopyFootprint& fp : tex->footprints)
+                    footprints.emplace_back(base + fp.buffer_offset(), fp.row_length(), fp.width(), fp.height());
+                layers.emplace_back(sys::makeAssetId(tex->gpuFile.stem().string()));
+            }
+
+            // Members that failed to read leave too few layers for an array, the others are packed standalone
+            if (members.size() < 2)
+            {
+                singles.insert(singles.end(), members.begin(), members.end());
+                continue;
+            }
+
+            // Same layers give the same array, archives mounted together share it
+            const sys::AssetId id = XXH3_64bits(layers.data(), layers.size() * sizeof(uint64_t));
+            const std::string name = "atlas_" + std::to_string(id);
+            auto t = CreateTexture(builder, builder.CreateString(name), width, height, mipLevels,
+                                   convertCMPFormat(format), builder.CreateVectorOfStructs(footprints), id,
+                                   static_cast<uint16_t>(layers.size()), builder.CreateVector(layers));
+            writeEntry(t, content);
+            log::info("Packing: {} ({} layers of {}x{})", name, layers.size(), width, height);
+        }
+    }
+
+    std::vector<VirtualMip> mips;
+    for (const PackedTextureMetadata* tex : virtuals)
+    {
+        if (!readCookedTexture(tex->gpuFile, content))
+            continue;
+        mips.clear();
+        const std::vector<char> pages = cutPages(*tex, content, mips);
+        std::string filename = tex->gpuFile.stem().string();
+        auto t = CreateTexture(builder, builder.CreateString(filename), tex->width, tex->height,
+                               static_cast<uint8_t>(mips.size()), convertCMPFormat(tex->format), 0,
+                               sys::makeAssetId(filename), 1, 0, kPageSize, kPageBorder,
+                               builder.CreateVectorOfStructs(mips));
+        writeEntry(t, pages);
+        log::info("Packing: {} ({} pages)", tex->gpuFile.string(), pages.size() / kPageStride);
+    }
+
+    for (const PackedTextureMetadata* tex : singles)
+    {
+        if (!readCookedTexture(tex->gpuFile, content))
+            continue;
+        std::string filename = tex->gpuFile.stem().string();
+        auto t = CreateTexture(builder, builder.CreateString(filename), tex->width, tex->height, tex->mipLevels,
+                               convertCMPFormat(tex->format), builder.CreateVectorOfStructs(tex->footprints),
+                               sys::makeAssetId(filename));
+        writeEntry(t, content);
+        log::info("Packing: {}", tex->gpuFile.string());
     }
 }
 } // namespace ler::pak
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "importer.hpp"
+
+#include <map>
+#include <xxhash.h>
+
+namespace ler::pak
+{
+static aiVector3D toAiVector(const Vec3& vec)
+{
+    return { vec.x(), vec.y(), vec.z() };
+}
+
+static aiMatrix4x4 toAiMatrix(const Instance& inst)
+{
+    aiMatrix4x4 model;
+    std::memcpy(&model, inst.transform()->data(), sizeof(aiMatrix4x4));
+    return model.Transpose();
+}
+
+void PakPacker::batchInstances()
+{
+    // Cell on the XZ grid and material, instances of a key end up in the same draw
+    using BatchKey = std::tuple<int32_t, int32_t, uint32_t>;
+    std::map<BatchKey, std::vector<uint32_t>> groups;
+    std::vector<Instance> instances;
+    for (uint32_t i = 0; i < m_instanceVector.size(); ++i)
+    {
+        const Instance& inst = m_instanceVector[i];
+        const Mesh& mesh = m_meshVector[inst.mesh_id()];
+        if (mesh.count_vertex() > kMaxBatchedVertices)
+        {
+            instances.emplace_back(inst);
+            continue;
+        }
+
+        const aiVector3D center = toAiMatrix(inst) * ((toAiVector(mesh.bbmin()) + toAiVector(mesh.bbmax())) * 0.5f);
+        const BatchKey key(static_cast<int32_t>(std::floor(center.x / m_batchSize)),
+                           static_cast<int32_t>(std::floor(center.z / m_batchSize)), inst.skin_id());
+        groups[key].emplace_back(i);
+    }
+
+    uint32_t batchCount = 0;
+    for (const std::vector<uint32_t>& members : std::views::values(groups))
+    {
+        // Split in runs that fit a merged mesh, a run of one stays a regular instance
+        size_t begin = 0;
+        while (begin < members.size())
+        {
+            size_t end = begin;
+            uint32_t vertexCount = 0;
+            while (end < members.size())
+            {
+                const uint32_t count = m_meshVector[m_instanceVector[members[end]].mesh_id()].count_vertex();
+                if (vertexCount + count > kMaxBatchVertices)
+                    break;
+                vertexCount += count;
+                ++end;
+            }
+
+            if (end - begin == 1)
+                instances.emplace_back(m_instanceVector[members[begin]]);
+            else
+            {
+                instances.emplace_back(appendBatch(std::span(members).subspan(begin, end - begin)));
+                ++batchCount;
+            }
+            begin = end;
+        }
+    }
+
+    log::info("Batched {} instances in {} meshes, {} draws instead of {}", m_batchSources.size(), batchCount,
+              instances.size(), m_instanceVector.size());
+    m_instanceVector = std::move(instances);
+}
+
+Instance PakPacker::appendBatch(std::span<const uint32_t> members)
+{
+    // Vertices are moved to world space, the batch is drawn with an identity transform
+    const auto firstIndex = static_cast<uint32_t>(m_indexBuffer.size());
+    const auto firstVertex = static_cast<uint32_t>(m_vertexBuffers[0].size());
+    aiVector3D bbMin(std::numeric_limits<float>::max());
+    aiVector3D bbMax(std::numeric_limits<float>::lowest());
+
+    XXH3_state_t state;
+    XXH3_64bits_reset(&state);
+    for (uint32_t member : members)
+    {
+        const Instance& inst = m_instanceVector[member];
+        const Mesh& mesh = m_meshVector[inst.mesh_id()];
+        const aiMatrix4x4 model = toAiMatrix(inst);
+        const aiMatrix3x3 rotation(model);
+        const aiMatrix3x3 normalMatrix = aiMatrix3x3(rotation).Inverse().Transpose();
+        const auto base = static_cast<uint32_t>(m_vertexBuffers[0].size()) - firstVertex;
+
+        for (uint32_t i = 0; i < mesh.count_index(); ++i)
+            m_indexBuffer.emplace_back(m_indexBuffer[mesh.first_index() + i] + base);
+
+        const auto firstSource = static_cast<uint32_t>(mesh.first_vertex());
+        for (uint32_t v = firstSource; v < firstSource + mesh.count_vertex(); ++v)
+        {
+            const aiVector3D position = model * m_vertexBuffers[0][v];
+            const aiVector3D texcoord = m_vertexBuffers[1][v];
+            const aiVector3D normal = (normalMatrix * m_vertexBuffers[2][v]).NormalizeSafe();
+            const aiVector3D tangent = (rotation * m_vertexBuffers[3][v]).NormalizeSafe();
+            m_vertexBuffers[0].emplace_back(position);
+            m_vertexBuffers[1].emplace_back(texcoord);
+            m_vertexBuffers[2].emplace_back(normal);
+            m_vertexBuffers[3].emplace_back(tangent);
+            bbMin = aiVector3D(std::min(bbMin.x, position.x), std::min(bbMin.y, position.y),
+                               std::min(bbMin.z, position.z));
+            bbMax = aiVector3D(std::max(bbMax.x, position.x), std::max(bbMax.y, position.y),
+                               std::max(bbMax.z, position.z));
+        }
+
+        XXH3_64bits_update(&state, &m_meshIds[inst.mesh_id()], sizeof(sys::AssetId));
+        XXH3_64bits_update(&state, inst.transform()->data(), sizeof(float) * 16);
+    }
+
+    // Same members in the same places give the same ID when the scene is packed again
+    const sys::AssetId batchId = XXH3_64bits_digest(&state);
+    for (uint32_t member : members)
+    {
+        const Instance& inst = m_instanceVector[member];
+        m_batchSources.emplace_back(batchId, m_meshIds[inst.mesh_id()], inst.skin_id(),
+                                    flatbuffers::span<const float, 16>(inst.transform()->data(), 16));
+    }
+
+    const auto meshId = static_cast<uint32_t>(m_meshVector.size());
+    m_meshVector.emplace_back(static_cast<uint32_t>(m_indexBuffer.size()) - firstIndex, firstIndex,
+                              static_cast<int32_t>(firstVertex),
+                              static_cast<uint32_t>(m_vertexBuffers[0].size()) - firstVertex,
+                              Vec3(bbMin.x, bbMin.y, bbMin.z), Vec3(bbMax.x, bbMax.y, bbMax.z));
+    m_meshIds.emplace_back(batchId);
+
+    const aiMatrix4x4 identity;
+    return { meshId, m_instanceVector[members.front()].skin_id(),
+             flatbuffers::span<const float, 16>(identity[0], 16) };
+}
+
+void PakPacker::moveBatchSources()
+{
+    // Merged members are only read back through batch sources, their meshes go after the ones loaded at open
+    std::vector<bool> drawn(m_meshVector.size(), false);
+    for (const Instance& inst : m_instanceVector)
+        drawn[inst.mesh_id()] = true;
+    for (const Impostor& impostor : m_impostors)
+        drawn[impostor.quad_id()] = true;
+
+    std::vector<uint32_t> order;
+    order.reserve(m_meshVector.size());
+    for (uint32_t id = 0; id < drawn.size(); ++id)
+    {
+        if (drawn[id])
+            order.emplace_back(id);
+    }
+    const auto drawnCount = static_cast<uint32_t>(order.size());
+    for (uint32_t id = 0; id < drawn.size(); ++id)
+    {
+        if (!drawn[id])
+            order.emplace_back(id);
+    }
+
+    m_sourceMeshCount = static_cast<uint32_t>(order.size()) - drawnCount;
+    reorderMeshes(order);
+    log::info("Moved {} batch source meshes out of the resident geometry", m_sourceMeshCount);
+}
+} // namespace ler::pak
@@ -16,8 +16,12 @@
 namespace fs = std::filesystem;
 #include <bitset>
 #include <fstream>
+#include <set>
+#include <span>
+#include <unordered_set>
 
 #include "archive_generated.h"
+#include "sys/asset.hpp"
 
 namespace ler::pak
 {
@@ -30,6 +34,23 @@ struct PackedTextureMetadata
     std::string filename;
     CMP_FORMAT format;
     fs::path gpuFile;
+    std::vector<CopyFootprint> footprints;
+};
+
+// Decoded base color, kept small to shade impostors
+struct AlbedoSample
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> texels; // RGBA8
+};
+
+// Texture array baked by lerPak, written next to the geometry
+struct ImpostorAtlas
+{
+    sys::AssetId id = 0;
+    std::vector<char> content;
+    std::vector<CopyFootprint> footprints;
 };
 
 class PakPacker
@@ -64,6 +85,16 @@ class PakPacker
     void processSceneNode(aiNode* aiNode, aiMesh** meshes);
     void processTextures(const aiScene* aiScene, bool cook = true);
     void processMeshes(const aiScene* aiScene);
+    // Points materials to deduplicated textures and merges identical materials
+    void deduplicateMaterials();
+    // World partition grid, 0 keeps the scene in a single always loaded block
+    void setCellSize(float size) { m_cellSize = size; }
+    // Cooked textures larger than this are cut in pages streamed on demand, 0 disables virtual texturing
+    void setVirtualTextureSize(uint32_t size) { m_virtualSize = size; }
+    // Grid merging the small static instances of a material into one mesh per cell, 0 disables batching
+    void setBatchSize(float size) { m_batchSize = size; }
+    // Meshes with at least this many vertices get an impostor drawn far away, 0 disables impostors
+    void setImpostorVertices(uint32_t count) { m_impostorVertices = count; }
     void finish();
 
   private:
@@ -77,13 +108,62 @@ class PakPacker
     std::array<std::vector<aiVector3D>, 4> m_vertexBuffers;
     std::vector<uint32_t> m_indexBuffer;
     std::vector<Mesh> m_meshVector;
+    std::vector<sys::AssetId> m_meshIds;
+    std::vector<sys::AssetId> m_materialIds;
+    // Textures written by any scene so far, and the texture cooked for each decoded content
+    std::unordered_set<sys::AssetId> m_packedTextures;
+    std::unordered_map<uint64_t, sys::AssetId> m_textureContents;
+    std::unordered_map<sys::AssetId, sys::AssetId> m_textureAliases;
+
+    struct CellInfo
+    {
+        aiVector3D bbMin = aiVector3D(std::numeric_limits<float>::max());
+        aiVector3D bbMax = aiVector3D(std::numeric_limits<float>::lowest());
+        uint32_t firstInstance = 0;
+        uint32_t instanceCount = 0;
+        uint32_t firstMesh = 0;
+        uint32_t meshCount = 0;
+        std::set<uint64_t> textures;
+    };
+    std::vector<CellInfo> m_cells;
+    std::vector<BatchSource> m_batchSources;
+    std::unordered_map<sys::AssetId, AlbedoSample> m_albedoSamples;
+    std::vector<Impostor> m_impostors;
+    std::vector<ImpostorAtlas> m_impostorAtlases;
 
     uint32_t m_meshCount = 0;
     uint32_t m_materialCount = 0;
+    float m_cellSize = 0.f;
+    uint32_t m_virtualSize = 0;
+    float m_batchSize = 0.f;
+    uint32_t m_impostorVertices = 0;
+    uint32_t m_sourceMeshCount = 0;
+
+    static constexpr uint32_t kPageSize = 256;  // Texels per page side, borders included: a BC7 page is 64 KiB
+    static constexpr uint32_t kPageBorder = 4;  // One block on each side for filtering across pages
+    static constexpr uint64_t kPageStride = 64 * 1024;
+    static constexpr uint32_t kMaxBatchedVertices = 4096; // Larger meshes keep their own draw
+    static constexpr uint32_t kMaxBatchVertices = 65536;  // Per merged mesh, so that culling still pays off
+    static constexpr uint32_t kImpostorFrames = 8;     // Views per side of the octahedron
+    static constexpr uint32_t kImpostorFrameSize = 64; // Texels per view side
+    static constexpr uint32_t kImpostorMips = 4;       // Down to 8 texels per view, coarser mips blend the views
+    static constexpr uint32_t kAlbedoSampleSize = 256;
 
     static TextureFormat convertCMPFormat(CMP_FORMAT fmt);
     void exportTexture(const aiScene* aiScene, const fs::path& path, PackedTextureMetadata& metadata,
                        bool skipCompress);
+    // Rewrites meshes and their geometry in this order, instances and impostors follow their mesh
+    void reorderMeshes(std::span<const uint32_t> order);
+    void partitionCells();
+    void batchInstances();
+    Instance appendBatch(std::span<const uint32_t> members);
+    void moveBatchSources();
+    void bakeImpostors();
+    ImpostorAtlas bakeImpostor(const Mesh& mesh, const Material& material) const;
+    // Only cooked block-compressed textures are cut in pages, the others stay regular textures
+    [[nodiscard]] bool isPageable(const PackedTextureMetadata& tex) const;
+    static std::vector<char> cutPages(const PackedTextureMetadata& tex, const std::vector<char>& cooked,
+                                      std::vector<VirtualMip>& mips);
     void concatenateFilesWithAlignment(std::ofstream& outFile, flatbuffers::FlatBufferBuilder& builder,
                                        std::vector<flatbuffers::Offset<PakEntry>>& entries);
 };
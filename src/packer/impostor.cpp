@@ -0,0 +1,252 @@
+#include "importer.hpp"
+
+#include <xxhash.h>
+
+namespace ler::pak
+{
+static aiVector3D toAiVector(const Vec3& vec)
+{
+    return { vec.x(), vec.y(), vec.z() };
+}
+
+// Same mapping as octDecode in common.hlsli, +y is the top of the octahedron
+static aiVector3D octDecode(float u, float v)
+{
+    aiVector3D n(u, 1.f - std::abs(u) - std::abs(v), v);
+    if (n.y < 0.f)
+    {
+        n.x = (1.f - std::abs(v)) * (u >= 0.f ? 1.f : -1.f);
+        n.z = (1.f - std::abs(u)) * (v >= 0.f ? 1.f : -1.f);
+    }
+    return n.Normalize();
+}
+
+static float edge(const aiVector3D& a, const aiVector3D& b, float x, float y)
+{
+    return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+}
+
+// Averages 2x2 texels of both layers, weighted by the albedo coverage so that empty texels do not darken the edges
+static void downsample(const uint8_t* albedo, const uint8_t* normal, uint32_t size, uint8_t* outAlbedo,
+                       uint8_t* outNormal)
+{
+    const uint32_t half = size / 2;
+    for (uint32_t y = 0; y < half; ++y)
+    {
+        for (uint32_t x = 0; x < half; ++x)
+        {
+            std::array<float, 4> color = {};
+            std::array<float, 4> normalDepth = {};
+            float weight = 0.f;
+            for (uint32_t t = 0; t < 4; ++t)
+            {
+                const uint32_t src = ((y * 2 + t / 2) * size + x * 2 + t % 2) * 4;
+                const float w = albedo[src + 3] / 255.f;
+                for (uint32_t c = 0; c < 4; ++c)
+                {
+                    color[c] += (c < 3 ? w : 1.f) * albedo[src + c];
+                    normalDepth[c] += w * normal[src + c];
+                }
+                weight += w;
+            }
+
+            const uint32_t dst = (y * half + x) * 4;
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                const float average = c < 3 ? (weight > 0.f ? color[c] / weight : 0.f) : color[c] / 4.f;
+                outAlbedo[dst + c] = static_cast<uint8_t>(average);
+                outNormal[dst + c] = static_cast<uint8_t>(weight > 0.f ? normalDepth[c] / weight : 0.f);
+            }
+        }
+    }
+}
+
+ImpostorAtlas PakPacker::bakeImpostor(const Mesh& mesh, const Material& material) const
+{
+    constexpr uint32_t atlasSize = kImpostorFrames * kImpostorFrameSize;
+    std::vector<uint8_t> albedo(atlasSize * atlasSize * 4, 0);
+    std::vector<uint8_t> normal(atlasSize * atlasSize * 4, 0);
+
+    const aiVector3D bbMin = toAiVector(mesh.bbmin());
+    const aiVector3D bbMax = toAiVector(mesh.bbmax());
+    const aiVector3D center = (bbMin + bbMax) * 0.5f;
+    const float radius = (bbMax - bbMin).Length() * 0.5f;
+
+    const AlbedoSample* sample = nullptr;
+    if (const auto it = m_albedoSamples.find(material.texture()->Get(1)); it != m_albedoSamples.end())
+        sample = &it->second;
+    const aiVector3D baseColor = toAiVector(material.base_color());
+    const bool alphaTest = material.alpha_mode() != AlphaMode_Opaque;
+
+    // Orthographic views from the center of each frame, rasterized without culling
+    std::vector<float> depths(kImpostorFrameSize * kImpostorFrameSize);
+    for (uint32_t fy = 0; fy < kImpostorFrames; ++fy)
+    {
+        for (uint32_t fx = 0; fx < kImpostorFrames; ++fx)
+        {
+            const aiVector3D dir = octDecode((fx + 0.5f) / kImpostorFrames * 2.f - 1.f,
+                                             (fy + 0.5f) / kImpostorFrames * 2.f - 1.f);
+            const aiVector3D up0 = std::abs(dir.y) > 0.99f ? aiVector3D(0.f, 0.f, 1.f) : aiVector3D(0.f, 1.f, 0.f);
+            const aiVector3D right = (up0 ^ dir).Normalize();
+            const aiVector3D up = dir ^ right;
+            const auto project = [&](const aiVector3D& p) {
+                const aiVector3D d = (p - center) / radius;
+                return aiVector3D((d * right * 0.5f + 0.5f) * kImpostorFrameSize,
+                                  (0.5f - d * up * 0.5f) * kImpostorFrameSize, d * dir);
+            };
+
+            std::ranges::fill(depths, std::numeric_limits<float>::lowest());
+            for (uint32_t i = 0; i + 2 < mesh.count_index(); i += 3)
+            {
+                std::array<uint32_t, 3> v;
+                std::array<aiVector3D, 3> s;
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    v[k] = mesh.first_vertex() + m_indexBuffer[mesh.first_index() + i + k];
+                    s[k] = project(m_vertexBuffers[0][v[k]]);
+                }
+                const float area = edge(s[0], s[1], s[2].x, s[2].y);
+                if (std::abs(area) < 1e-8f)
+                    continue;
+
+                const auto clampPixel = [](float value) {
+                    return static_cast<uint32_t>(std::clamp(value, 0.f, float(kImpostorFrameSize - 1)));
+                };
+                const uint32_t x0 = clampPixel(std::floor(std::min({ s[0].x, s[1].x, s[2].x })));
+                const uint32_t x1 = clampPixel(std::ceil(std::max({ s[0].x, s[1].x, s[2].x })));
+                const uint32_t y0 = clampPixel(std::floor(std::min({ s[0].y, s[1].y, s[2].y })));
+                const uint32_t y1 = clampPixel(std::ceil(std::max({ s[0].y, s[1].y, s[2].y })));
+                for (uint32_t y = y0; y <= y1; ++y)
+                {
+                    for (uint32_t x = x0; x <= x1; ++x)
+                    {
+                        const float w0 = edge(s[1], s[2], x + 0.5f, y + 0.5f) / area;
+                        const float w1 = edge(s[2], s[0], x + 0.5f, y + 0.5f) / area;
+                        const float w2 = 1.f - w0 - w1;
+                        const float depth = w0 * s[0].z + w1 * s[1].z + w2 * s[2].z;
+                        float& stored = depths[y * kImpostorFrameSize + x];
+                        if (w0 < 0.f || w1 < 0.f || w2 < 0.f || depth <= stored)
+                            continue;
+
+                        aiVector3D color = baseColor;
+                        if (sample != nullptr)
+                        {
+                            const aiVector3D uv = m_vertexBuffers[1][v[0]] * w0 + m_vertexBuffers[1][v[1]] * w1 +
+                                                  m_vertexBuffers[1][v[2]] * w2;
+                            const auto wrap = [](float t, uint32_t n) {
+                                const auto index = static_cast<int64_t>(std::floor(t * static_cast<float>(n)));
+                                return static_cast<uint32_t>((index % n + n) % n);
+                            };
+                            const uint8_t* texel =
+                                &sample->texels[(wrap(uv.y, sample->height) * sample->width +
+                                                 wrap(uv.x, sample->width)) * 4];
+                            if (alphaTest && texel[3] < material.alpha_cut_off() * 255.f)
+                                continue;
+                            color = aiVector3D(color.x * texel[0], color.y * texel[1], color.z * texel[2]) / 255.f;
+                        }
+
+                        aiVector3D n = m_vertexBuffers[2][v[0]] * w0 + m_vertexBuffers[2][v[1]] * w1 +
+                                       m_vertexBuffers[2][v[2]] * w2;
+                        n.NormalizeSafe();
+                        stored = depth;
+
+                        const uint32_t row = fy * kImpostorFrameSize + y;
+                        const uint32_t dst = (row * atlasSize + fx * kImpostorFrameSize + x) * 4;
+                        albedo[dst + 0] = static_cast<uint8_t>(std::clamp(color.x, 0.f, 1.f) * 255.f);
+                        albedo[dst + 1] = static_cast<uint8_t>(std::clamp(color.y, 0.f, 1.f) * 255.f);
+                        albedo[dst + 2] = static_cast<uint8_t>(std::clamp(color.z, 0.f, 1.f) * 255.f);
+                        albedo[dst + 3] = 255;
+                        normal[dst + 0] = static_cast<uint8_t>((n.x * 0.5f + 0.5f) * 255.f);
+                        normal[dst + 1] = static_cast<uint8_t>((n.y * 0.5f + 0.5f) * 255.f);
+                        normal[dst + 2] = static_cast<uint8_t>((n.z * 0.5f + 0.5f) * 255.f);
+                        normal[dst + 3] = static_cast<uint8_t>(std::clamp(depth * 0.5f + 0.5f, 0.f, 1.f) * 255.f);
+                    }
+                }
+            }
+        }
+    }
+
+    // Layer-major like every texture array, rows are already 256 bytes aligned
+    ImpostorAtlas atlas;
+    std::array<std::vector<uint8_t>, 2> levels = { std::move(albedo), std::move(normal) };
+    std::array<std::vector<char>, 2> layers;
+    std::array<std::vector<CopyFootprint>, 2> footprints;
+    for (uint32_t mip = 0, size = atlasSize; mip < kImpostorMips; ++mip, size /= 2)
+    {
+        for (uint32_t l = 0; l < 2; ++l)
+        {
+            footprints[l].emplace_back(layers[l].size(), size, size, size);
+            layers[l].insert(layers[l].end(), levels[l].begin(), levels[l].begin() + size * size * 4);
+        }
+
+        if (mip + 1 < kImpostorMips)
+        {
+            std::array<std::vector<uint8_t>, 2> next;
+            next[0].resize(size * size);
+            next[1].resize(size * size);
+            downsample(levels[0].data(), levels[1].data(), size, next[0].data(), next[1].data());
+            levels = std::move(next);
+        }
+    }
+
+    for (uint32_t l = 0; l < 2; ++l)
+    {
+        const uint64_t base = atlas.content.size();
+        atlas.content.insert(atlas.content.end(), layers[l].begin(), layers[l].end());
+        for (const CopyFootprint& fp : footprints[l])
+            atlas.footprints.emplace_back(base + fp.buffer_offset(), fp.row_length(), fp.width(), fp.height());
+    }
+    return atlas;
+}
+
+void PakPacker::bakeImpostors()
+{
+    // The first instance of a mesh gives the material of its impostor
+    std::vector<uint32_t> skins(m_meshVector.size(), UINT32_MAX);
+    for (const Instance& inst : m_instanceVector)
+    {
+        if (skins[inst.mesh_id()] == UINT32_MAX)
+            skins[inst.mesh_id()] = inst.skin_id();
+    }
+
+    const auto quadId = static_cast<uint32_t>(m_meshVector.size());
+    for (uint32_t id = 0; id < quadId; ++id)
+    {
+        const Mesh& mesh = m_meshVector[id];
+        if (skins[id] == UINT32_MAX || mesh.count_vertex() < m_impostorVertices)
+            continue;
+        if (toAiVector(mesh.bbmax()) == toAiVector(mesh.bbmin()))
+            continue;
+
+        ImpostorAtlas atlas = bakeImpostor(mesh, m_materialVector[skins[id]]);
+        const std::array<sys::AssetId, 2> key = { m_meshIds[id], m_materialIds[skins[id]] };
+        atlas.id = XXH3_64bits(key.data(), sizeof(key));
+        m_impostors.emplace_back(id, quadId, atlas.id, static_cast<uint16_t>(kImpostorFrames));
+        m_impostorAtlases.emplace_back(std::move(atlas));
+    }
+
+    if (m_impostors.empty())
+        return;
+
+    // Unit quad shared by every impostor, both faces so that no cull mode hides it
+    static constexpr std::array<float, 8> kCorners = { -1.f, -1.f, 1.f, -1.f, 1.f, 1.f, -1.f, 1.f };
+    static constexpr std::array<uint32_t, 12> kQuadIndices = { 0, 1, 2, 0, 2, 3, 0, 2, 1, 0, 3, 2 };
+    const auto firstIndex = static_cast<uint32_t>(m_indexBuffer.size());
+    const auto firstVertex = static_cast<uint32_t>(m_vertexBuffers[0].size());
+    m_indexBuffer.insert(m_indexBuffer.end(), kQuadIndices.begin(), kQuadIndices.end());
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+        const float x = kCorners[c * 2];
+        const float y = kCorners[c * 2 + 1];
+        m_vertexBuffers[0].emplace_back(x, y, 0.f);
+        m_vertexBuffers[1].emplace_back(x * 0.5f + 0.5f, 0.5f - y * 0.5f, 0.f);
+        m_vertexBuffers[2].emplace_back(0.f, 0.f, 1.f);
+        m_vertexBuffers[3].emplace_back(1.f, 0.f, 0.f);
+    }
+    m_meshVector.emplace_back(static_cast<uint32_t>(kQuadIndices.size()), firstIndex,
+                              static_cast<int32_t>(firstVertex), 4u, Vec3(-1.f, -1.f, 0.f), Vec3(1.f, 1.f, 0.f));
+    m_meshIds.emplace_back(sys::makeAssetId("impostor_quad"));
+
+    log::info("Baked {} impostors of {}x{} views", m_impostors.size(), kImpostorFrames, kImpostorFrames);
+}
+} // namespace ler::pak
@@ -47,6 +47,26 @@ int main(int argc, char* argv[])
         .help("output pak file");
 
     program.add_argument("--cook").default_value(true).implicit_value(false).help("compress textures");
+    program.add_argument("--cell-size")
+        .default_value(0.f)
+        .scan<'g', float>()
+        .metavar("METERS")
+        .help("partition the scene in streamed cells, 0 keeps it in one block");
+    program.add_argument("--virtual-size")
+        .default_value(0)
+        .scan<'i', int>()
+        .metavar("TEXELS")
+        .help("stream textures larger than this page by page, 0 loads every texture whole");
+    program.add_argument("--static-batch")
+        .default_value(0.f)
+        .scan<'g', float>()
+        .metavar("METERS")
+        .help("merge small instances sharing a material within cells of this size, 0 draws each one");
+    program.add_argument("--impostors")
+        .default_value(0)
+        .scan<'i', int>()
+        .metavar("VERTICES")
+        .help("bake octahedral impostors for meshes of at least this many vertices, 0 bakes none");
 
     try
     {
@@ -118,6 +138,10 @@ int main(int argc, char* argv[])
         log::info("Enqueue scene: {}", path.string());
 
     pak::PakPacker packer(outPath);
+    packer.setCellSize(program.get<float>("--cell-size"));
+    packer.setBatchSize(program.get<float>("--static-batch"));
+    packer.setImpostorVertices(static_cast<uint32_t>(std::max(program.get<int>("--impostors"), 0)));
+    packer.setVirtualTextureSize(static_cast<uint32_t>(std::max(program.get<int>("--virtual-size"), 0)));
 
     auto* progress = new AssimpProgress;
     Assimp::Importer importer;
@@ -155,7 +155,7 @@ void PakPacker::processMaterial(const aiScene* aiScene)
                 }
 
                 const std::string& stem = m_textureMap[filename.C_Str()].filename;
-                mapColor[mapping.index] = XXH3_64bits(stem.c_str(), stem.size());
+                mapColor[mapping.index] = sys::makeAssetId(stem);
             }
         }
 
@@ -168,4 +168,42 @@ void PakPacker::processMaterial(const aiScene* aiScene)
         textures.clear();
     }
 }
+
+void PakPacker::deduplicateMaterials()
+{
+    std::vector<Material> materials;
+    std::vector<uint32_t> remap(m_materialVector.size());
+    std::unordered_map<sys::AssetId, uint32_t> unique;
+    m_materialIds.clear();
+    for (uint32_t i = 0; i < m_materialVector.size(); ++i)
+    {
+        const Material& m = m_materialVector[i];
+        std::array<uint64_t, 6> mapColor = {};
+        for (uint32_t t = 0; t < mapColor.size(); ++t)
+        {
+            const auto alias = m_textureAliases.find(m.texture()->Get(t));
+            mapColor[t] = alias == m_textureAliases.end() ? m.texture()->Get(t) : alias->second;
+        }
+
+        // The parameter block is the ID, identical materials of any scene share one entry
+        const Material material(m.shading(), m.alpha_mode(), m.alpha_cut_off(), m.base_color(), m.emissive_color(),
+                                m.metallic_factor(), m.roughness_factor(), m.opacity(), mapColor);
+        const sys::AssetId id = XXH3_64bits(&material, sizeof(Material));
+        const auto [it, inserted] = unique.try_emplace(id, static_cast<uint32_t>(materials.size()));
+        if (inserted)
+        {
+            materials.emplace_back(material);
+            m_materialIds.emplace_back(id);
+        }
+        remap[i] = it->second;
+    }
+
+    for (Instance& inst : m_instanceVector)
+        inst = Instance(inst.mesh_id(), remap[inst.skin_id()],
+                        flatbuffers::span<const float, 16>(inst.transform()->data(), 16));
+
+    log::info("Materials: {} unique of {}, {} duplicated textures", materials.size(), m_materialVector.size(),
+              m_textureAliases.size());
+    m_materialVector = std::move(materials);
+}
 } // namespace ler::pak
\ No newline at end of file
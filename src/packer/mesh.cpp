@@ -5,6 +5,7 @@
 #include "importer.hpp"
 
 #include <meshoptimizer.h>
+#include <xxhash.h>
 
 namespace ler::pak
 {
@@ -68,6 +69,14 @@ void PakPacker::processMeshes(const aiScene* aiScene)
 
             m_vertexBuffers[n].insert(m_vertexBuffers[n].end(), vertices.begin(), vertices.end());
         }
+
+        // Derived from the optimized geometry, repacking the same source keeps the ID
+        XXH3_state_t state;
+        XXH3_64bits_reset(&state);
+        XXH3_64bits_update(&state, indices.data(), indices.size() * sizeof(uint32_t));
+        XXH3_64bits_update(&state, m_vertexBuffers[0].data() + m_vertexBuffers[0].size() - vertices.size(),
+                           vertices.size() * sizeof(aiVector3D));
+        m_meshIds.emplace_back(XXH3_64bits_digest(&state));
     }
 }
 
@@ -95,4 +104,40 @@ void PakPacker::processSceneNode(aiNode* aiNode, aiMesh** meshes)
     for (size_t i = 0; i < aiNode->mNumChildren; ++i)
         processSceneNode(aiNode->mChildren[i], meshes);
 }
+
+void PakPacker::reorderMeshes(std::span<const uint32_t> order)
+{
+    std::vector<Mesh> meshes;
+    std::vector<sys::AssetId> meshIds;
+    std::vector<uint32_t> indices;
+    std::array<std::vector<aiVector3D>, 4> vertices;
+    std::vector<uint32_t> remap(m_meshVector.size());
+    for (uint32_t id : order)
+    {
+        const Mesh& mesh = m_meshVector[id];
+        remap[id] = static_cast<uint32_t>(meshes.size());
+        meshes.emplace_back(mesh.count_index(), uint32_t(indices.size()), int32_t(vertices[0].size()),
+                            mesh.count_vertex(), mesh.bbmin(), mesh.bbmax());
+        meshIds.emplace_back(m_meshIds[id]);
+        const auto firstIndex = m_indexBuffer.begin() + mesh.first_index();
+        indices.insert(indices.end(), firstIndex, firstIndex + mesh.count_index());
+        for (size_t n = 0; n < vertices.size(); ++n)
+        {
+            const auto firstVertex = m_vertexBuffers[n].begin() + mesh.first_vertex();
+            vertices[n].insert(vertices[n].end(), firstVertex, firstVertex + mesh.count_vertex());
+        }
+    }
+
+    for (Instance& inst : m_instanceVector)
+        inst = Instance(remap[inst.mesh_id()], inst.skin_id(),
+                        flatbuffers::span<const float, 16>(inst.transform()->data(), 16));
+    for (Impostor& impostor : m_impostors)
+        impostor = Impostor(remap[impostor.mesh_id()], remap[impostor.quad_id()], impostor.texture_id(),
+                            impostor.frames());
+
+    m_meshVector = std::move(meshes);
+    m_meshIds = std::move(meshIds);
+    m_indexBuffer = std::move(indices);
+    m_vertexBuffers = std::move(vertices);
+}
 } // namespace ler::pak
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include "importer.hpp"
+
+#include <map>
+#include <numeric>
+
+namespace ler::pak
+{
+static constexpr uint32_t kUnused = UINT32_MAX;
+static constexpr uint32_t kResident = UINT32_MAX - 1;
+
+static aiVector3D toAiVector(const Vec3& vec)
+{
+    return { vec.x(), vec.y(), vec.z() };
+}
+
+void PakPacker::partitionCells()
+{
+    using CellKey = std::pair<int32_t, int32_t>;
+
+    // Instances are binned on the XZ grid by the center of their world bounds
+    std::vector<CellKey> instanceKeys;
+    std::vector<std::pair<aiVector3D, aiVector3D>> instanceBounds;
+    std::map<CellKey, uint32_t> grid;
+    for (const Instance& inst : m_instanceVector)
+    {
+        const Mesh& mesh = m_meshVector[inst.mesh_id()];
+        aiMatrix4x4 model;
+        std::memcpy(&model, inst.transform()->data(), sizeof(aiMatrix4x4));
+        model.Transpose();
+
+        const aiVector3D bbMin = toAiVector(mesh.bbmin());
+        const aiVector3D bbMax = toAiVector(mesh.bbmax());
+        aiVector3D worldMin(std::numeric_limits<float>::max());
+        aiVector3D worldMax(std::numeric_limits<float>::lowest());
+        for (uint32_t corner = 0; corner < 8; ++corner)
+        {
+            const aiVector3D p = model * aiVector3D(corner & 1 ? bbMax.x : bbMin.x, corner & 2 ? bbMax.y : bbMin.y,
+                                                    corner & 4 ? bbMax.z : bbMin.z);
+            worldMin = aiVector3D(std::min(worldMin.x, p.x), std::min(worldMin.y, p.y), std::min(worldMin.z, p.z));
+            worldMax = aiVector3D(std::max(worldMax.x, p.x), std::max(worldMax.y, p.y), std::max(worldMax.z, p.z));
+        }
+
+        const aiVector3D center = (worldMin + worldMax) * 0.5f;
+        const CellKey key(static_cast<int32_t>(std::floor(center.x / m_cellSize)),
+                          static_cast<int32_t>(std::floor(center.z / m_cellSize)));
+        instanceKeys.emplace_back(key);
+        instanceBounds.emplace_back(worldMin, worldMax);
+        grid.emplace(key, 0);
+    }
+
+    uint32_t cellCount = 0;
+    for (uint32_t& index : std::views::values(grid))
+        index = cellCount++;
+    m_cells.assign(cellCount, CellInfo());
+
+    // Meshes drawn from a single cell travel with it, shared ones and the impostor quad stay resident.
+    // Meshes left unused are only referenced by batch sources and go after every cell.
+    std::vector<uint32_t> meshCells(m_meshVector.size(), kUnused);
+    for (size_t i = 0; i < m_instanceVector.size(); ++i)
+    {
+        const uint32_t cell = grid.at(instanceKeys[i]);
+        uint32_t& owner = meshCells[m_instanceVector[i].mesh_id()];
+        owner = owner == kUnused || owner == cell ? cell : kResident;
+    }
+    for (const Impostor& impostor : m_impostors)
+        meshCells[impostor.quad_id()] = kResident;
+
+    // Rewrite geometry so that each cell owns a contiguous run of meshes
+    std::vector<uint32_t> meshOrder;
+    meshOrder.reserve(m_meshVector.size());
+    const auto appendMeshes = [&](uint32_t owner) {
+        for (uint32_t id = 0; id < meshCells.size(); ++id)
+        {
+            if (meshCells[id] == owner)
+                meshOrder.emplace_back(id);
+        }
+    };
+
+    appendMeshes(kResident);
+    const auto residentCount = static_cast<uint32_t>(meshOrder.size());
+    for (uint32_t cell = 0; cell < cellCount; ++cell)
+    {
+        m_cells[cell].firstMesh = static_cast<uint32_t>(meshOrder.size());
+        appendMeshes(cell);
+        m_cells[cell].meshCount = static_cast<uint32_t>(meshOrder.size()) - m_cells[cell].firstMesh;
+    }
+    const auto cellMeshCount = static_cast<uint32_t>(meshOrder.size());
+    appendMeshes(kUnused);
+    m_sourceMeshCount = static_cast<uint32_t>(meshOrder.size()) - cellMeshCount;
+    reorderMeshes(meshOrder);
+
+    // Instances sorted by cell, each cell reads one contiguous range
+    std::vector<uint32_t> order(m_instanceVector.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::ranges::stable_sort(order, {}, [&](uint32_t i) { return grid.at(instanceKeys[i]); });
+
+    std::vector<Instance> instances;
+    instances.reserve(order.size());
+    for (uint32_t i : order)
+    {
+        const Instance& inst = m_instanceVector[i];
+        CellInfo& cell = m_cells[grid.at(instanceKeys[i])];
+        if (cell.instanceCount++ == 0)
+            cell.firstInstance = static_cast<uint32_t>(instances.size());
+
+        const auto& [worldMin, worldMax] = instanceBounds[i];
+        cell.bbMin = aiVector3D(std::min(cell.bbMin.x, worldMin.x), std::min(cell.bbMin.y, worldMin.y),
+                                std::min(cell.bbMin.z, worldMin.z));
+        cell.bbMax = aiVector3D(std::max(cell.bbMax.x, worldMax.x), std::max(cell.bbMax.y, worldMax.y),
+                                std::max(cell.bbMax.z, worldMax.z));
+
+        const Material& material = m_materialVector[inst.skin_id()];
+        for (uint64_t texture : *material.texture())
+        {
+            if (texture != 0)
+                cell.textures.insert(texture);
+        }
+
+        instances.emplace_back(inst);
+    }
+    m_instanceVector = std::move(instances);
+
+    log::info("Partitioned {} instances in {} cells of {}m, {} resident meshes, {} batch source meshes",
+              m_instanceVector.size(), cellCount, m_cellSize, residentCount, m_sourceMeshCount);
+}
+} // namespace ler::pak
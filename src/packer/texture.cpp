@@ -51,6 +51,26 @@ void CMP_LoadTexture(const aiTexture* texture, MipSet* mipSet)
     stbi_image_free(image);
 }
 
+// Point sampled copy of the top mip, impostors are far too small to need more
+static AlbedoSample sampleAlbedo(const MipSet& mipSet, uint32_t maxSize)
+{
+    AlbedoSample sample;
+    sample.width = std::min<uint32_t>(mipSet.m_nWidth, maxSize);
+    sample.height = std::min<uint32_t>(mipSet.m_nHeight, maxSize);
+    sample.texels.resize(sample.width * sample.height * 4);
+    const auto* src = reinterpret_cast<const uint8_t*>(mipSet.pData);
+    for (uint32_t y = 0; y < sample.height; ++y)
+    {
+        const uint32_t sy = y * mipSet.m_nHeight / sample.height;
+        for (uint32_t x = 0; x < sample.width; ++x)
+        {
+            const uint32_t sx = x * mipSet.m_nWidth / sample.width;
+            std::memcpy(&sample.texels[(y * sample.width + x) * 4], src + (sy * mipSet.m_nWidth + sx) * 4, 4);
+        }
+    }
+    return sample;
+}
+
 static constexpr std::string_view CMPErrorToString(CMP_ERROR error)
 {
     switch (error)
@@ -232,6 +252,18 @@ static void CMP_SavePaddedRawData(PackedTextureMetadata& metadata, const fs::pat
 
     metadata.totalBytes = totalBytes;
 
+    metadata.footprints.clear();
+    for (int i = 0; i < mipSet.m_nMipLevels; ++i)
+    {
+        const uint32_t w = std::max(1, mipSet.m_nWidth >> i);
+        const uint32_t h = std::max(1, mipSet.m_nHeight >> i);
+        computePitch(mipSet.m_format, w, h, rowPitch, slicePitch);
+        // Padded row pitch expressed in texels (4 per block)
+        const size_t blockBytes = rowPitch / std::max<size_t>(1, (w + 3) / 4);
+        const auto rowLength = static_cast<uint32_t>(align(rowPitch, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT) / blockBytes * 4);
+        metadata.footprints.emplace_back(offset[i], rowLength, w, h);
+    }
+
     currentOffset = 0;
     CMP_GetMipLevel(&mip, &mipSet, 0, 0);
     std::vector<std::byte> copyableFootprints(totalBytes);
@@ -302,6 +334,25 @@ void PakPacker::exportTexture(const aiScene* aiScene, const fs::path& path, Pack
         }
     }
 
+    // Decoded texels and target format, the same image under another name is cooked once
+    XXH3_state_t state;
+    XXH3_64bits_reset(&state);
+    XXH3_64bits_update(&state, &metadata.format, sizeof(CMP_FORMAT));
+    XXH3_64bits_update(&state, mipSetIn.pData, mipSetIn.dwDataSize);
+    const sys::AssetId id = sys::makeAssetId(metadata.filename);
+    const auto [content, inserted] = m_textureContents.try_emplace(XXH3_64bits_digest(&state), id);
+    if (!inserted)
+    {
+        if (content->second != id)
+            m_textureAliases[id] = content->second;
+        log::info("Duplicate texture: {}", path.string());
+        CMP_FreeMipSet(&mipSetIn);
+        return;
+    }
+
+    if (m_impostorVertices > 0 && mipSetIn.m_format == CMP_FORMAT_RGBA_8888 && mipSetIn.pData != nullptr)
+        m_albedoSamples.emplace(id, sampleAlbedo(mipSetIn, kAlbedoSampleSize));
+
     pathOut.replace_extension(".gpu");
     pathOut = pathOut.make_preferred();
 
@@ -385,6 +436,8 @@ void PakPacker::processTextures(const aiScene* aiScene, bool cook)
     int num = 1;
     for (auto& [filename, metadata] : m_textureMap)
     {
+        if (m_packedTextures.contains(sys::makeAssetId(metadata.filename)))
+            continue;
         log::info("[Packer] Processing {}/{}: {}", num, m_textureMap.size(), metadata.filename);
         exportTexture(aiScene, filename, metadata, cook);
         num++;
@@ -0,0 +1,82 @@
+#include "importer.hpp"
+
+namespace ler::pak
+{
+static constexpr uint32_t kBlockSize = 4; // BC formats encode 4x4 texels per block
+
+// 0 for formats that are not 4x4 blocks, they are never paged
+static uint32_t blockBytes(CMP_FORMAT format)
+{
+    switch (format)
+    {
+    case CMP_FORMAT_BC1:
+    case CMP_FORMAT_BC4:
+    case CMP_FORMAT_BC4_S:
+        return 8;
+    case CMP_FORMAT_BC2:
+    case CMP_FORMAT_BC3:
+    case CMP_FORMAT_BC5:
+    case CMP_FORMAT_BC5_S:
+    case CMP_FORMAT_BC6H:
+    case CMP_FORMAT_BC6H_SF:
+    case CMP_FORMAT_BC7:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+bool PakPacker::isPageable(const PackedTextureMetadata& tex) const
+{
+    return m_virtualSize > 0 && std::max(tex.width, tex.height) > m_virtualSize && !tex.footprints.empty() &&
+           blockBytes(tex.format) > 0;
+}
+
+std::vector<char> PakPacker::cutPages(const PackedTextureMetadata& tex, const std::vector<char>& cooked,
+                                      std::vector<VirtualMip>& mips)
+{
+    // Blocks are copied as is, pages never get re-encoded
+    constexpr uint32_t payload = kPageSize - 2 * kPageBorder;
+    constexpr uint32_t pageBlocks = kPageSize / kBlockSize;
+    constexpr uint32_t borderBlocks = kPageBorder / kBlockSize;
+    const uint32_t blockSize = blockBytes(tex.format);
+    assert(blockSize > 0);
+
+    std::vector<char> pages;
+    uint32_t pageCount = 0;
+    for (const CopyFootprint& fp : tex.footprints)
+    {
+        const uint32_t pagesX = (fp.width() + payload - 1) / payload;
+        const uint32_t pagesY = (fp.height() + payload - 1) / payload;
+        mips.emplace_back(pagesX, pagesY, pageCount);
+
+        const uint32_t blocksX = (fp.width() + kBlockSize - 1) / kBlockSize;
+        const uint32_t blocksY = (fp.height() + kBlockSize - 1) / kBlockSize;
+        const uint64_t rowBytes = fp.row_length() / kBlockSize * blockSize;
+        pages.resize((pageCount + pagesX * pagesY) * kPageStride);
+        for (uint32_t py = 0; py < pagesY; ++py)
+        {
+            for (uint32_t px = 0; px < pagesX; ++px)
+            {
+                // Borders wrap around like the sampler of material textures
+                char* page = pages.data() + pageCount++ * kPageStride;
+                for (uint32_t by = 0; by < pageBlocks; ++by)
+                {
+                    const uint32_t sy = (py * payload / kBlockSize + by + blocksY - borderBlocks) % blocksY;
+                    for (uint32_t bx = 0; bx < pageBlocks; ++bx)
+                    {
+                        const uint32_t sx = (px * payload / kBlockSize + bx + blocksX - borderBlocks) % blocksX;
+                        std::memcpy(page + (by * pageBlocks + bx) * blockSize,
+                                    cooked.data() + fp.buffer_offset() + sy * rowBytes + sx * blockSize, blockSize);
+                    }
+                }
+            }
+        }
+
+        // Coarser mips are never paged, the runtime keeps this one resident
+        if (pagesX == 1 && pagesY == 1)
+            break;
+    }
+    return pages;
+}
+} // namespace ler::pak
@@ -112,7 +112,7 @@ class DeferredScene final : public rhi::IRenderPass, public render::IMeshRendere
 
         desc.stride = sizeof(render::DrawCommand);
         desc.debugName = "drawBuffer";
-        desc.sizeInBytes = desc.stride * m_params.meshList->getInstanceCount();
+        desc.sizeInBytes = desc.stride * m_params.meshList->getInstanceCapacity();
         m_drawBuffer = device->createBuffer(desc);
 
         desc.isUAV = false;
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <limits>
 
 namespace ler::render
 {
@@ -15,6 +16,9 @@ struct alignas(16) DrawConstant
     glm::uint drawIndex = 0;
     glm::uint instIndex = 0;
     glm::uint matIndex = 0;
+    glm::uint virtualIndex = 0; // DrawVirtualTexture buffer
+    glm::uint meshIndex = 0;    // DrawMesh buffer, impostors are shaped from the bounds of their mesh
+    glm::uint pad[3] = {};
 };
 
 struct alignas(16) Frustum
@@ -22,6 +26,9 @@ struct alignas(16) Frustum
     glm::vec4 planes[6];
     glm::vec4 corners[8];
     glm::uint num = 0;
+    glm::uint pad[3] = {};
+    // w: distance beyond which meshes with an impostor draw it instead, never by default
+    glm::vec4 eye = glm::vec4(0.f, 0.f, 0.f, std::numeric_limits<float>::max());
 };
 
 struct alignas(16) DrawMesh
@@ -32,15 +39,41 @@ struct alignas(16) DrawMesh
     glm::uint firstIndex = 0u;
     glm::int32 firstVertex = 0u;
     glm::uint countVertex = 0u;
+    // Octahedral views baked around the center of the bounds, see pak::Impostor
+    glm::uint impostorMesh = kNoImpostor;
+    glm::uint impostorTexture = kNoImpostor; // Texture2DArray, set once it landed
+    glm::uint impostorFrames = 0u;
+    glm::uint pad = 0u;
+
+    static constexpr glm::uint kNoImpostor = ~0u;
 };
 
 struct alignas(16) DrawSkin
 {
     // x = diffuse index, y = roughness index, z = normal index, w = occlusion index.
     glm::uvec4 textures = glm::uvec4(0.f);
+    // Layer in the texture array bound at the same index, kNoLayer for plain 2D textures,
+    // kVirtual when the index is the one of a DrawVirtualTexture
+    glm::uvec4 layers = glm::uvec4(kNoLayer);
     glm::uint alphaMode = 0;
     glm::vec3 baseColor = glm::vec3(1.f);
     float alphaCutOff = 0.5f;
+
+    static constexpr glm::uint kNoLayer = ~0u;
+    static constexpr glm::uint kVirtual = ~0u - 1;
+};
+
+// Texture sampled through the page cache, see VirtualTextureCache
+struct alignas(16) DrawVirtualTexture
+{
+    glm::uint firstEntry = 0u; // in the indirection buffer, mip-major then row-major pages
+    glm::uint width = 0u;
+    glm::uint height = 0u;
+    glm::uint mipCount = 0u;
+    glm::uint cache = 0u; // bindless index of the physical page texture
+    glm::uint indirection = 0u;
+    glm::uint feedback = 0u;
+    glm::uint pad = 0u;
 };
 
 struct alignas(16) DrawInstance
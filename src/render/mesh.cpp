@@ -3,111 +3,307 @@
 //
 
 #include "mesh.hpp"
+#include "virtual_texture.hpp"
 
 namespace ler::render
 {
-void MeshBuffers::allocate(const rhi::DevicePtr& device, uint64_t indexSize, uint64_t vertexSize)
+void MeshTable::resize(size_t count)
 {
-    rhi::BufferDesc desc;
-    desc.isIndexBuffer = true;
-    desc.sizeInBytes = indexSize;
-    desc.debugName = "IndexBuffer";
-    m_indexBuffer = device->createBuffer(desc);
-
-    desc.sizeInBytes = vertexSize;
-    desc.isIndexBuffer = false;
-    desc.isVertexBuffer = true;
-    for (int i = 0; i < m_vertexBuffers.size(); ++i)
+    countIndex.resize(count);
+    firstIndex.resize(count);
+    countVertex.resize(count);
+    firstVertex.resize(count);
+    bbMin.resize(count);
+    bbMax.resize(count);
+}
+
+IndexedMesh MeshTable::get(uint32_t id) const
+{
+    return { countIndex[id], firstIndex[id], countVertex[id], firstVertex[id], bbMin[id], bbMax[id] };
+}
+
+void MeshBuffers::DirtySpan::add(uint32_t begin, uint32_t count)
+{
+    if (count == 0)
+        return;
+    first = std::min(first, begin);
+    last = std::max(last, begin + count);
+}
+
+// Doubles the allocator when the request does not fit, the tail block is then always large enough
+static void extendHeap(sys::VariableSizeAllocator& heap, uint64_t count)
+{
+    if (count > 0 && heap.getLargestFreeBlock() < count)
+        heap.extend(std::max<uint64_t>(count, heap.getMaxSize()));
+}
+
+static uint64_t allocateRange(sys::VariableSizeAllocator& heap, uint64_t count)
+{
+    if (count == 0)
+        return 0;
+    const uint64_t offset = heap.allocate(count);
+    assert(offset != sys::VariableSizeAllocator::InvalidOffset);
+    return offset;
+}
+
+GeometryRange MeshBuffers::allocate(const rhi::DevicePtr& device, uint64_t indexCount, uint64_t vertexCount,
+                                    uint32_t meshCount, uint32_t skinCount)
+{
+    assert(fits(indexCount, vertexCount));
+    extendHeap(m_meshIds, meshCount);
+    extendHeap(m_skinIds, skinCount);
+
+    GeometryRange range;
+    range.indexCount = indexCount;
+    range.vertexCount = vertexCount;
+    range.meshCount = meshCount;
+    range.skinCount = skinCount;
+    range.firstIndex = allocateRange(m_indexHeap, indexCount);
+    range.firstVertex = allocateRange(m_vertexHeap, vertexCount);
+    range.firstMesh = static_cast<uint32_t>(allocateRange(m_meshIds, meshCount));
+    range.firstSkin = static_cast<uint32_t>(allocateRange(m_skinIds, skinCount));
+
+    m_meshTable.resize(m_meshIds.getMaxSize());
+    m_drawMeshes.resize(m_meshIds.getMaxSize());
+    m_drawSkins.resize(m_skinIds.getMaxSize());
+    resizeTables(device);
+    return range;
+}
+
+void MeshBuffers::release(const GeometryRange& range)
+{
+    if (range.indexCount > 0)
+        m_indexHeap.free(range.firstIndex, range.indexCount);
+    if (range.vertexCount > 0)
+        m_vertexHeap.free(range.firstVertex, range.vertexCount);
+    if (range.meshCount > 0)
+        m_meshIds.free(range.firstMesh, range.meshCount);
+    if (range.skinCount > 0)
+        m_skinIds.free(range.firstSkin, range.skinCount);
+
+    for (uint32_t id = range.firstMesh; id < range.firstMesh + range.meshCount; ++id)
     {
-        desc.debugName = kNames[i];
-        m_vertexBuffers[i] = device->createBuffer(desc);
+        m_meshTable.countIndex[id] = 0;
+        m_meshTable.countVertex[id] = 0;
+        m_drawMeshes[id] = DrawMesh();
     }
+    std::fill_n(m_drawSkins.begin() + range.firstSkin, range.skinCount, DrawSkin());
+    m_dirtyMeshes.add(range.firstMesh, range.meshCount);
+    m_dirtySkins.add(range.firstSkin, range.skinCount);
 }
 
-static glm::vec3 toVec3(const pak::Vec3& vec)
+bool MeshBuffers::fits(uint64_t indexCount, uint64_t vertexCount) const
 {
-    return { vec.x(), vec.y(), vec.z() };
+    return (indexCount == 0 || m_indexHeap.getLargestFreeBlock() >= indexCount) &&
+           (vertexCount == 0 || m_vertexHeap.getLargestFreeBlock() >= vertexCount);
+}
+
+bool MeshBuffers::isMoving() const
+{
+    return !m_moves.empty() || m_frame < m_movedFrame;
+}
+
+void MeshBuffers::grow(const rhi::DevicePtr& device, uint64_t indexCount, uint64_t vertexCount)
+{
+    extendHeap(m_indexHeap, indexCount);
+    extendHeap(m_vertexHeap, vertexCount);
+    resizeHeap(device);
+}
+
+void MeshBuffers::retire(rhi::BufferPtr buffer)
+{
+    // Frames recorded up to now may still read it
+    if (buffer)
+        m_retired.emplace_back(m_frame + rhi::ISwapChain::FrameCount, std::move(buffer));
 }
 
-void MeshBuffers::updateMeshes(const flatbuffers::Vector<const pak::Mesh*>& meshEntries)
+void MeshBuffers::resizeHeap(const rhi::DevicePtr& device)
 {
-    meshCount.fetch_add(meshEntries.size());
-    for (uint32_t i = 0; i < meshEntries.size(); ++i)
+    const uint64_t indexSize = m_indexHeap.getMaxSize() * kIndexStride;
+    const uint64_t vertexSize = m_vertexHeap.getMaxSize() * kVertexStride;
+    const bool growIndex = !m_indexBuffer || m_indexBuffer->sizeInBytes() < indexSize;
+    const bool growVertex = !m_vertexBuffers[0] || m_vertexBuffers[0]->sizeInBytes() < vertexSize;
+    if (!growIndex && !growVertex)
+        return;
+
+    // The frame command copies the content before any pass draws from the new buffers
+    const auto regrow = [&](rhi::BufferPtr& buffer, const rhi::BufferDesc& desc, rhi::ResourceState state) {
+        rhi::BufferPtr next = device->createBuffer(desc);
+        if (buffer)
+            m_moves.emplace_back(std::move(buffer), next, state);
+        buffer = std::move(next);
+    };
+
+    rhi::BufferDesc desc;
+    desc.isDirectUpload = true;
+    if (growIndex)
     {
-        const pak::Mesh* entry = meshEntries[i];
-        meshes[i].countIndex = entry->count_index();
-        meshes[i].firstIndex = entry->first_index();
-        meshes[i].countVertex = entry->count_vertex();
-        meshes[i].firstVertex = entry->first_vertex();
-        meshes[i].bbMin = toVec3(entry->bbmin());
-        meshes[i].bbMax = toVec3(entry->bbmax());
+        desc.isIndexBuffer = true;
+        desc.sizeInBytes = indexSize;
+        desc.debugName = "IndexBuffer";
+        regrow(m_indexBuffer, desc, rhi::IndexBuffer);
     }
 
-    m_drawMeshes.resize(getMeshCount());
-    for (size_t i = 0; i < m_drawMeshes.size(); ++i)
+    if (growVertex)
     {
-        const IndexedMesh& mesh = meshes[i];
+        desc.sizeInBytes = vertexSize;
+        desc.isIndexBuffer = false;
+        desc.isVertexBuffer = true;
+        for (int i = 0; i < m_vertexBuffers.size(); ++i)
+        {
+            desc.debugName = kNames[i];
+            regrow(m_vertexBuffers[i], desc, rhi::ConstantBuffer);
+        }
+    }
 
-        DrawMesh& drawMesh = m_drawMeshes[i];
+    log::info("Geometry heap: {} MB index, {} MB vertex", indexSize >> 20, (vertexSize * m_vertexBuffers.size()) >> 20);
+}
 
-        drawMesh.firstIndex = mesh.firstIndex;
-        drawMesh.countIndex = mesh.countIndex;
-        drawMesh.firstVertex = mesh.firstVertex;
-        drawMesh.countVertex = mesh.countVertex;
-        drawMesh.bbMin = glm::vec4(mesh.bbMin, 1.f);
-        drawMesh.bbMax = glm::vec4(mesh.bbMax, 1.f);
+static glm::vec3 toVec3(const pak::Vec3& vec)
+{
+    return { vec.x(), vec.y(), vec.z() };
+}
+
+void MeshBuffers::updateMeshes(const GeometryRange& range, const GeometryRange& geometry,
+                               const flatbuffers::Vector<const pak::Mesh*>& meshEntries, uint32_t first, uint32_t count)
+{
+    if (count == 0)
+        return;
+
+    // Archive local offsets are rebased onto the heap ranges
+    const uint32_t baseIndex = meshEntries[first]->first_index();
+    const int32_t baseVertex = meshEntries[first]->first_vertex();
+    for (uint32_t i = first; i < first + count; ++i)
+    {
+        const pak::Mesh* entry = meshEntries[i];
+        const uint32_t id = range.firstMesh + i;
+        m_meshTable.countIndex[id] = entry->count_index();
+        m_meshTable.firstIndex[id] = entry->first_index() - baseIndex + static_cast<uint32_t>(geometry.firstIndex);
+        m_meshTable.countVertex[id] = entry->count_vertex();
+        m_meshTable.firstVertex[id] = entry->first_vertex() - baseVertex + static_cast<int32_t>(geometry.firstVertex);
+        m_meshTable.bbMin[id] = toVec3(entry->bbmin());
+        m_meshTable.bbMax[id] = toVec3(entry->bbmax());
+
+        DrawMesh& drawMesh = m_drawMeshes[id];
+        drawMesh.firstIndex = m_meshTable.firstIndex[id];
+        drawMesh.countIndex = m_meshTable.countIndex[id];
+        drawMesh.firstVertex = m_meshTable.firstVertex[id];
+        drawMesh.countVertex = m_meshTable.countVertex[id];
+        drawMesh.bbMin = glm::vec4(m_meshTable.bbMin[id], 1.f);
+        drawMesh.bbMax = glm::vec4(m_meshTable.bbMax[id], 1.f);
     }
+    m_dirtyMeshes.add(range.firstMesh + first, count);
 }
 
-void MeshBuffers::updateMaterials(const rhi::StoragePtr& storage, const flatbuffers::Vector<const pak::Material*>& materialEntries)
+void MeshBuffers::updateMaterials(const GeometryRange& range, const rhi::StoragePtr& storage,
+                                  const TextureLayerMap& layers,
+                                  const flatbuffers::Vector<const pak::Material*>& materialEntries)
 {
-    m_drawSkins.resize(materialEntries.size());
-    for (uint32_t i = 0; i < m_drawSkins.size(); ++i)
+    for (uint32_t i = 0; i < materialEntries.size(); ++i)
     {
         const pak::Material* material = materialEntries[i];
-        DrawSkin& skin = m_drawSkins[i];
+        DrawSkin& skin = m_drawSkins[range.firstSkin + i];
         skin.alphaMode = material->alpha_mode();
         skin.alphaCutOff = material->alpha_cut_off();
         pak::Vec3 b = material->base_color();
         skin.baseColor = glm::vec3(b.x(), b.y(), b.z());
 
-        skin.textures = glm::uvec4(0.f);
+        skin.textures = glm::uvec4(m_fallbackTexture);
+        skin.layers = glm::uvec4(DrawSkin::kNoLayer);
         for(int t = 0; t < 4; ++t)
         {
             uint64_t hash = material->texture()->Get(t);
+            const std::optional<uint32_t> page = m_virtualTextures ? m_virtualTextures->find(hash) : std::nullopt;
+            if (page.has_value())
+            {
+                skin.textures[t] = page.value();
+                skin.layers[t] = DrawSkin::kVirtual;
+                continue;
+            }
+            const auto layer = layers.find(hash);
+            if (layer != layers.end())
+                hash = layer->second.array;
             std::expected<rhi::ResourceViewPtr, rhi::StorageError> res = storage->getResource(hash);
             if(res.has_value())
+            {
                 skin.textures[t] = res.value()->getBindlessIndex();
+                if (layer != layers.end())
+                    skin.layers[t] = layer->second.layer;
+            }
         }
     }
+    m_dirtySkins.add(range.firstSkin, materialEntries.size());
 }
 
-void MeshBuffers::flushBuffer(const rhi::DevicePtr& device)
+void MeshBuffers::updateImpostors(const GeometryRange& range, const rhi::StoragePtr& storage,
+                                  const flatbuffers::Vector<const pak::Impostor*>* impostors)
 {
-    rhi::BufferDesc meshDesc;
-    meshDesc.debugName = "MeshBuffer";
-    meshDesc.stride = sizeof(DrawMesh);
-    meshDesc.sizeInBytes = sizeof(DrawMesh) * m_drawMeshes.size();
-    m_meshBuffer = device->createBuffer(meshDesc);
+    if (impostors == nullptr)
+        return;
+
+    for (const pak::Impostor* impostor : *impostors)
+    {
+        std::expected<rhi::ResourceViewPtr, rhi::StorageError> res = storage->getResource(impostor->texture_id());
+        DrawMesh& drawMesh = m_drawMeshes[range.firstMesh + impostor->mesh_id()];
+        drawMesh.impostorMesh = range.firstMesh + impostor->quad_id();
+        drawMesh.impostorTexture = res.has_value() ? res.value()->getBindlessIndex() : DrawMesh::kNoImpostor;
+        drawMesh.impostorFrames = impostor->frames();
+        m_dirtyMeshes.add(range.firstMesh + impostor->mesh_id(), 1);
+    }
+}
 
-    rhi::BufferDesc skinDesc;
-    skinDesc.debugName = "SkinBuffer";
-    skinDesc.stride = sizeof(DrawSkin);
-    skinDesc.sizeInBytes = sizeof(DrawSkin) * m_drawSkins.size();
-    m_skinBuffer = device->createBuffer(skinDesc);
+void MeshBuffers::resizeTables(const rhi::DevicePtr& device)
+{
+    // Replaced only when the ID heaps grow, passes holding a view of the old buffers must check for it
+    const auto regrow = [&](rhi::BufferPtr& buffer, std::string_view name, uint64_t stride, size_t count,
+                            DirtySpan& dirty) {
+        if (count == 0 || (buffer && buffer->sizeInBytes() >= stride * count))
+            return;
+        rhi::BufferDesc desc;
+        desc.debugName = name;
+        desc.stride = stride;
+        desc.sizeInBytes = stride * count;
+        retire(std::move(buffer));
+        buffer = device->createBuffer(desc);
+        dirty.add(0, static_cast<uint32_t>(count));
+    };
+    regrow(m_meshBuffer, "MeshBuffer", sizeof(DrawMesh), m_drawMeshes.size(), m_dirtyMeshes);
+    regrow(m_skinBuffer, "SkinBuffer", sizeof(DrawSkin), m_drawSkins.size(), m_dirtySkins);
+}
 
-    rhi::CommandPtr command;
-    rhi::BufferPtr staging = device->createBuffer(std::max(meshDesc.sizeInBytes, skinDesc.sizeInBytes), true);
+void MeshBuffers::flush(const rhi::CommandPtr& cmd)
+{
+    ++m_frame;
+    std::erase_if(m_retired, [this](const auto& retired) { return retired.first <= m_frame; });
 
-    command = device->createCommand(rhi::QueueType::Graphics);
-    staging->uploadFromMemory(m_drawMeshes.data(), meshDesc.sizeInBytes);
-    command->copyBuffer(staging, m_meshBuffer, meshDesc.sizeInBytes, 0);
-    device->submitOneShot(command);
+    for (PendingMove& move : m_moves)
+    {
+        cmd->addBufferBarrier(move.src, rhi::CopySrc);
+        cmd->addBufferBarrier(move.dst, rhi::CopyDest);
+        cmd->copyBuffer(move.src, move.dst, move.src->sizeInBytes(), 0);
+        cmd->addBufferBarrier(move.dst, move.state);
+        retire(std::move(move.src));
+    }
+    if (!m_moves.empty())
+    {
+        m_movedFrame = m_frame + rhi::ISwapChain::FrameCount;
+        m_moves.clear();
+    }
 
-    command = device->createCommand(rhi::QueueType::Graphics);
-    staging->uploadFromMemory(m_drawSkins.data(), skinDesc.sizeInBytes);
-    command->copyBuffer(staging, m_skinBuffer, skinDesc.sizeInBytes, 0);
-    device->submitOneShot(command);
+    if (!m_dirtyMeshes.empty())
+    {
+        const DirtySpan& span = m_dirtyMeshes;
+        cmd->syncBuffer(m_meshBuffer, m_drawMeshes.data() + span.first, sizeof(DrawMesh) * (span.last - span.first),
+                        sizeof(DrawMesh) * span.first);
+        m_dirtyMeshes = DirtySpan();
+    }
+    if (!m_dirtySkins.empty())
+    {
+        const DirtySpan& span = m_dirtySkins;
+        cmd->syncBuffer(m_skinBuffer, m_drawSkins.data() + span.first, sizeof(DrawSkin) * (span.last - span.first),
+                        sizeof(DrawSkin) * span.first);
+        m_dirtySkins = DirtySpan();
+    }
 }
 
 void MeshBuffers::bind(const rhi::CommandPtr& cmd, bool prePass) const
@@ -143,11 +339,11 @@ const rhi::BufferPtr& MeshBuffers::getSkinBuffer() const
 
 uint32_t MeshBuffers::getMeshCount() const
 {
-    return meshCount.load();
+    return static_cast<uint32_t>(m_meshTable.size());
 }
 
-const IndexedMesh& MeshBuffers::getMesh(uint32_t id) const
+IndexedMesh MeshBuffers::getMesh(uint32_t id) const
 {
-    return meshes[id];
+    return m_meshTable.get(id);
 }
 } // namespace ler::render
\ No newline at end of file
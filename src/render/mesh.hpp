@@ -8,38 +8,101 @@
 #include "draw.hpp"
 #include "rhi/rhi.hpp"
 #include "scene_generated.h"
+#include "sys/mem.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/string_cast.hpp>
+#include <unordered_map>
 
 namespace ler::render
 {
+class VirtualTextureCache;
+
 struct IndexedMesh
 {
     uint32_t countIndex = 0;
     uint32_t firstIndex = 0;
     uint32_t countVertex = 0;
     int32_t firstVertex = 0;
-    uint32_t materialId = 0;
     glm::vec3 bbMin = glm::vec3(0.f);
     glm::vec3 bbMax = glm::vec3(0.f);
-    glm::vec4 bounds = glm::vec4(0.f);
-    std::string name;
+};
+
+// Mesh metadata indexed by global mesh ID, one array per field
+struct MeshTable
+{
+    std::vector<uint32_t> countIndex;
+    std::vector<uint32_t> firstIndex;
+    std::vector<uint32_t> countVertex;
+    std::vector<int32_t> firstVertex;
+    std::vector<glm::vec3> bbMin;
+    std::vector<glm::vec3> bbMax;
+
+    void resize(size_t count);
+    [[nodiscard]] size_t size() const { return countIndex.size(); }
+    [[nodiscard]] IndexedMesh get(uint32_t id) const;
+};
+
+// Layer of a texture array holding a small texture packed by lerPak
+struct TextureLayer
+{
+    sys::AssetId array = 0;
+    uint32_t layer = 0;
+};
+
+using TextureLayerMap = std::unordered_map<sys::AssetId, TextureLayer>;
+
+// Heap space and global IDs owned by one mounted archive
+struct GeometryRange
+{
+    uint64_t firstIndex = 0;
+    uint64_t indexCount = 0;
+    uint64_t firstVertex = 0;
+    uint64_t vertexCount = 0;
+    uint32_t firstMesh = 0;
+    uint32_t meshCount = 0;
+    uint32_t firstSkin = 0;
+    uint32_t skinCount = 0;
 };
 
 class MeshBuffers
 {
   public:
     friend class ResourceManager;
-    void allocate(const rhi::DevicePtr& device, uint64_t indexSize, uint64_t vertexSize);
-    void updateMeshes(const flatbuffers::Vector<const pak::Mesh*>& meshEntries);
-    void updateMaterials(const rhi::StoragePtr& storage, const flatbuffers::Vector<const pak::Material*>& materialEntries);
-    void flushBuffer(const rhi::DevicePtr& device);
+    // Sub-allocates an archive from the shared heap, the geometry must fit, the ID tables grow as needed
+    GeometryRange allocate(const rhi::DevicePtr& device, uint64_t indexCount, uint64_t vertexCount, uint32_t meshCount,
+                           uint32_t skinCount);
+    // Gives a range back to the heap, no frame in flight may still draw from it
+    void release(const GeometryRange& range);
+    // True when allocate would not have to grow, and thus move, the index and vertex buffers
+    [[nodiscard]] bool fits(uint64_t indexCount, uint64_t vertexCount) const;
+    // Replaces the index and vertex buffers with larger ones, their content is copied by the next flush.
+    // No read may be in flight to the current buffers.
+    void grow(const rhi::DevicePtr& device, uint64_t indexCount, uint64_t vertexCount);
+    // Grown buffers are still being filled, geometry reads must wait for the copy to complete
+    [[nodiscard]] bool isMoving() const;
+    // Bindless slot used by materials whose texture is not resident (yet)
+    void setFallbackTexture(uint32_t slot) { m_fallbackTexture = slot; }
+    // Textures registered there are sampled through their page table
+    void setVirtualTextures(const VirtualTextureCache* cache) { m_virtualTextures = cache; }
+    // Meshes [first, first + count) take their IDs in range and their geometry in geometry,
+    // which starts with the vertices and indices of mesh first
+    void updateMeshes(const GeometryRange& range, const GeometryRange& geometry,
+                      const flatbuffers::Vector<const pak::Mesh*>& meshEntries, uint32_t first, uint32_t count);
+    // Textures found in layers are sampled from their array, the others from their own view
+    void updateMaterials(const GeometryRange& range, const rhi::StoragePtr& storage, const TextureLayerMap& layers,
+                         const flatbuffers::Vector<const pak::Material*>& materialEntries);
+    // Meshes switch to their impostor once its texture landed
+    void updateImpostors(const GeometryRange& range, const rhi::StoragePtr& storage,
+                         const flatbuffers::Vector<const pak::Impostor*>* impostors);
+    // Once per frame before the passes: copies grown buffers and uploads the meshes and materials changed
+    void flush(const rhi::CommandPtr& cmd);
     void bind(const rhi::CommandPtr& cmd, bool prePass) const;
     void bind(rhi::EncodeIndirectIndexedDrawDesc& drawDesc, bool prePass) const;
 
-    static constexpr uint32_t kMaxMesh = 2048;
+    static constexpr uint64_t kIndexStride = sizeof(uint32_t);
+    static constexpr uint64_t kVertexStride = sizeof(glm::vec3);
     static constexpr uint32_t kShaderGroupSizeNV = 32;
     static constexpr uint32_t kMaxVerticesPerMeshlet = 64;
     static constexpr uint32_t kMaxTrianglesPerMeshlet = 124;
@@ -56,7 +119,7 @@ class MeshBuffers
     [[nodiscard]] const rhi::BufferPtr& getSkinBuffer() const;
     [[nodiscard]] uint32_t getMeshCount() const;
 
-    const IndexedMesh& getMesh(uint32_t id) const;
+    [[nodiscard]] IndexedMesh getMesh(uint32_t id) const;
 
   private:
     /*
@@ -75,18 +138,47 @@ class MeshBuffers
     std::vector<rhi::ReadOnlyFilePtr> m_files;
     rhi::BufferPtr m_indexBuffer;
     std::array<rhi::BufferPtr, 4> m_vertexBuffers;
-    std::array<IndexedMesh, kMaxMesh> meshes;
+    MeshTable m_meshTable;
+
+    // Offsets in indices, vertices and IDs
+    sys::VariableSizeAllocator m_indexHeap;
+    sys::VariableSizeAllocator m_vertexHeap;
+    sys::VariableSizeAllocator m_meshIds;
+    sys::VariableSizeAllocator m_skinIds;
+
+    // Entries [first, last) of a table to upload
+    struct DirtySpan
+    {
+        uint32_t first = UINT32_MAX;
+        uint32_t last = 0;
+
+        void add(uint32_t begin, uint32_t count);
+        [[nodiscard]] bool empty() const { return first >= last; }
+    };
+
+    struct PendingMove
+    {
+        rhi::BufferPtr src;
+        rhi::BufferPtr dst;
+        rhi::ResourceState state = rhi::Undefined; // Read as once moved
+    };
 
     rhi::BufferPtr m_meshBuffer;
     rhi::BufferPtr m_skinBuffer;
     std::vector<DrawMesh> m_drawMeshes;
     std::vector<DrawSkin> m_drawSkins;
+    DirtySpan m_dirtyMeshes;
+    DirtySpan m_dirtySkins;
+    uint32_t m_fallbackTexture = 0;
+    const VirtualTextureCache* m_virtualTextures = nullptr;
 
-    std::atomic_uint32_t drawCount = 0;
-    std::atomic_uint32_t meshCount = 0;
-    std::atomic_uint32_t indexCount = 0;
-    std::atomic_uint32_t vertexCount = 0;
+    std::vector<PendingMove> m_moves;
+    std::vector<std::pair<uint64_t, rhi::BufferPtr>> m_retired; // Replaced buffers, kept until no frame reads them
+    uint64_t m_frame = 0;
+    uint64_t m_movedFrame = 0; // Frame from which the last copies have completed
 
-    rhi::Latch m_latch;
+    void resizeHeap(const rhi::DevicePtr& device);
+    void resizeTables(const rhi::DevicePtr& device);
+    void retire(rhi::BufferPtr buffer);
 };
 } // namespace ler::render
\ No newline at end of file
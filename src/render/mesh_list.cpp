@@ -6,29 +6,159 @@
 
 namespace ler::render
 {
-void RenderMeshList::installStaticScene(const rhi::DevicePtr& device,
-                                        const flatbuffers::Vector<const pak::Instance*>& instanceEntries)
+static bool isSameInstance(const DrawInstance& a, const DrawInstance& b)
 {
-    m_drawInstances.reserve(instanceEntries.size());
-    for (const pak::Instance* inst : instanceEntries)
-    {
-        DrawInstance& drawInst = m_drawInstances.emplace_back();
-        drawInst.model = glm::make_mat4(inst->transform()->data());
-        drawInst.skinIndex = inst->skin_id();
-        drawInst.meshIndex = inst->mesh_id();
-    }
+    return a.model == b.model && a.meshIndex == b.meshIndex && a.skinIndex == b.skinIndex;
+}
+
+void RenderMeshList::installStaticScene(const rhi::DevicePtr& device, std::vector<DrawInstance> instances,
+                                        uint32_t capacity)
+{
+    m_drawInstances = std::move(instances);
+
+    // Headroom for archives reloaded with a few more instances
+    m_capacity = std::bit_ceil(std::max({ 1u, capacity, static_cast<uint32_t>(m_drawInstances.size()) }));
+    m_dirty.assign((m_capacity + 63) / 64, 0);
 
     rhi::BufferDesc bufDesc;
     bufDesc.debugName = "InstanceBuffer";
+    bufDesc.isUAV = true;
     bufDesc.stride = sizeof(DrawInstance);
-    bufDesc.sizeInBytes = sizeof(DrawInstance) * m_drawInstances.size();
+    bufDesc.sizeInBytes = sizeof(DrawInstance) * m_capacity;
     m_instanceBuffer = device->createBuffer(bufDesc);
 
-    rhi::BufferPtr staging = device->createBuffer(bufDesc.sizeInBytes, true);
-    staging->uploadFromMemory(m_drawInstances.data(), bufDesc.sizeInBytes);
-    rhi::CommandPtr command = device->createCommand(rhi::QueueType::Graphics);
-    command->copyBuffer(staging, m_instanceBuffer, bufDesc.sizeInBytes, 0);
-    device->submitOneShot(command);
+    const uint64_t byteSize = sizeof(DrawInstance) * m_drawInstances.size();
+    if (byteSize > 0)
+    {
+        rhi::BufferPtr staging = device->createBuffer(byteSize, true);
+        staging->uploadFromMemory(m_drawInstances.data(), byteSize);
+        rhi::CommandPtr command = device->createCommand(rhi::QueueType::Graphics);
+        command->copyBuffer(staging, m_instanceBuffer, byteSize, 0);
+        device->submitOneShot(command);
+    }
+
+    // Worst case every instance moves in the same frame
+    bufDesc.debugName = "ScatterBuffer";
+    bufDesc.isUAV = false;
+    bufDesc.stride = sizeof(ScatterEntry);
+    bufDesc.sizeInBytes = sizeof(ScatterEntry) * m_capacity;
+    m_scatterBuffer = device->createBuffer(bufDesc);
+
+    m_table = device->createBindlessTable(2);
+    m_scatterView = m_table->createResourceView(m_scatterBuffer);
+    m_instanceView = m_table->createResourceView(m_instanceBuffer);
+
+    rhi::ShaderModule shaderModule("cached/scatter.comp", "CSMain", rhi::ShaderType::Compute);
+    m_scatterPass = device->createComputePipeline(shaderModule);
+}
+
+void RenderMeshList::replaceInstances(std::vector<DrawInstance> instances)
+{
+    if (instances.size() > m_capacity)
+    {
+        log::warn("[MeshList] Instance capacity exceeded, {} instances dropped", instances.size() - m_capacity);
+        instances.resize(m_capacity);
+    }
+
+    // Instances past the new end are no longer drawn, they must not be uploaded
+    for (auto id = static_cast<uint32_t>(instances.size()); id < m_drawInstances.size(); ++id)
+    {
+        uint64_t& word = m_dirty[id / 64];
+        const uint64_t bit = uint64_t(1) << (id % 64);
+        m_dirtyCount -= (word & bit) != 0;
+        word &= ~bit;
+    }
+
+    for (uint32_t id = 0; id < instances.size(); ++id)
+    {
+        if (id >= m_drawInstances.size() || !isSameInstance(instances[id], m_drawInstances[id]))
+            markDirty(id);
+    }
+    m_drawInstances = std::move(instances);
+}
+
+void RenderMeshList::setTransform(uint32_t id, const glm::mat4& model)
+{
+    m_drawInstances[id].model = model;
+    markDirty(id);
+}
+
+void RenderMeshList::markDirty(uint32_t id)
+{
+    uint64_t& word = m_dirty[id / 64];
+    const uint64_t bit = uint64_t(1) << (id % 64);
+    m_dirtyCount += (word & bit) == 0;
+    word |= bit;
+}
+
+void RenderMeshList::flush(rhi::CommandPtr& cmd)
+{
+    if (m_dirtyCount == 0)
+        return;
+
+    // Collect dirty runs, short clean gaps are cheaper to upload than a new range
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    for (size_t w = 0; w < m_dirty.size(); ++w)
+    {
+        for (uint64_t word = m_dirty[w]; word != 0;)
+        {
+            const auto bit = static_cast<uint32_t>(std::countr_zero(word));
+            const auto run = static_cast<uint32_t>(std::countr_one(word >> bit));
+            const auto first = static_cast<uint32_t>(w * 64 + bit);
+            if (!ranges.empty() && first <= ranges.back().second + kMergeGap)
+                ranges.back().second = first + run;
+            else
+                ranges.emplace_back(first, first + run);
+            word = run + bit == 64 ? 0 : word & ~((uint64_t(1) << (bit + run)) - 1);
+        }
+    }
+
+    m_stats.flushes.add();
+    m_stats.ranges.add(ranges.size());
+    if (ranges.size() > kScatterRanges)
+        scatter(cmd);
+    else
+    {
+        for (const auto& [first, last] : ranges)
+        {
+            const uint64_t size = sizeof(DrawInstance) * (last - first);
+            cmd->syncBuffer(m_instanceBuffer, m_drawInstances.data() + first, size, sizeof(DrawInstance) * first);
+            m_stats.uploadedBytes.add(size);
+        }
+    }
+
+    std::ranges::fill(m_dirty, 0);
+    m_dirtyCount = 0;
+}
+
+void RenderMeshList::scatter(rhi::CommandPtr& cmd)
+{
+    m_scatter.clear();
+    for (size_t w = 0; w < m_dirty.size(); ++w)
+    {
+        for (uint64_t word = m_dirty[w]; word != 0; word &= word - 1)
+        {
+            const auto id = static_cast<uint32_t>(w * 64 + std::countr_zero(word));
+            m_scatter.emplace_back(m_drawInstances[id], id);
+        }
+    }
+
+    const uint64_t size = sizeof(ScatterEntry) * m_scatter.size();
+    cmd->addBufferBarrier(m_scatterBuffer, rhi::ShaderResource);
+    cmd->syncBuffer(m_scatterBuffer, m_scatter.data(), size);
+    m_stats.uploadedBytes.add(size);
+    m_stats.scatters.add();
+
+    ScatterResources res;
+    res.srcIndex = m_scatterView->getBindlessIndex();
+    res.dstIndex = m_instanceView->getBindlessIndex();
+    res.count = static_cast<uint32_t>(m_scatter.size());
+
+    cmd->addBufferBarrier(m_instanceBuffer, rhi::UnorderedAccess);
+    cmd->bindPipeline(m_scatterPass, m_table, nullptr);
+    cmd->pushConstant(m_scatterPass, rhi::ShaderType::Compute, 0, &res, sizeof(ScatterResources));
+    cmd->dispatch((res.count + 63) / 64, 1, 1);
+    cmd->addBufferBarrier(m_instanceBuffer, rhi::ShaderResource);
 }
 
 const rhi::BufferPtr& RenderMeshList::getInstanceBuffer() const
@@ -51,7 +181,7 @@ const DrawInstance& RenderMeshList::getInstance(uint32_t id) const
     return m_drawInstances[id];
 }
 
-const IndexedMesh& RenderMeshList::getMesh(uint32_t id) const
+IndexedMesh RenderMeshList::getMesh(uint32_t id) const
 {
     return m_meshes->getMesh(id);
 }
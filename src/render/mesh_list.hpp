@@ -11,13 +11,29 @@ namespace ler::render
 class RenderMeshList
 {
   public:
-    void installStaticScene(const rhi::DevicePtr& device, const flatbuffers::Vector<const pak::Instance*>& instanceEntries);
+    struct Stats
+    {
+        sys::Counter flushes;
+        sys::Counter ranges;
+        sys::Counter scatters;
+        sys::Counter uploadedBytes;
+    };
+
+    void installStaticScene(const rhi::DevicePtr& device, std::vector<DrawInstance> instances, uint32_t capacity = 0);
+    // Swaps the whole instance list in place, only the entries that changed are uploaded by the next flush
+    void replaceInstances(std::vector<DrawInstance> instances);
+    void setTransform(uint32_t id, const glm::mat4& model);
+    // Uploads the instances changed since the last call, once per frame before any pass reads them
+    void flush(rhi::CommandPtr& cmd);
+    [[nodiscard]] const Stats& getStats() const { return m_stats; }
     [[nodiscard]] const rhi::BufferPtr& getInstanceBuffer() const;
     [[nodiscard]] const rhi::BufferPtr& getMeshBuffer() const;
     [[nodiscard]] const rhi::BufferPtr& getSkinBuffer() const;
     [[nodiscard]] const DrawInstance& getInstance(uint32_t id) const;
     [[nodiscard]] uint32_t getInstanceCount() const;
-    [[nodiscard]] const IndexedMesh& getMesh(uint32_t id) const;
+    // Size of the instance buffer, passes sizing per instance data use this bound
+    [[nodiscard]] uint32_t getInstanceCapacity() const { return m_capacity; }
+    [[nodiscard]] IndexedMesh getMesh(uint32_t id) const;
 
     void setMeshBuffers(MeshBuffers* meshes) { m_meshes = meshes; }
     [[nodiscard]] MeshBuffers* getMeshBuffers() const { return m_meshes; }
@@ -25,9 +41,41 @@ class RenderMeshList
     void bindEncoder(rhi::EncodeIndirectIndexedDrawDesc& drawDesc, bool prePass) const;
 
   private:
+    struct alignas(16) ScatterEntry
+    {
+        DrawInstance instance;
+        glm::uint index = 0u;
+    };
+
+    struct ScatterResources
+    {
+        glm::uint srcIndex = 0u;
+        glm::uint dstIndex = 0u;
+        glm::uint count = 0u;
+    };
+
+    // Clean instances uploaded anyway to join two dirty ranges
+    static constexpr uint32_t kMergeGap = 4;
+    // Past this many ranges, dirty instances are packed and scattered on the GPU
+    static constexpr uint32_t kScatterRanges = 64;
+
+    void markDirty(uint32_t id);
+    void scatter(rhi::CommandPtr& cmd);
+
     MeshBuffers* m_meshes = nullptr;
     rhi::BufferPtr m_instanceBuffer;
     std::vector<DrawInstance> m_drawInstances;
+    uint32_t m_capacity = 0;
+    std::vector<uint64_t> m_dirty;
+    uint32_t m_dirtyCount = 0;
+
+    rhi::PipelinePtr m_scatterPass;
+    rhi::BindlessTablePtr m_table;
+    rhi::BufferPtr m_scatterBuffer;
+    rhi::ResourceViewPtr m_scatterView;
+    rhi::ResourceViewPtr m_instanceView;
+    std::vector<ScatterEntry> m_scatter;
+    Stats m_stats;
 };
 
 struct RenderParams
@@ -36,5 +84,7 @@ struct RenderParams
     glm::mat4 view = glm::mat4(1.f);
     RenderMeshList* meshList = nullptr;
     rhi::BindlessTablePtr table;
+    uint32_t virtualTextures = 0; // Bindless index of the DrawVirtualTexture buffer
+    float impostorDistance = 150.f; // Meshes with an impostor draw it beyond this distance to the eye
 };
 } // namespace ler::render
\ No newline at end of file
@@ -6,10 +6,33 @@
 
 namespace ler::render
 {
-void ResourceManager::setup(const rhi::StoragePtr& storage, const rhi::BindlessTablePtr& table)
+void ResourceManager::setup(const rhi::DevicePtr& device, const rhi::StoragePtr& storage,
+                            const rhi::BindlessTablePtr& table)
 {
     m_storage = storage;
     m_table = table;
+
+    // Sampled by materials until their textures land
+    rhi::TextureDesc desc;
+    desc.format = rhi::Format::RGBA8_UNORM;
+    desc.debugName = "Placeholder";
+    m_placeholder = device->createTexture(desc);
+
+    static constexpr std::array<uint8_t, 4> kGrey = { 128, 128, 128, 255 };
+    rhi::BufferPtr staging = device->createBuffer(kGrey.size(), true);
+    rhi::Subresource sub;
+    sub.width = 1;
+    sub.height = 1;
+    sub.rowPitch = kGrey.size();
+    rhi::CommandPtr command = device->createCommand(rhi::QueueType::Graphics);
+    command->copyBufferToTexture(staging, m_placeholder, sub, kGrey.data());
+    device->submitOneShot(command);
+
+    m_placeholderView = m_table->createResourceView(m_placeholder);
+    m_meshBuffers.setFallbackTexture(m_placeholderView->getBindlessIndex());
+
+    m_virtualTextures.setup(device, storage, table);
+    m_meshBuffers.setVirtualTextures(&m_virtualTextures);
 }
 
 static constexpr rhi::Format convertFormat(pak::TextureFormat format)
@@ -31,10 +54,12 @@ static constexpr rhi::Format convertFormat(pak::TextureFormat format)
         return rhi::Format::BC6H_SFLOAT;
     case pak::TextureFormat_Bc7:
         return rhi::Format::BC7_UNORM;
+    case pak::TextureFormat_Rgba8:
+        return rhi::Format::RGBA8_UNORM;
     }
 }
 
-const pak::PakArchive* ResourceManager::readHeader(const fs::path& path)
+const pak::PakArchive* ResourceManager::readHeader(const fs::path& path, std::vector<uint8_t>& buffer)
 {
     std::error_code ec;
     const auto fileSize = static_cast<uint64_t>(fs::file_size(path, ec));
@@ -56,114 +81,677 @@ const pak::PakArchive* ResourceManager::readHeader(const fs::path& path)
     if (fbSize > fileSize)
         return nullptr;
 
-    m_buffer.resize(fbSize);
-    file.read(reinterpret_cast<char*>(m_buffer.data()), fbSize);
-    file.close();
+    buffer.resize(fbSize);
+    file.read(reinterpret_cast<char*>(buffer.data()), fbSize);
 
-    flatbuffers::Verifier v(m_buffer.data(), fbSize);
-    assert(pak::VerifyPakArchiveBuffer(v));
-    return pak::GetPakArchive(m_buffer.data());
+    flatbuffers::Verifier v(buffer.data(), fbSize);
+    if (!file || !pak::VerifyPakArchiveBuffer(v))
+    {
+        log::error("Corrupted archive header: {}", path.string());
+        return nullptr;
+    }
+    return pak::GetPakArchive(buffer.data());
 }
 
-bool ResourceManager::openArchive(const rhi::DevicePtr& device, const fs::path& path)
+// Archive local geometry of a run of meshes, contiguous in the pak buffers
+struct MeshSpan
+{
+    uint64_t firstIndex = 0;
+    uint64_t indexCount = 0;
+    uint64_t firstVertex = 0;
+    uint64_t vertexCount = 0;
+};
+
+static MeshSpan meshSpan(const pak::PakArchive* archive, uint32_t first, uint32_t count)
+{
+    MeshSpan span;
+    if (count == 0)
+        return span;
+    const pak::Mesh* front = archive->meshes()->Get(first);
+    const pak::Mesh* back = archive->meshes()->Get(first + count - 1);
+    span.firstIndex = front->first_index();
+    span.indexCount = back->first_index() + back->count_index() - span.firstIndex;
+    span.firstVertex = front->first_vertex();
+    span.vertexCount = back->first_vertex() + back->count_vertex() - span.firstVertex;
+    return span;
+}
+
+std::vector<rhi::BufferStreamingMetadata> ResourceManager::geometryRequests(const MountedArchive& mount,
+                                                                           const MeshSpan& span,
+                                                                           const GeometryRange& range) const
+{
+    // Geometry gates the first frame, textures can land afterward
+    sys::IoOptions options;
+    options.priority = sys::IoPriority::High;
+
+    std::vector<rhi::BufferStreamingMetadata> requests;
+    for (uint32_t type = pak::BufferType_Index; type <= pak::BufferType_Tangent; ++type)
+    {
+        const pak::PakEntry* entry = mount.buffers[type];
+        const bool index = type == pak::BufferType_Index;
+        const uint64_t stride = index ? MeshBuffers::kIndexStride : MeshBuffers::kVertexStride;
+        const uint64_t first = index ? span.firstIndex : span.firstVertex;
+        const uint64_t count = index ? span.indexCount : span.vertexCount;
+        if (entry == nullptr || count == 0)
+            continue;
+
+        rhi::BufferStreamingMetadata& m = requests.emplace_back();
+        m.file = mount.file;
+        m.byteOffset = entry->byte_offset() + first * stride;
+        m.byteLength = count * stride;
+        // Checksums cover whole entries, slices of a partitioned archive are not verified
+        m.contentHash = m.byteLength == entry->byte_length() ? entry->content_hash() : 0;
+        m.options = options;
+        m.buffer = index ? m_meshBuffers.m_indexBuffer : m_meshBuffers.m_vertexBuffers[type - pak::BufferType_Position];
+        m.bufferOffset = (index ? range.firstIndex : range.firstVertex) * stride;
+    }
+    return requests;
+}
+
+static std::vector<rhi::TextureStreamingMetadata> textureRequests(const MountedArchive& mount,
+                                                                  const std::vector<sys::AssetId>& keys)
+{
+    std::vector<rhi::TextureStreamingMetadata> requests;
+    for (sys::AssetId key : keys)
+    {
+        const pak::PakEntry* entry = mount.textureEntries.at(key);
+        const pak::Texture* t = entry->resource_as_Texture();
+        rhi::TextureStreamingMetadata& m = requests.emplace_back();
+        m.byteLength = entry->byte_length();
+        m.byteOffset = entry->byte_offset();
+        m.contentHash = entry->content_hash();
+        m.assetId = key;
+
+        m.desc.format = convertFormat(t->format());
+        m.desc.debugName = t->filename()->c_str();
+        m.desc.mipLevels = t->mip_levels();
+        m.desc.arrayLayers = t->array_layers();
+        m.desc.height = t->height();
+        m.desc.width = t->width();
+
+        // Older paks have no footprints, the storage computes them
+        if (t->footprints() != nullptr)
+        {
+            // Layer-major: every mip of layer 0, then layer 1...
+            uint32_t subresource = 0;
+            for (const pak::CopyFootprint* fp : *t->footprints())
+            {
+                rhi::Subresource& sub = m.footprints.emplace_back();
+                sub.index = subresource % t->mip_levels();
+                sub.layer = subresource++ / t->mip_levels();
+                sub.offset = fp->buffer_offset();
+                sub.rowPitch = fp->row_length();
+                sub.width = fp->width();
+                sub.height = fp->height();
+            }
+        }
+
+        m.file = mount.file;
+    }
+    return requests;
+}
+
+// Cells list the textures of their materials, small ones live in an array entry
+static sys::AssetId resolveTexture(const MountedArchive& mount, sys::AssetId key)
+{
+    const auto it = mount.textureLayers.find(key);
+    return it != mount.textureLayers.end() ? it->second.array : key;
+}
+
+static uint32_t residentMeshCount(const pak::PakArchive* archive)
+{
+    // Partitioned archives only load the meshes shared by several cells up front, batch sources are left out
+    if (archive->cells() != nullptr && archive->cells()->size() > 0)
+        return archive->cells()->Get(0)->first_mesh();
+    return archive->meshes()->size() - archive->source_mesh_count();
+}
+
+std::unique_ptr<PendingLoad> ResourceManager::startLoad(std::vector<rhi::TextureStreamingMetadata> textures,
+                                                        std::vector<rhi::BufferStreamingMetadata> buffers)
+{
+    auto load = std::make_unique<PendingLoad>(buffers.size(), textures.size());
+    for (rhi::BufferStreamingMetadata& m : buffers)
+    {
+        m.options.token = load->token;
+        m_storage->requestLoadBuffer(load->geometry, m);
+    }
+    for (rhi::TextureStreamingMetadata& m : textures)
+    {
+        m.options.token = load->token;
+        load->textureKeys.emplace_back(m.assetId);
+    }
+    if (!textures.empty())
+        m_storage->requestLoadTexture(load->textures, m_table, textures);
+    return load;
+}
+
+void ResourceManager::cancelLoad(PendingLoad& load)
 {
-    const pak::PakArchive* archive = readHeader(path);
-    if (archive == nullptr)
+    // Queued reads are dropped, only the ones already in flight are waited for
+    load.token.cancel();
+    coro::sync_wait(load.geometry);
+    coro::sync_wait(load.textures);
+}
+
+void ResourceManager::handOverTextures(const MountedArchive& closed, const std::vector<sys::AssetId>& keys)
+{
+    // Other archives skipped the textures the closed one was loading, the first one still using them takes over
+    std::unordered_map<MountedArchive*, std::vector<sys::AssetId>> owners;
+    for (sys::AssetId key : keys)
+    {
+        if (m_storage->getResource(key).has_value())
+            continue;
+        const auto owner = std::ranges::find_if(m_archives, [&](const MountedArchive& other) {
+            return &other != &closed && std::ranges::contains(other.textures, key) &&
+                   other.textureEntries.contains(key);
+        });
+        if (owner != m_archives.end())
+            owners[&*owner].emplace_back(key);
+    }
+
+    for (auto& [mount, handed] : owners)
+    {
+        log::info("{} takes over {} textures from {}", mount->path.filename().string(), handed.size(),
+                  closed.path.filename().string());
+        if (mount->queued)
+            mount->queuedTextures.insert(mount->queuedTextures.end(), handed.begin(), handed.end());
+        else
+            mount->handovers.emplace_back(startLoad(textureRequests(*mount, handed), {}));
+    }
+}
+
+bool ResourceManager::isGeometryLoading() const
+{
+    const auto loading = [](const std::unique_ptr<PendingLoad>& load) { return load && !load->geometry.is_ready(); };
+    return std::ranges::any_of(m_archives, [&](const MountedArchive& mount) {
+        return loading(mount.pending) || std::ranges::any_of(mount.cells, loading, &CellState::pending);
+    });
+}
+
+bool ResourceManager::reserveGeometry(const rhi::DevicePtr& device, uint64_t indexCount, uint64_t vertexCount)
+{
+    // Never waits: a load that does not fit yet is retried on a later frame
+    if (indexCount == 0 && vertexCount == 0)
+        return true;
+    if (m_meshBuffers.isMoving())
+        return false;
+    if (m_meshBuffers.fits(indexCount, vertexCount))
+        return true;
+
+    // Growing moves the heap, reads still in flight would land in the old buffers
+    if (isGeometryLoading())
+        return false;
+    m_meshBuffers.grow(device, indexCount, vertexCount);
+    return !m_meshBuffers.isMoving();
+}
+
+bool ResourceManager::loadArchive(const rhi::DevicePtr& device, MountedArchive& mount)
+{
+    const MeshSpan span = meshSpan(mount.archive, 0, residentMeshCount(mount.archive));
+    if (!reserveGeometry(device, span.indexCount, span.vertexCount))
         return false;
 
-    m_archive = archive;
+    mount.geometry = m_meshBuffers.allocate(device, span.indexCount, span.vertexCount, 0, 0);
+    mount.pending =
+        startLoad(textureRequests(mount, mount.queuedTextures), geometryRequests(mount, span, mount.geometry));
+    mount.queuedTextures.clear();
+    mount.queued = false;
+    return true;
+}
 
-    rhi::ReadOnlyFilePtr f = m_storage->openFile(path);
+bool ResourceManager::openArchive(const rhi::DevicePtr& device, const fs::path& path)
+{
+    MountedArchive mount;
+    mount.path = path;
+    mount.archive = readHeader(path, mount.header);
+    if (mount.archive == nullptr)
+        return false;
+
+    const pak::PakArchive* archive = mount.archive;
+    mount.file = m_storage->openFile(path);
+    std::error_code ec;
+    mount.writeTime = fs::last_write_time(path, ec);
 
-    uint64_t indexSize = 0;
-    uint64_t vertexSize = 0;
-    uint32_t bufferCount = 0;
-    uint32_t textureCount = 0;
     for (const pak::PakEntry* entry : *archive->entries())
     {
         if (entry->resource_type() == pak::ResourceType_Buffer)
+            mount.buffers[entry->resource_as_Buffer()->type()] = entry;
+        else if (entry->resource_type() == pak::ResourceType_Texture)
         {
-            bufferCount += 1;
-            const pak::Buffer* b = entry->resource_as_Buffer();
-            switch (b->type())
+            // Older paks have no asset ID, materials then key textures by the hash of their name
+            const pak::Texture* texture = entry->resource_as_Texture();
+            const sys::AssetId id = texture->asset_id();
+            if (texture->page_size() > 0)
+            {
+                if (m_virtualTextures.add(device, id, entry, mount.file, convertFormat(texture->format())))
+                    mount.virtualTextures.emplace_back(id);
+                continue;
+            }
+            mount.textureEntries[id != 0 ? id : sys::makeAssetId(texture->filename()->string_view())] = entry;
+            if (texture->array_layers() > 1 && texture->layers() != nullptr)
             {
-            case pak::BufferType_Index:
-                indexSize = std::max(indexSize, entry->byte_length());
-                break;
-            default:
-                vertexSize = std::max(vertexSize, entry->byte_length());
-                break;
+                for (uint32_t layer = 0; layer < texture->layers()->size(); ++layer)
+                    mount.textureLayers[texture->layers()->Get(layer)] = TextureLayer(id, layer);
             }
         }
-        else if (entry->resource_type() == pak::ResourceType_Texture)
-            textureCount += 1;
     }
 
-    m_meshBuffers.allocate(device, indexSize, vertexSize);
+    const GeometryRange& range = mount.range =
+        m_meshBuffers.allocate(device, 0, 0, archive->meshes()->size(), archive->materials()->size());
 
-    coro::latch l(textureCount + bufferCount);
+    if (archive->cells() != nullptr && archive->cells()->size() > 0)
+    {
+        // Cells do not list impostor textures, they load with the archive
+        mount.cells.resize(archive->cells()->size());
+        if (archive->impostors() != nullptr)
+        {
+            for (const pak::Impostor* impostor : *archive->impostors())
+                mount.textures.emplace_back(impostor->texture_id());
+        }
+    }
+    else
+    {
+        for (uint64_t key : std::views::keys(mount.textureEntries))
+            mount.textures.emplace_back(key);
+    }
 
-    std::vector<rhi::TextureStreamingMetadata> resources;
-    for (const pak::PakEntry* entry : *archive->entries())
+    // Textures deduplicated across archives are loaded once, under the same bindless index
+    std::ranges::copy_if(mount.textures, std::back_inserter(mount.queuedTextures),
+                         [&](sys::AssetId key) { return !isTextureShared(mount, key); });
+    mount.queued = !loadArchive(device, mount);
+
+    // Placeholder materials until the first textures land
+    m_meshBuffers.updateMaterials(range, m_storage, mount.textureLayers, *archive->materials());
+    m_meshBuffers.updateImpostors(range, m_storage, archive->impostors());
+    registerAssets(mount);
+
+    log::info("Mounting {}: {} meshes at {}, {} materials at {}, {} cells{}", path.filename().string(),
+              range.meshCount, range.firstMesh, range.skinCount, range.firstSkin, mount.cells.size(),
+              mount.queued ? ", queued" : "");
+    m_archives.emplace_back(std::move(mount));
+    return true;
+}
+
+bool ResourceManager::isTextureShared(const MountedArchive& mount, sys::AssetId id) const
+{
+    return std::ranges::any_of(m_archives, [&](const MountedArchive& other) {
+        return &other != &mount && std::ranges::contains(other.textures, id);
+    });
+}
+
+rhi::ResourceViewPtr ResourceManager::releaseTexture(const MountedArchive& mount, sys::AssetId id)
+{
+    // Same texture in another mounted archive, the storage entry is shared
+    return isTextureShared(mount, id) ? nullptr : m_storage->releaseResource(id);
+}
+
+void ResourceManager::registerAssets(const MountedArchive& mount)
+{
+    // Paks packed before asset IDs can only be addressed by index
+    const pak::PakArchive* archive = mount.archive;
+    if (archive->mesh_ids() != nullptr)
+    {
+        for (uint32_t i = 0; i < archive->mesh_ids()->size(); ++i)
+            m_meshIds.insert(archive->mesh_ids()->Get(i), mount.range.firstMesh + i);
+    }
+    if (archive->material_ids() != nullptr)
     {
-        if (entry->resource_type() == pak::ResourceType_Texture)
+        for (uint32_t i = 0; i < archive->material_ids()->size(); ++i)
+            m_materialIds.insert(archive->material_ids()->Get(i), mount.range.firstSkin + i);
+    }
+}
+
+void ResourceManager::unregisterAssets(const MountedArchive& mount)
+{
+    // The last archive mounted owns an ID, another one may have taken it over since
+    const auto erase = [](sys::AssetMap<uint32_t>& ids, const flatbuffers::Vector<uint64_t>* list, uint32_t first,
+                          uint32_t count) {
+        if (list == nullptr)
+            return;
+        for (sys::AssetId id : *list)
         {
-            const pak::Texture* t = entry->resource_as_Texture();
-            rhi::TextureStreamingMetadata& m = resources.emplace_back();
-            m.byteLength = entry->byte_length();
-            m.byteOffset = entry->byte_offset();
-
-            m.desc.format = convertFormat(t->format());
-            m.desc.debugName = t->filename()->c_str();
-            m.desc.mipLevels = t->mip_levels();
-            m.desc.height = t->height();
-            m.desc.width = t->width();
-
-            m.file = f;
+            const std::optional<uint32_t> index = ids.find(id);
+            if (index.has_value() && *index >= first && *index < first + count)
+                ids.erase(id);
         }
-        else if (entry->resource_type() == pak::ResourceType_Buffer)
+    };
+    erase(m_meshIds, mount.archive->mesh_ids(), mount.range.firstMesh, mount.range.meshCount);
+    erase(m_materialIds, mount.archive->material_ids(), mount.range.firstSkin, mount.range.skinCount);
+}
+
+bool ResourceManager::closeArchive(const fs::path& path)
+{
+    const auto it = std::ranges::find(m_archives, path, &MountedArchive::path);
+    if (it == m_archives.end())
+        return false;
+
+    std::vector<sys::AssetId> cancelled = it->queuedTextures;
+    const auto cancel = [&](const std::unique_ptr<PendingLoad>& load) {
+        if (load == nullptr)
+            return;
+        cancelLoad(*load);
+        cancelled.insert(cancelled.end(), load->textureKeys.begin(), load->textureKeys.end());
+    };
+    cancel(it->pending);
+    for (const CellState& cell : it->cells)
+        cancel(cell.pending);
+    for (const std::unique_ptr<PendingLoad>& load : it->handovers)
+        cancel(load);
+    // Textures that landed before the cancel are published first, so that they are released below
+    m_storage->update();
+    handOverTextures(*it, cancelled);
+
+    RetiredArchive& retired = m_retired.emplace_back();
+    retired.frame = m_frame + rhi::ISwapChain::FrameCount;
+    retired.range = it->range;
+    for (uint64_t key : it->textures)
+    {
+        if (rhi::ResourceViewPtr view = releaseTexture(*it, key))
+            retired.views.emplace_back(std::move(view));
+    }
+
+    for (sys::AssetId id : it->virtualTextures)
+        m_virtualTextures.remove(id);
+
+    log::info("Closed {}: {} meshes, {} textures", path.filename().string(), it->range.meshCount,
+              retired.views.size());
+    unregisterAssets(*it);
+    const uint64_t frame = retired.frame;
+    m_retired.emplace_back(frame, it->geometry);
+    for (const CellState& cell : it->cells)
+    {
+        if (cell.resident || cell.pending)
+            m_retired.emplace_back(frame, cell.geometry);
+    }
+
+    m_archives.erase(it);
+    refreshInstances();
+    return true;
+}
+
+bool ResourceManager::loadCell(const rhi::DevicePtr& device, MountedArchive& mount, uint32_t index)
+{
+    const pak::Cell* cell = mount.archive->cells()->Get(index);
+    const MeshSpan span = meshSpan(mount.archive, cell->first_mesh(), cell->mesh_count());
+    CellState& state = mount.cells[index];
+    if (!reserveGeometry(device, span.indexCount, span.vertexCount))
+        return false;
+    state.geometry = m_meshBuffers.allocate(device, span.indexCount, span.vertexCount, 0, 0);
+
+    std::vector<sys::AssetId> keys;
+    for (sys::AssetId member : *cell->textures())
+    {
+        const sys::AssetId key = resolveTexture(mount, member);
+        if (mount.textureEntries.contains(key) && mount.textureRefs[key]++ == 0)
         {
-            const pak::Buffer* b = entry->resource_as_Buffer();
-            switch (b->type())
+            mount.textures.emplace_back(key);
+            if (!isTextureShared(mount, key))
+                keys.emplace_back(key);
+        }
+    }
+
+    state.pending = startLoad(textureRequests(mount, keys), geometryRequests(mount, span, state.geometry));
+    return true;
+}
+
+void ResourceManager::unloadCell(MountedArchive& mount, uint32_t index)
+{
+    const pak::Cell* cell = mount.archive->cells()->Get(index);
+    CellState& state = mount.cells[index];
+
+    RetiredArchive& retired = m_retired.emplace_back();
+    retired.frame = m_frame + rhi::ISwapChain::FrameCount;
+    retired.range = state.geometry;
+    for (sys::AssetId member : *cell->textures())
+    {
+        const sys::AssetId key = resolveTexture(mount, member);
+        const auto it = mount.textureRefs.find(key);
+        if (it == mount.textureRefs.end() || --it->second > 0)
+            continue;
+        mount.textureRefs.erase(it);
+        std::erase(mount.textures, key);
+        if (rhi::ResourceViewPtr view = releaseTexture(mount, key))
+            retired.views.emplace_back(std::move(view));
+    }
+
+    state = CellState();
+}
+
+void ResourceManager::streamCells(const rhi::DevicePtr& device, const glm::vec3& eye)
+{
+    bool changed = false;
+    std::vector<std::tuple<float, MountedArchive*, uint32_t>> pending;
+    for (MountedArchive& mount : m_archives)
+    {
+        const float cellSize = mount.archive->cell_size();
+        bool dropped = false;
+        for (uint32_t i = 0; i < mount.cells.size(); ++i)
+        {
+            const pak::Cell* cell = mount.archive->cells()->Get(i);
+            const glm::vec3 bbMin(cell->bbmin()->x(), cell->bbmin()->y(), cell->bbmin()->z());
+            const glm::vec3 bbMax(cell->bbmax()->x(), cell->bbmax()->y(), cell->bbmax()->z());
+            const float distance = glm::distance(eye, glm::clamp(eye, bbMin, bbMax));
+            // Cells still loading are left alone until their reads complete
+            const CellState& state = mount.cells[i];
+            if (state.pending)
+                continue;
+            if (!state.resident && distance < kLoadCells * cellSize)
+                pending.emplace_back(distance, &mount, i);
+            else if (state.resident && distance > kUnloadCells * cellSize)
             {
-            case pak::BufferType_Index:
-                m_storage->requestLoadBuffer(l, f, m_meshBuffers.m_indexBuffer, entry->byte_length(),
-                                             entry->byte_offset());
-                break;
-            case pak::BufferType_Position:
-                m_storage->requestLoadBuffer(l, f, m_meshBuffers.m_vertexBuffers[0], entry->byte_length(),
-                                             entry->byte_offset());
-                break;
-            case pak::BufferType_Texcoord:
-                m_storage->requestLoadBuffer(l, f, m_meshBuffers.m_vertexBuffers[1], entry->byte_length(),
-                                             entry->byte_offset());
-                break;
-            case pak::BufferType_Normal:
-                m_storage->requestLoadBuffer(l, f, m_meshBuffers.m_vertexBuffers[2], entry->byte_length(),
-                                             entry->byte_offset());
-                break;
-            case pak::BufferType_Tangent:
-                m_storage->requestLoadBuffer(l, f, m_meshBuffers.m_vertexBuffers[3], entry->byte_length(),
-                                             entry->byte_offset());
-                break;
+                unloadCell(mount, i);
+                dropped = true;
             }
         }
+
+        // Unloaded textures fall back to the placeholder before their views are retired
+        if (dropped)
+            m_meshBuffers.updateMaterials(mount.range, m_storage, mount.textureLayers, *mount.archive->materials());
+        changed |= dropped;
     }
 
-    m_storage->requestLoadTexture(l, m_table, resources);
-    coro::sync_wait(l);
-    m_storage->update();
+    std::ranges::sort(pending, {}, [](const auto& p) { return std::get<0>(p); });
+    if (pending.size() > kMaxCellLoads)
+        pending.resize(kMaxCellLoads);
+    for (const auto& [distance, mount, index] : pending)
+    {
+        if (!loadCell(device, *mount, index))
+            break;
+    }
 
-    m_meshBuffers.updateMeshes(*archive->meshes());
-    m_meshBuffers.updateMaterials(m_storage, *archive->materials());
-    m_meshBuffers.flushBuffer(device);
-    return true;
+    if (changed)
+        refreshInstances();
+}
+
+bool ResourceManager::reloadArchive(const rhi::DevicePtr& device, const fs::path& path)
+{
+    // A cooker may still be writing, only swap once every entry is on disk
+    std::vector<uint8_t> header;
+    const pak::PakArchive* archive = readHeader(path, header);
+    std::error_code ec;
+    const uint64_t fileSize = fs::file_size(path, ec);
+    if (archive == nullptr || ec.value())
+        return false;
+    for (const pak::PakEntry* entry : *archive->entries())
+    {
+        if (entry->byte_offset() + entry->byte_length() > fileSize)
+        {
+            log::warn("Truncated archive, reload skipped: {}", path.string());
+            return false;
+        }
+    }
+
+    return closeArchive(path) && openArchive(device, path);
+}
+
+void ResourceManager::pollLoads(const rhi::DevicePtr& device)
+{
+    // Latches are read before publishing, every texture counted down is then visible
+    bool textures = false;
+    bool instances = false;
+    const auto poll = [&](PendingLoad& load, bool& resident, MountedArchive& mount, uint32_t first, uint32_t count,
+                          const GeometryRange& geometry) {
+        if (!resident && load.geometry.is_ready())
+        {
+            m_meshBuffers.updateMeshes(mount.range, geometry, *mount.archive->meshes(), first, count);
+            resident = true;
+            instances = true;
+        }
+        const auto left = static_cast<int64_t>(load.textures.remaining());
+        if (left != load.texturesLeft)
+        {
+            load.texturesLeft = left;
+            textures = true;
+        }
+        return resident && load.textures.is_ready();
+    };
+
+    for (MountedArchive& mount : m_archives)
+    {
+        if (mount.queued)
+            loadArchive(device, mount);
+        if (mount.pending &&
+            poll(*mount.pending, mount.ready, mount, 0, residentMeshCount(mount.archive), mount.geometry))
+        {
+            mount.pending.reset();
+            log::info("Mounted {}", mount.path.filename().string());
+        }
+        std::erase_if(mount.handovers, [&](const std::unique_ptr<PendingLoad>& load) {
+            bool resident = true;
+            return poll(*load, resident, mount, 0, 0, mount.geometry);
+        });
+
+        for (uint32_t i = 0; i < mount.cells.size(); ++i)
+        {
+            CellState& cell = mount.cells[i];
+            const pak::Cell* entry = mount.archive->cells()->Get(i);
+            if (cell.pending &&
+                poll(*cell.pending, cell.resident, mount, entry->first_mesh(), entry->mesh_count(), cell.geometry))
+                cell.pending.reset();
+        }
+    }
+
+    // Other archives may use the landed textures too
+    if (textures)
+    {
+        m_storage->update();
+        for (const MountedArchive& mount : m_archives)
+        {
+            m_meshBuffers.updateMaterials(mount.range, m_storage, mount.textureLayers, *mount.archive->materials());
+            m_meshBuffers.updateImpostors(mount.range, m_storage, mount.archive->impostors());
+        }
+    }
+    if (instances)
+        refreshInstances();
+}
+
+LoadProgress ResourceManager::getLoadProgress() const
+{
+    LoadProgress progress;
+    const auto add = [&](const std::unique_ptr<PendingLoad>& load) {
+        if (load == nullptr)
+            return;
+        progress.loads += 1;
+        progress.requests += load->requests;
+        progress.completed += load->requests - load->geometry.remaining() - load->textures.remaining();
+    };
+
+    for (const MountedArchive& mount : m_archives)
+    {
+        progress.loads += mount.queued;
+        add(mount.pending);
+        for (const CellState& cell : mount.cells)
+            add(cell.pending);
+        for (const std::unique_ptr<PendingLoad>& load : mount.handovers)
+            add(load);
+    }
+    return progress;
+}
+
+void ResourceManager::update(const rhi::DevicePtr& device)
+{
+    ++m_frame;
+    pollLoads(device);
+    std::erase_if(m_retired, [this](const RetiredArchive& retired) {
+        if (retired.frame > m_frame)
+            return false;
+        std::lock_guard lock = m_table->lock();
+        for (const rhi::ResourceViewPtr& view : retired.views)
+            m_table->freeBindlessIndex(view->getBindlessIndex());
+        m_meshBuffers.release(retired.range);
+        return true;
+    });
+
+    if (!m_hotReload || m_frame % kPollInterval != 0)
+        return;
+
+    std::vector<fs::path> modified;
+    for (MountedArchive& mount : m_archives)
+    {
+        std::error_code ec;
+        const fs::file_time_type writeTime = fs::last_write_time(mount.path, ec);
+        if (ec.value() || writeTime == mount.writeTime)
+            continue;
+        // Not retried until the next write if the new file is rejected
+        mount.writeTime = writeTime;
+        modified.emplace_back(mount.path);
+    }
+
+    for (const fs::path& path : modified)
+    {
+        log::info("Reloading {}", path.filename().string());
+        reloadArchive(device, path);
+    }
+}
+
+std::vector<DrawInstance> ResourceManager::gatherInstances() const
+{
+    std::vector<DrawInstance> instances;
+    for (const MountedArchive& mount : m_archives)
+    {
+        // Cell instances may draw resident meshes too, nothing shows before those land
+        if (!mount.ready)
+            continue;
+
+        const auto append = [&](uint32_t first, uint32_t count) {
+            for (uint32_t i = first; i < first + count; ++i)
+            {
+                const pak::Instance* inst = mount.archive->instances()->Get(i);
+                DrawInstance& drawInst = instances.emplace_back();
+                drawInst.model = glm::make_mat4(inst->transform()->data());
+                drawInst.skinIndex = mount.range.firstSkin + inst->skin_id();
+                drawInst.meshIndex = mount.range.firstMesh + inst->mesh_id();
+            }
+        };
+
+        if (mount.cells.empty())
+            append(0, mount.archive->instances()->size());
+        for (uint32_t i = 0; i < mount.cells.size(); ++i)
+        {
+            const pak::Cell* cell = mount.archive->cells()->Get(i);
+            if (mount.cells[i].resident)
+                append(cell->first_instance(), cell->instance_count());
+        }
+    }
+    return instances;
+}
+
+void ResourceManager::refreshInstances()
+{
+    const std::vector<DrawInstance> instances = gatherInstances();
+    for (RenderMeshList& meshList : m_renderMeshList)
+        meshList.replaceInstances(instances);
 }
 
 RenderMeshList* ResourceManager::createRenderMeshList(const rhi::DevicePtr& device)
 {
+    // Room for every cell of the partitioned archives to be resident at once
+    uint32_t capacity = 0;
+    for (const MountedArchive& mount : m_archives)
+        capacity += mount.archive->instances()->size();
+
     RenderMeshList& meshList = m_renderMeshList.emplace_back();
-    meshList.installStaticScene(device, *m_archive->instances());
+    meshList.installStaticScene(device, gatherInstances(), capacity);
     meshList.setMeshBuffers(&m_meshBuffers);
     return &meshList;
 }
@@ -11,27 +11,144 @@
 #include "rhi/storage.hpp"
 #include "mesh_list.hpp"
 #include "mesh.hpp"
+#include "virtual_texture.hpp"
+
+#include <deque>
 
 namespace ler::render
 {
 using PathHashMap = std::unordered_map<fs::path, std::string, sys::PathHash, sys::PathEqual>;
+
+// Reads in flight for an archive or a cell, polled once per frame
+struct PendingLoad
+{
+    PendingLoad(int64_t buffers, int64_t textures)
+        : geometry(buffers), textures(textures), requests(buffers + textures), texturesLeft(textures)
+    {
+    }
+
+    coro::latch geometry;
+    coro::latch textures;
+    sys::CancelToken token = sys::CancelToken::create();
+    int64_t requests = 0;
+    int64_t texturesLeft = 0; // Last count seen, a change means new textures to bind
+    std::vector<sys::AssetId> textureKeys; // Restarted by another owner when the load is cancelled
+};
+
+struct LoadProgress
+{
+    uint32_t loads = 0;
+    uint64_t requests = 0;
+    uint64_t completed = 0;
+};
+
+struct CellState
+{
+    bool resident = false; // Geometry landed, instances are drawn
+    GeometryRange geometry; // Index and vertex space only, IDs belong to the archive range
+    std::unique_ptr<PendingLoad> pending;
+};
+
+struct MountedArchive
+{
+    fs::path path;
+    std::vector<uint8_t> header; // Backs archive
+    const pak::PakArchive* archive = nullptr;
+    rhi::ReadOnlyFilePtr file;
+    GeometryRange range;
+    GeometryRange geometry; // Index and vertex space of the resident meshes
+    std::vector<sys::AssetId> textures; // Streamed textures
+    fs::file_time_type writeTime;
+    bool ready = false; // Resident geometry landed
+    bool queued = false; // Waiting for the geometry heap to have room, loads from update()
+    std::vector<sys::AssetId> queuedTextures; // Textures it loads itself, decided when it was opened
+    std::unique_ptr<PendingLoad> pending;
+    std::vector<std::unique_ptr<PendingLoad>> handovers; // Shared textures left behind by a closed archive
+
+    std::array<const pak::PakEntry*, 5> buffers = {}; // Indexed by pak::BufferType
+    std::unordered_map<sys::AssetId, const pak::PakEntry*> textureEntries;
+    TextureLayerMap textureLayers; // Small textures packed into an array entry
+    std::vector<sys::AssetId> virtualTextures; // Paged through the virtual texture cache, never loaded whole
+    // Partitioned archives only, textures are counted by the resident cells using them
+    std::vector<CellState> cells;
+    std::unordered_map<sys::AssetId, uint32_t> textureRefs;
+};
+
+struct MeshSpan;
+
+// Resources of a closed archive or cell, kept until no frame in flight can reference them
+struct RetiredArchive
+{
+    uint64_t frame = 0;
+    GeometryRange range;
+    std::vector<rhi::ResourceViewPtr> views;
+};
+
 class ResourceManager
 {
   public:
-    void setup(const rhi::StoragePtr& storage, const rhi::BindlessTablePtr& table);
+    void setup(const rhi::DevicePtr& device, const rhi::StoragePtr& storage, const rhi::BindlessTablePtr& table);
+    // Mounts an archive next to the ones already open, its mesh and material IDs are rebased.
+    // Returns once the reads are queued, instances show up from update() as their geometry lands.
     bool openArchive(const rhi::DevicePtr& device, const fs::path& path);
+    // Removes the instances at once, textures and geometry are released a few frames later
+    bool closeArchive(const fs::path& path);
+    // Swaps in an archive re-cooked on disk, the old one stays mounted if the new one is unreadable
+    bool reloadArchive(const rhi::DevicePtr& device, const fs::path& path);
+    // Once per frame: binds landed data, retires closed archives and polls for modified ones
+    void update(const rhi::DevicePtr& device);
+    [[nodiscard]] LoadProgress getLoadProgress() const;
+    void setHotReload(bool enable) { m_hotReload = enable; }
+    // Loads the cells of partitioned archives around the eye and drops the ones left far behind
+    void streamCells(const rhi::DevicePtr& device, const glm::vec3& eye);
+    // Static instances of every mounted archive
     RenderMeshList* createRenderMeshList(const rhi::DevicePtr& device);
     [[nodiscard]] MeshBuffers& getMeshBuffers() { return m_meshBuffers; }
+    [[nodiscard]] VirtualTextureCache& getVirtualTextures() { return m_virtualTextures; }
+    // Global mesh and material indices of mounted assets, from any thread
+    [[nodiscard]] std::optional<uint32_t> findMesh(sys::AssetId id) const { return m_meshIds.find(id); }
+    [[nodiscard]] std::optional<uint32_t> findMaterial(sys::AssetId id) const { return m_materialIds.find(id); }
 
   private:
     rhi::StoragePtr m_storage;
     rhi::BindlessTablePtr m_table;
-    std::vector<uint8_t> m_buffer;
-    const pak::PakArchive* m_archive = nullptr;
-    std::vector<RenderMeshList> m_renderMeshList;
+    std::vector<MountedArchive> m_archives;
+    std::deque<RenderMeshList> m_renderMeshList;
+    std::vector<RetiredArchive> m_retired;
     MeshBuffers m_meshBuffers;
+    VirtualTextureCache m_virtualTextures;
+    rhi::TexturePtr m_placeholder;
+    rhi::ResourceViewPtr m_placeholderView;
+    sys::AssetMap<uint32_t> m_meshIds;
+    sys::AssetMap<uint32_t> m_materialIds;
+    uint64_t m_frame = 0;
+    bool m_hotReload = false;
 
-    const pak::PakArchive* readHeader(const fs::path& path);
+    [[nodiscard]] std::vector<DrawInstance> gatherInstances() const;
+    void refreshInstances();
+    std::unique_ptr<PendingLoad> startLoad(std::vector<rhi::TextureStreamingMetadata> textures,
+                                           std::vector<rhi::BufferStreamingMetadata> buffers);
+    static void cancelLoad(PendingLoad& load);
+    void handOverTextures(const MountedArchive& closed, const std::vector<sys::AssetId>& keys);
+    [[nodiscard]] std::vector<rhi::BufferStreamingMetadata> geometryRequests(const MountedArchive& mount,
+                                                                           const MeshSpan& span,
+                                                                           const GeometryRange& range) const;
+    [[nodiscard]] bool isGeometryLoading() const;
+    bool reserveGeometry(const rhi::DevicePtr& device, uint64_t indexCount, uint64_t vertexCount);
+    bool loadArchive(const rhi::DevicePtr& device, MountedArchive& mount);
+    void pollLoads(const rhi::DevicePtr& device);
+    bool loadCell(const rhi::DevicePtr& device, MountedArchive& mount, uint32_t index);
+    void unloadCell(MountedArchive& mount, uint32_t index);
+    [[nodiscard]] bool isTextureShared(const MountedArchive& mount, sys::AssetId id) const;
+    rhi::ResourceViewPtr releaseTexture(const MountedArchive& mount, sys::AssetId id);
+    void registerAssets(const MountedArchive& mount);
+    void unregisterAssets(const MountedArchive& mount);
+    static const pak::PakArchive* readHeader(const fs::path& path, std::vector<uint8_t>& buffer);
     static constexpr std::string_view kHeader = "LEPK";
+    static constexpr uint64_t kPollInterval = 60; // Frames between two modification checks
+    // Cells load within kLoadCells cell sizes of the eye and unload past kUnloadCells, the gap avoids thrashing
+    static constexpr float kLoadCells = 1.5f;
+    static constexpr float kUnloadCells = 2.5f;
+    static constexpr uint32_t kMaxCellLoads = 2; // Per frame, nearest first
 };
 } // namespace ler::render
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "telemetry.hpp"
+
+namespace ler::render
+{
+// Backends only report what they have, a missing field reads as an empty object
+static const json& field(const json& j, const char* key)
+{
+    static const json kEmpty = json::object();
+    if (!j.is_object())
+        return kEmpty;
+    const auto it = j.find(key);
+    return it != j.end() && it->is_object() ? *it : kEmpty;
+}
+
+void TelemetryPanel::create(const rhi::DevicePtr& device, const rhi::SwapChainPtr& swapChain)
+{
+    m_storage = device->getStorage();
+}
+
+void TelemetryPanel::drawHistogram(const char* label, const json& h)
+{
+    if (!h.is_object() || h.empty())
+        return;
+
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted(label);
+    ImGui::TableNextColumn();
+    ImGui::Text("%llu", h.value("count", 0ull));
+    for (const char* key : { "mean_us", "p50_us", "p99_us", "max_us" })
+    {
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", h.value(key, 0.0));
+    }
+}
+
+void TelemetryPanel::render(rhi::TexturePtr& backBuffer, rhi::CommandPtr& command)
+{
+    const double now = ImGui::GetTime();
+    if (m_telemetry.is_null() || now - m_lastRefresh >= kRefreshPeriod)
+    {
+        m_telemetry = m_storage->getTelemetry();
+        if (!m_telemetry.is_object())
+            m_telemetry = json::object();
+        const uint64_t bytes = field(m_telemetry, "io").value("bytes_read", 0ull);
+        if (m_lastRefresh > 0.0)
+            m_throughput = static_cast<double>(bytes - m_lastBytes) / (now - m_lastRefresh);
+        m_lastBytes = bytes;
+        m_lastRefresh = now;
+    }
+
+    ImGui::Begin("Streaming", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+
+    const json& io = field(m_telemetry, "io");
+    if (!io.empty())
+    {
+        const json& queueDepth = field(io, "queue_depth");
+        ImGui::SeparatorText("IoService");
+        ImGui::Text("Backend: %s", io.value("backend", std::string("Unknown")).c_str());
+        ImGui::Text("Throughput: %.1f MB/s", m_throughput / 1e6);
+        ImGui::Text("Read: %.1f MB in %llu requests (%llu batches)",
+                    static_cast<double>(io.value("bytes_read", 0ull)) / 1e6, io.value("requests", 0ull),
+                    io.value("batches", 0ull));
+        ImGui::Text("Queue depth: %lld (peak %lld)", queueDepth.value("value", 0ll), queueDepth.value("peak", 0ll));
+        ImGui::Text("Cancelled: %llu, Deadline missed: %llu", io.value("cancelled", 0ull),
+                    io.value("deadline_missed", 0ull));
+    }
+
+    const json& staging = field(m_telemetry, "staging");
+    const json& inUse = field(staging, "in_use");
+    ImGui::SeparatorText("Staging");
+    ImGui::Text("Slots in use: %lld / %d (peak %lld)", inUse.value("value", 0ll), staging.value("count", 0),
+                inUse.value("peak", 0ll));
+    ImGui::Text("Acquired: %llu, Spins: %llu", staging.value("acquired", 0ull), staging.value("spins", 0ull));
+    ImGui::Text("Textures loaded: %llu", m_telemetry.value("textures_loaded", 0ull));
+
+    ImGui::SeparatorText("Latency");
+    if (ImGui::BeginTable("latency", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        for (const char* header : { "", "count", "mean us", "p50 us", "p99 us", "max us" })
+            ImGui::TableSetupColumn(header);
+        ImGui::TableHeadersRow();
+
+        drawHistogram("IO queue wait", field(io, "queue_wait"));
+        drawHistogram("IO service", field(io, "service_time"));
+        drawHistogram("IO batch", field(io, "batch_latency"));
+        drawHistogram("Staging wait", field(staging, "wait"));
+        drawHistogram("Staging hold", field(staging, "hold"));
+        drawHistogram("Transfer submit", field(field(m_telemetry, "transfer_queue"), "submit_and_wait"));
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+} // namespace ler::render
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "rhi/rhi.hpp"
+
+namespace ler::render
+{
+/// @brief ImGui window showing the streaming counters and latency histograms
+class TelemetryPanel : public rhi::IRenderPass
+{
+  public:
+    void create(const rhi::DevicePtr& device, const rhi::SwapChainPtr& swapChain) override;
+    void render(rhi::TexturePtr& backBuffer, rhi::CommandPtr& command) override;
+
+  private:
+    static void drawHistogram(const char* label, const json& h);
+
+    // Telemetry is sampled at a fixed rate to keep throughput readable
+    static constexpr double kRefreshPeriod = 0.5;
+
+    rhi::StoragePtr m_storage;
+    json m_telemetry;
+    double m_lastRefresh = 0.0;
+    uint64_t m_lastBytes = 0;
+    double m_throughput = 0.0;
+};
+} // namespace ler::render
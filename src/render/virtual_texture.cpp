@@ -0,0 +1,433 @@
+#include "virtual_texture.hpp"
+
+namespace ler::render
+{
+void VirtualTextureCache::setup(const rhi::DevicePtr& device, const rhi::StoragePtr& storage,
+                                const rhi::BindlessTablePtr& table)
+{
+    m_storage = storage;
+    m_table = table;
+    m_api = device->getGraphicsAPI();
+
+    m_indirection.assign(kMaxEntries, kNotResident);
+    m_slots.assign(kMaxEntries, kNoSlot);
+    m_entryOwners.assign(kMaxEntries, 0);
+    m_feedback.assign(kMaxEntries, 0);
+    m_entryHeap.reset(kMaxEntries);
+    m_infos.assign(kMaxTextures, DrawVirtualTexture());
+    for (uint32_t i = kMaxTextures; i-- > 0;)
+        m_freeInfos.emplace_back(i);
+
+    rhi::BufferDesc desc;
+    desc.debugName = "VirtualTextureBuffer";
+    desc.stride = sizeof(DrawVirtualTexture);
+    desc.sizeInBytes = sizeof(DrawVirtualTexture) * kMaxTextures;
+    m_infoBuffer = device->createBuffer(desc);
+
+    desc.debugName = "IndirectionBuffer";
+    desc.stride = sizeof(uint32_t);
+    desc.sizeInBytes = sizeof(uint32_t) * kMaxEntries;
+    m_indirectionBuffer = device->createBuffer(desc);
+
+    desc.debugName = "FeedbackBuffer";
+    desc.isUAV = true;
+    m_feedbackBuffer = device->createBuffer(desc);
+
+    desc.debugName = "FeedbackReadBack";
+    desc.isUAV = false;
+    desc.isReadBack = true;
+    for (rhi::BufferPtr& readBack : m_readBacks)
+        readBack = device->createBuffer(desc);
+
+    // Pages are read straight into it when the device maps its local memory
+    desc = rhi::BufferDesc();
+    desc.debugName = "PageUploadBuffer";
+    desc.isDirectUpload = true;
+    desc.sizeInBytes = kPageStride * kMaxPageLoads;
+    m_uploadBuffer = device->createBuffer(desc);
+
+    m_infoView = m_table->createResourceView(m_infoBuffer);
+    m_indirectionView = m_table->createResourceView(m_indirectionBuffer);
+    m_feedbackView = m_table->createResourceView(m_feedbackBuffer);
+
+    rhi::CommandPtr command = device->createCommand(rhi::QueueType::Graphics);
+    command->fillBuffer(m_indirectionBuffer, kNotResident);
+    command->fillBuffer(m_feedbackBuffer, 0);
+    device->submitOneShot(command);
+}
+
+VirtualTextureCache::PhysicalCache& VirtualTextureCache::getCache(const rhi::DevicePtr& device, rhi::Format format)
+{
+    PhysicalCache& cache = m_caches[format];
+    if (cache.texture != nullptr)
+        return cache;
+
+    rhi::TextureDesc desc;
+    desc.format = format;
+    desc.width = kCachePages * kPageSize;
+    desc.height = kCachePages * kPageSize;
+    desc.debugName = "PageCache " + rhi::to_string(format);
+    cache.texture = device->createTexture(desc);
+    cache.view = m_table->createResourceView(cache.texture);
+    cache.owners.assign(kCachePages * kCachePages, kNoEntry);
+    cache.lastUsed.assign(kCachePages * kCachePages, 0);
+    return cache;
+}
+
+bool VirtualTextureCache::add(const rhi::DevicePtr& device, sys::AssetId id, const pak::PakEntry* entry,
+                              const rhi::ReadOnlyFilePtr& file, rhi::Format format)
+{
+    const pak::Texture* t = entry->resource_as_Texture();
+    if (t->page_size() != kPageSize || t->page_border() != kPageBorder || t->pages() == nullptr ||
+        t->pages()->size() == 0)
+    {
+        log::warn("[VirtualTexture] Unsupported page layout: {}", t->filename()->str());
+        return false;
+    }
+
+    // Pages are cut along 4x4 blocks, their byte length is derived from the block layout
+    const rhi::FormatBlockInfo block = rhi::formatToBlockInfo(format);
+    if (block.blockWidth != 4 || block.blockHeight != 4)
+    {
+        log::warn("[VirtualTexture] Unsupported page format: {}", t->filename()->str());
+        return false;
+    }
+
+    if (const auto it = m_textures.find(id); it != m_textures.end())
+    {
+        ++it->second.refs;
+        return true;
+    }
+
+    const pak::VirtualMip* tail = t->pages()->Get(t->pages()->size() - 1);
+    const uint32_t count = tail->first_page() + tail->pages_x() * tail->pages_y();
+    const size_t first = m_entryHeap.allocate(count);
+    if (first == sys::VariableSizeAllocator::InvalidOffset || m_freeInfos.empty())
+    {
+        if (first != sys::VariableSizeAllocator::InvalidOffset)
+            m_entryHeap.free(first, count);
+        log::error("[VirtualTexture] Table full, {} not loaded", t->filename()->str());
+        return false;
+    }
+
+    VirtualTexture& vt = m_textures[id];
+    for (const pak::VirtualMip* mip : *t->pages())
+        vt.mips.emplace_back(*mip);
+    vt.byteOffset = entry->byte_offset();
+    vt.file = file;
+    vt.format = format;
+    vt.index = m_freeInfos.back();
+    vt.firstEntry = static_cast<uint32_t>(first);
+    vt.entryCount = count;
+    vt.refs = 1;
+    m_freeInfos.pop_back();
+
+    std::fill_n(m_slots.begin() + first, count, kNoSlot);
+    std::fill_n(m_entryOwners.begin() + first, count, id);
+    rebuildIndirection(vt);
+
+    DrawVirtualTexture& info = m_infos[vt.index];
+    info.firstEntry = vt.firstEntry;
+    info.width = t->width();
+    info.height = t->height();
+    info.mipCount = t->pages()->size();
+    info.cache = getCache(device, format).view->getBindlessIndex();
+    info.indirection = m_indirectionView->getBindlessIndex();
+    info.feedback = m_feedbackView->getBindlessIndex();
+    m_infosDirty = true;
+
+    // Coarser pages stand in for the missing ones, the tail page has no parent
+    m_pinned.emplace_back(vt.firstEntry + count - 1);
+    return true;
+}
+
+void VirtualTextureCache::remove(sys::AssetId id)
+{
+    const auto it = m_textures.find(id);
+    if (it == m_textures.end() || --it->second.refs > 0)
+        return;
+
+    // Pages still loading give their slot back as they land
+    const VirtualTexture& vt = it->second;
+    PhysicalCache& cache = m_caches.at(vt.format);
+    for (uint32_t entry = vt.firstEntry; entry < vt.firstEntry + vt.entryCount; ++entry)
+    {
+        if (m_slots[entry] < kLoading)
+        {
+            cache.owners[m_slots[entry]] = kNoEntry;
+            m_stats.residentPages.sub();
+        }
+        m_slots[entry] = kNoSlot;
+        m_entryOwners[entry] = 0;
+    }
+    std::erase_if(m_pinned,
+                  [&](uint32_t entry) { return entry >= vt.firstEntry && entry < vt.firstEntry + vt.entryCount; });
+
+    m_entryHeap.free(vt.firstEntry, vt.entryCount);
+    m_infos[vt.index] = DrawVirtualTexture();
+    m_freeInfos.emplace_back(vt.index);
+    m_infosDirty = true;
+    m_textures.erase(it);
+}
+
+std::optional<uint32_t> VirtualTextureCache::find(sys::AssetId id) const
+{
+    const auto it = m_textures.find(id);
+    if (it == m_textures.end())
+        return std::nullopt;
+    return it->second.index;
+}
+
+uint32_t VirtualTextureCache::findMip(const VirtualTexture& vt, uint32_t entry)
+{
+    const uint32_t page = entry - vt.firstEntry;
+    uint32_t mip = 0;
+    while (mip + 1 < vt.mips.size() && vt.mips[mip + 1].first_page() <= page)
+        ++mip;
+    return mip;
+}
+
+uint32_t VirtualTextureCache::packEntry(uint32_t slot, uint32_t mip) const
+{
+    return slot % kCachePages | slot / kCachePages << 8 | mip << 16;
+}
+
+void VirtualTextureCache::rebuildIndirection(VirtualTexture& vt)
+{
+    // Coarse to fine, a missing page shows what its parent shows
+    for (auto m = static_cast<uint32_t>(vt.mips.size()); m-- > 0;)
+    {
+        const pak::VirtualMip* mip = &vt.mips[m];
+        const pak::VirtualMip* parent = m + 1 < vt.mips.size() ? &vt.mips[m + 1] : nullptr;
+        for (uint32_t py = 0; py < mip->pages_y(); ++py)
+        {
+            for (uint32_t px = 0; px < mip->pages_x(); ++px)
+            {
+                const uint32_t entry = vt.firstEntry + mip->first_page() + py * mip->pages_x() + px;
+                if (m_slots[entry] < kLoading)
+                    m_indirection[entry] = packEntry(m_slots[entry], m);
+                else if (parent != nullptr)
+                {
+                    const uint32_t x = std::min<uint32_t>(px / 2, parent->pages_x() - 1);
+                    const uint32_t y = std::min<uint32_t>(py / 2, parent->pages_y() - 1);
+                    const uint32_t up = vt.firstEntry + parent->first_page() + y * parent->pages_x() + x;
+                    m_indirection[entry] = m_indirection[up];
+                }
+                else
+                    m_indirection[entry] = kNotResident;
+            }
+        }
+    }
+    vt.dirty = true;
+}
+
+uint32_t VirtualTextureCache::allocateSlot(PhysicalCache& cache)
+{
+    // A free slot, else the resident page wanted the longest time ago
+    uint32_t victim = kNoSlot;
+    uint64_t oldest = m_frame;
+    for (uint32_t slot = 0; slot < cache.owners.size(); ++slot)
+    {
+        const uint32_t entry = cache.owners[slot];
+        if (entry == kNoEntry)
+            return slot;
+
+        const VirtualTexture& vt = m_textures.at(m_entryOwners[entry]);
+        const bool pinned = entry == vt.firstEntry + vt.entryCount - 1;
+        if (!pinned && m_slots[entry] == slot && cache.lastUsed[slot] < oldest)
+        {
+            victim = slot;
+            oldest = cache.lastUsed[slot];
+        }
+    }
+
+    if (victim != kNoSlot)
+    {
+        const uint32_t entry = cache.owners[victim];
+        VirtualTexture& vt = m_textures.at(m_entryOwners[entry]);
+        m_slots[entry] = kNoSlot;
+        cache.owners[victim] = kNoEntry;
+        rebuildIndirection(vt);
+        m_stats.evictions.add();
+        m_stats.residentPages.sub();
+    }
+    return victim;
+}
+
+void VirtualTextureCache::landPages(const rhi::CommandPtr& cmd)
+{
+    if (m_pending == nullptr || !m_pending->latch.is_ready())
+        return;
+
+    std::unordered_map<rhi::Format, std::vector<rhi::Subresource>> regions;
+    for (size_t i = 0; i < m_pending->pages.size(); ++i)
+    {
+        const PendingPages::Page& page = m_pending->pages[i];
+        const auto it = m_textures.find(page.texture);
+        if (it == m_textures.end() || m_entryOwners[page.entry] != page.texture || m_slots[page.entry] != kLoading)
+        {
+            // Texture removed while the page was read
+            m_caches.at(page.format).owners[page.slot] = kNoEntry;
+            continue;
+        }
+
+        VirtualTexture& vt = it->second;
+        const rhi::FormatBlockInfo block = rhi::formatToBlockInfo(vt.format);
+        rhi::Subresource& sub = regions[vt.format].emplace_back();
+        sub.offset = i * kPageStride;
+        sub.x = page.slot % kCachePages * kPageSize;
+        sub.y = page.slot / kCachePages * kPageSize;
+        sub.width = kPageSize;
+        sub.height = kPageSize;
+        // Vulkan copies rows given in texels, D3D12 and Metal in bytes
+        sub.rowPitch =
+            m_api == rhi::GraphicsAPI::VULKAN ? kPageSize : kPageSize / block.blockWidth * block.blockSizeByte;
+
+        m_slots[page.entry] = page.slot;
+        m_caches.at(vt.format).lastUsed[page.slot] = m_frame;
+        rebuildIndirection(vt);
+        m_stats.pagesLoaded.add();
+        m_stats.residentPages.add();
+    }
+
+    std::vector<rhi::TextureUpload> uploads;
+    for (const auto& [format, subresources] : regions)
+        uploads.emplace_back(m_uploadBuffer, m_caches.at(format).texture, subresources);
+    if (!uploads.empty())
+        cmd->copyBufferToTextures(uploads);
+
+    // Copies read the upload buffer until this frame completes
+    m_uploadFrame = m_frame + rhi::ISwapChain::FrameCount;
+    m_pending.reset();
+}
+
+void VirtualTextureCache::readFeedback()
+{
+    // Written FrameCount frames ago, the swap chain waited for that frame before recording this one
+    m_readBacks[m_frame % rhi::ISwapChain::FrameCount]->downloadToMemory(m_feedback.data(),
+                                                                         m_feedback.size() * sizeof(uint32_t));
+
+    m_requests.clear();
+    for (uint32_t entry = 0; entry < kMaxEntries; ++entry)
+    {
+        if (m_feedback[entry] == 0 || m_entryOwners[entry] == 0)
+            continue;
+
+        const VirtualTexture& vt = m_textures.at(m_entryOwners[entry]);
+        const uint32_t slot = m_slots[entry];
+        if (slot < kLoading)
+            m_caches.at(vt.format).lastUsed[slot] = m_frame;
+        else if (slot == kNoSlot)
+            m_requests.emplace_back(findMip(vt, entry), entry);
+    }
+}
+
+void VirtualTextureCache::requestPages()
+{
+    if (m_pending != nullptr || m_frame < m_uploadFrame)
+        return;
+
+    // Tail pages first, then coarse to fine: every page shows up sooner blurred than late
+    std::ranges::sort(m_requests, std::greater());
+    std::vector<uint32_t> entries;
+    for (uint32_t entry : m_pinned)
+    {
+        if (m_slots[entry] == kNoSlot)
+            entries.emplace_back(entry);
+    }
+    for (uint32_t entry : std::views::values(m_requests))
+        entries.emplace_back(entry);
+    m_pinned.clear();
+
+    std::vector<PendingPages::Page> pages;
+    for (uint32_t entry : entries)
+    {
+        if (m_slots[entry] != kNoSlot)
+            continue;
+
+        VirtualTexture& vt = m_textures.at(m_entryOwners[entry]);
+        const bool pinned = entry == vt.firstEntry + vt.entryCount - 1;
+        const uint32_t slot = pages.size() < kMaxPageLoads ? allocateSlot(m_caches.at(vt.format)) : kNoSlot;
+        if (slot == kNoSlot)
+        {
+            // Tail pages are retried until they find a slot
+            if (pinned)
+                m_pinned.emplace_back(entry);
+            m_stats.requestsDropped.add();
+            continue;
+        }
+
+        m_caches.at(vt.format).owners[slot] = entry;
+        m_slots[entry] = kLoading;
+        pages.emplace_back(m_entryOwners[entry], vt.format, entry, slot);
+    }
+
+    if (pages.empty())
+        return;
+
+    m_pending = std::make_unique<PendingPages>(static_cast<int64_t>(pages.size()));
+    m_pending->pages = std::move(pages);
+    for (size_t i = 0; i < m_pending->pages.size(); ++i)
+    {
+        const PendingPages::Page& page = m_pending->pages[i];
+        const VirtualTexture& vt = m_textures.at(page.texture);
+        const rhi::FormatBlockInfo block = rhi::formatToBlockInfo(vt.format);
+        rhi::BufferStreamingMetadata m;
+        m.buffer = m_uploadBuffer;
+        m.bufferOffset = i * kPageStride;
+        m.byteOffset = vt.byteOffset + (page.entry - vt.firstEntry) * kPageStride;
+        m.byteLength = (kPageSize / block.blockWidth) * (kPageSize / block.blockHeight) * block.blockSizeByte;
+        m.file = vt.file;
+        m_storage->requestLoadBuffer(m_pending->latch, m);
+    }
+}
+
+void VirtualTextureCache::flush(const rhi::CommandPtr& cmd)
+{
+    ++m_frame;
+    if (m_textures.empty() && m_pending == nullptr)
+        return;
+
+    landPages(cmd);
+    if (m_frame > rhi::ISwapChain::FrameCount)
+        readFeedback();
+    requestPages();
+
+    for (VirtualTexture& vt : std::views::values(m_textures))
+    {
+        if (!vt.dirty)
+            continue;
+        cmd->syncBuffer(m_indirectionBuffer, m_indirection.data() + vt.firstEntry, sizeof(uint32_t) * vt.entryCount,
+                        sizeof(uint32_t) * vt.firstEntry);
+        vt.dirty = false;
+    }
+    if (m_infosDirty)
+    {
+        cmd->syncBuffer(m_infoBuffer, m_infos.data(), sizeof(DrawVirtualTexture) * m_infos.size());
+        m_infosDirty = false;
+    }
+
+    // Pages wanted by the previous frame, read back once this frame completed
+    const rhi::BufferPtr& readBack = m_readBacks[m_frame % rhi::ISwapChain::FrameCount];
+    cmd->addBufferBarrier(m_feedbackBuffer, rhi::CopySrc);
+    cmd->copyBuffer(m_feedbackBuffer, readBack, m_feedbackBuffer->sizeInBytes(), 0);
+    cmd->addBufferBarrier(m_feedbackBuffer, rhi::CopyDest);
+    cmd->fillBuffer(m_feedbackBuffer, 0);
+    cmd->addBufferBarrier(m_feedbackBuffer, rhi::UnorderedAccess);
+}
+
+uint32_t VirtualTextureCache::getBindlessIndex() const
+{
+    return m_infoView->getBindlessIndex();
+}
+
+json VirtualTextureCache::getStats() const
+{
+    return json{ { "textures", m_textures.size() },
+                 { "caches", m_caches.size() },
+                 { "pages_loaded", m_stats.pagesLoaded.get() },
+                 { "evictions", m_stats.evictions.get() },
+                 { "requests_dropped", m_stats.requestsDropped.get() },
+                 { "resident_pages", m_stats.residentPages.get() } };
+}
+} // namespace ler::render
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "archive_generated.h"
+#include "draw.hpp"
+#include "rhi/rhi.hpp"
+#include "sys/mem.hpp"
+
+#include <unordered_map>
+
+namespace ler::render
+{
+// Page reads in flight, their slots are reserved until they land
+struct PendingPages
+{
+    explicit PendingPages(int64_t count) : latch(count)
+    {
+    }
+
+    struct Page
+    {
+        sys::AssetId texture = 0;
+        rhi::Format format = rhi::Format::UNKNOWN;
+        uint32_t entry = 0;
+        uint32_t slot = 0;
+    };
+
+    coro::latch latch;
+    std::vector<Page> pages;
+};
+
+/// @brief Streams the pages of virtual textures into fixed size caches.
+/// Each format owns one physical texture of kCachePages x kCachePages pages. Shaders find the pages through an
+/// indirection buffer that falls back to the nearest resident coarser mip, and flag the pages they wanted in a
+/// feedback buffer. The feedback is read back FrameCount frames later to request the missing pages, the least
+/// recently wanted ones make room.
+class VirtualTextureCache
+{
+  public:
+    void setup(const rhi::DevicePtr& device, const rhi::StoragePtr& storage, const rhi::BindlessTablePtr& table);
+    // Shares the texture when it is already registered, false when its layout or format does not fit the cache
+    bool add(const rhi::DevicePtr& device, sys::AssetId id, const pak::PakEntry* entry,
+             const rhi::ReadOnlyFilePtr& file, rhi::Format format);
+    void remove(sys::AssetId id);
+    // Index of the DrawVirtualTexture of a registered texture
+    [[nodiscard]] std::optional<uint32_t> find(sys::AssetId id) const;
+    // Once per frame before the passes: lands pages, requests the missing ones and resets the feedback
+    void flush(const rhi::CommandPtr& cmd);
+    [[nodiscard]] uint32_t getBindlessIndex() const;
+    [[nodiscard]] json getStats() const;
+
+    static constexpr uint32_t kPageSize = 256; // Texels per page side, borders included, as cut by lerPak
+    static constexpr uint32_t kPageBorder = 4;
+    static constexpr uint64_t kPageStride = 64 * 1024;
+    static constexpr uint32_t kCachePages = 16; // 4096x4096 texels per format, 16 MiB of BC7
+    static constexpr uint32_t kMaxTextures = 256;
+    static constexpr uint32_t kMaxEntries = 1 << 16; // Pages of every mip of every texture
+    static constexpr uint32_t kMaxPageLoads = 32;    // Per batch, one batch in flight
+
+  private:
+    struct VirtualTexture
+    {
+        // Copied out of the archive header, another archive sharing the texture may outlive it
+        std::vector<pak::VirtualMip> mips;
+        uint64_t byteOffset = 0;
+        rhi::ReadOnlyFilePtr file;
+        rhi::Format format = rhi::Format::UNKNOWN;
+        uint32_t index = 0;
+        uint32_t firstEntry = 0;
+        uint32_t entryCount = 0; // The last entry is the tail page, resident as long as the texture
+        uint32_t refs = 0;
+        bool dirty = false; // Indirection to upload
+    };
+
+    struct PhysicalCache
+    {
+        rhi::TexturePtr texture;
+        rhi::ResourceViewPtr view;
+        std::vector<uint32_t> owners;  // Entry held by each slot, kNoEntry when free
+        std::vector<uint64_t> lastUsed; // Last frame the page was wanted
+    };
+
+    struct Stats
+    {
+        sys::Counter pagesLoaded;
+        sys::Counter evictions;
+        sys::Counter requestsDropped; // Wanted pages left for a later batch
+        sys::Gauge residentPages;
+    };
+
+    static constexpr uint32_t kNoSlot = UINT32_MAX;
+    static constexpr uint32_t kLoading = UINT32_MAX - 1;
+    static constexpr uint32_t kNoEntry = UINT32_MAX;
+    static constexpr uint32_t kNotResident = UINT32_MAX;
+
+    [[nodiscard]] static uint32_t findMip(const VirtualTexture& vt, uint32_t entry);
+    [[nodiscard]] uint32_t packEntry(uint32_t slot, uint32_t mip) const;
+    PhysicalCache& getCache(const rhi::DevicePtr& device, rhi::Format format);
+    uint32_t allocateSlot(PhysicalCache& cache);
+    void rebuildIndirection(VirtualTexture& vt);
+    void landPages(const rhi::CommandPtr& cmd);
+    void readFeedback();
+    void requestPages();
+
+    rhi::StoragePtr m_storage;
+    rhi::BindlessTablePtr m_table;
+    rhi::GraphicsAPI m_api = rhi::GraphicsAPI::VULKAN;
+    std::unordered_map<sys::AssetId, VirtualTexture> m_textures;
+    std::unordered_map<rhi::Format, PhysicalCache> m_caches;
+
+    // Indexed by entry
+    std::vector<uint32_t> m_indirection;
+    std::vector<uint32_t> m_slots;
+    std::vector<sys::AssetId> m_entryOwners;
+    std::vector<uint32_t> m_feedback;
+    sys::VariableSizeAllocator m_entryHeap;
+
+    std::vector<DrawVirtualTexture> m_infos;
+    std::vector<uint32_t> m_freeInfos;
+    bool m_infosDirty = false;
+
+    rhi::BufferPtr m_infoBuffer;
+    rhi::BufferPtr m_indirectionBuffer;
+    rhi::BufferPtr m_feedbackBuffer;
+    rhi::BufferPtr m_uploadBuffer;
+    std::array<rhi::BufferPtr, rhi::ISwapChain::FrameCount> m_readBacks;
+    rhi::ResourceViewPtr m_infoView;
+    rhi::ResourceViewPtr m_indirectionView;
+    rhi::ResourceViewPtr m_feedbackView;
+
+    std::vector<uint32_t> m_pinned; // Tail pages to load first
+    std::vector<std::pair<uint32_t, uint32_t>> m_requests; // Mip and entry of the wanted pages
+    std::unique_ptr<PendingPages> m_pending;
+    uint64_t m_frame = 0;
+    uint64_t m_uploadFrame = 0; // The upload buffer is free again once this frame completed
+    Stats m_stats;
+};
+} // namespace ler::render
@@ -43,20 +43,10 @@ uint32_t CommonBindlessTable::newBindlessIndex()
 
 void CommonBindlessTable::freeBindlessIndex(uint32_t index)
 {
-    //std::lock_guard lock(m_mutex);
-    const uint32_t frameIndex{};
-    m_deferredFreeIndices[frameIndex].push_back(index);
-}
-
-void CommonBindlessTable::freeDeferredSlot(uint32_t frameIndex)
-{
-    //std::lock_guard lock(m_mutex);
-    for (uint32_t index : m_deferredFreeIndices[frameIndex])
-    {
-        --m_size;
-        m_freeList[m_size] = index;
-    }
-    m_deferredFreeIndices[frameIndex].clear();
+    // Caller holds lock() and knows no frame in flight still reads the slot
+    m_resources[index] = ResourcePtr();
+    --m_size;
+    m_freeList[m_size] = index;
 }
 
 bool CommonBindlessTable::setResource(const ResourcePtr& res, uint32_t slot)
@@ -87,6 +77,17 @@ ResourceViewPtr CommonBindlessTable::createResourceView(const ResourcePtr& res)
     return view;
 }
 
+void CommonBindlessTable::refreshTexture(const ITexture* texture)
+{
+    std::lock_guard lock(m_mutex);
+    for (uint32_t slot = 0; slot < kBindlessMax; ++slot)
+    {
+        const ResourcePtr& res = m_resources[slot];
+        if (std::holds_alternative<TexturePtr>(res) && std::get<TexturePtr>(res).get() == texture)
+            visitTexture(std::get<TexturePtr>(res), slot);
+    }
+}
+
 TexturePtr CommonBindlessTable::getTexture(uint32_t slot) const
 {
     const ResourcePtr& res = m_resources[slot];
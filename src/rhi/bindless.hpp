@@ -26,7 +26,8 @@ class CommonBindlessTable : public IBindlessTable
     virtual bool visitTexture(const TexturePtr& texture, uint32_t slot) = 0;
     virtual bool visitBuffer(const BufferPtr& buffer, uint32_t slot) = 0;
 
-    void freeDeferredSlot(uint32_t frameIndex);
+    // Rewrite every slot pointing to a texture whose image has been replaced
+    void refreshTexture(const ITexture* texture);
 
   private:
     bool setResource(const ResourcePtr& res, uint32_t slot);
@@ -37,6 +38,5 @@ class CommonBindlessTable : public IBindlessTable
     std::mutex m_mutex;
     uint32_t m_size = 0u;
     std::unique_ptr<uint32_t[]> m_freeList;
-    std::array<std::vector<uint32_t>, ISwapChain::FrameCount> m_deferredFreeIndices;
 };
 } // namespace ler::rhi
@@ -6,25 +6,92 @@
 
 namespace ler::rhi
 {
-ScratchBuffer::ScratchBuffer(IDevice* device)
+ScratchBuffer::ScratchBuffer(IDevice* device) : m_device(device)
 {
-    m_staging = device->createBuffer(m_capacity, true);
+    addPage(0, kPageSize);
 }
 
-uint64_t ScratchBuffer::allocate(uint32_t sizeInByte)
+BufferPtr& ScratchBuffer::addPage(size_t index, uint64_t sizeInBytes)
 {
-    uint64_t offset = m_size.fetch_add(sizeInByte);
-    assert(m_size < m_capacity);
-    return offset;
+    m_stats.capacity.add(static_cast<int64_t>(sizeInBytes));
+    return *m_pages.emplace(m_pages.begin() + static_cast<ptrdiff_t>(index),
+                            m_device->createBuffer(sizeInBytes, true));
+}
+
+ScratchBuffer::Allocation ScratchBuffer::allocate(uint64_t sizeInBytes)
+{
+    static constexpr uint64_t kAlignment = 16;
+    const uint64_t size = align(sizeInBytes, kAlignment);
+
+    std::lock_guard lock(m_mutex);
+    m_used += size;
+    if (m_offset + size <= m_pages[m_page]->sizeInBytes())
+    {
+        const uint64_t offset = std::exchange(m_offset, m_offset + size);
+        return { m_pages[m_page], offset };
+    }
+
+    // Current page is full, move to the next one or chain a new page
+    ++m_page;
+    m_offset = size;
+    if (m_page < m_pages.size() && m_pages[m_page]->sizeInBytes() >= size)
+        return { m_pages[m_page], 0 };
+
+    if (size > kPageSize)
+        m_stats.oversized.add();
+    m_stats.grows.add();
+    return { addPage(m_page, std::max(size, kPageSize)), 0 };
 }
 
 void ScratchBuffer::reset()
 {
-    m_size.store(0);
+    std::lock_guard lock(m_mutex);
+    m_stats.frameUsage.sub(m_stats.frameUsage.get());
+    m_stats.frameUsage.add(static_cast<int64_t>(m_used));
+
+    // Give back the pages no frame needed during the last window
+    m_windowPages = std::max(m_windowPages, m_page + 1);
+    if (++m_windowFrames >= kShrinkFrames)
+    {
+        while (m_pages.size() > m_windowPages)
+        {
+            m_stats.capacity.sub(static_cast<int64_t>(m_pages.back()->sizeInBytes()));
+            m_pages.pop_back();
+            m_stats.shrinks.add();
+        }
+        m_windowPages = 1;
+        m_windowFrames = 0;
+    }
+
+    m_page = 0;
+    m_offset = 0;
+    m_used = 0;
+}
+
+json ScratchBuffer::getStats() const
+{
+    std::lock_guard lock(m_mutex);
+    return json{ { "page_size", kPageSize },         { "pages", m_pages.size() },
+                 { "capacity", m_stats.capacity },   { "frame_usage", m_stats.frameUsage },
+                 { "grows", m_stats.grows },         { "shrinks", m_stats.shrinks },
+                 { "oversized", m_stats.oversized } };
+}
+
+std::vector<TexturePtr> IDevice::createTextures(std::span<const TextureDesc> descs)
+{
+    std::vector<TexturePtr> textures;
+    textures.reserve(descs.size());
+    for (const TextureDesc& desc : descs)
+        textures.emplace_back(createTexture(desc));
+    return textures;
 }
 
-const BufferPtr& ScratchBuffer::getBuffer() const
+void ICommand::copyBufferToTextures(std::span<const TextureUpload> uploads)
 {
-    return m_staging;
+    for (const TextureUpload& upload : uploads)
+    {
+        for (const Subresource& sub : upload.subresources)
+            copyBufferToTexture(upload.buffer, upload.texture, sub, nullptr);
+    }
 }
 } // namespace ler::rhi
\ No newline at end of file
@@ -214,7 +214,7 @@ void Command::clearColorImage(const TexturePtr& texture, const std::array<float,
 }
 
 void Command::copyBufferToTexture(const BufferPtr& buffer, const TexturePtr& texture, const Subresource& sub,
-                                  const unsigned char* pSrcData) const
+                                  const unsigned char* pSrcData)
 {
     auto* image = checked_cast<Texture*>(texture.get());
     auto* staging = checked_cast<Buffer*>(buffer.get());
@@ -232,9 +232,9 @@ void Command::copyBufferToTexture(const BufferPtr& buffer, const TexturePtr& tex
         layout.Footprint.Height = sub.height;
         layout.Footprint.RowPitch = sub.rowPitch;
         layout.Footprint.Format = image->desc.Format;
-        CD3DX12_TEXTURE_COPY_LOCATION Dst(image->handle, sub.index);
+        CD3DX12_TEXTURE_COPY_LOCATION Dst(image->handle, sub.index + sub.layer * image->desc.MipLevels);
         CD3DX12_TEXTURE_COPY_LOCATION Src(staging->handle, layout);
-        m_commandList->CopyTextureRegion(&Dst, 0, 0, 0, &Src, nullptr);
+        m_commandList->CopyTextureRegion(&Dst, sub.x, sub.y, 0, &Src, nullptr);
     }
     else
     {
@@ -256,7 +256,7 @@ void Command::copyBuffer(const BufferPtr& src, const BufferPtr& dst, uint64_t by
     m_commandList->CopyBufferRegion(buffDst->handle, dstOffset, buffSrc->handle, 0, byteSize);
 }
 
-void Command::fillBuffer(const BufferPtr& dst, uint32_t value) const
+void Command::fillBuffer(const BufferPtr& dst, uint32_t value)
 {
     ID3D12DescriptorHeap* heap = m_gpuHeap->heap();
     m_commandList->SetDescriptorHeaps(1, &heap);
@@ -269,23 +269,24 @@ void Command::fillBuffer(const BufferPtr& dst, uint32_t value) const
     m_commandList->ClearUnorderedAccessViewUint(gpuHandle, cpuHandle, buff->handle, clears.data(), 0, nullptr);
 }
 
-void Command::syncBuffer(const BufferPtr& dst, const void* src, uint64_t byteSize)
+void Command::syncBuffer(const BufferPtr& dst, const void* src, uint64_t byteSize, uint64_t dstOffset)
 {
     assert(queueType == QueueType::Graphics);
     const auto* buffDst = checked_cast<Buffer*>(dst.get());
 
     const std::unique_ptr<ScratchBuffer>& scratchBuffer = m_context.scratchBufferPool[m_context.frameIndex];
-    uint64_t offset = scratchBuffer->allocate(byteSize);
-    auto* buffer = static_cast<Buffer*>(scratchBuffer->getBuffer().get());
+    const ScratchBuffer::Allocation scratch = scratchBuffer->allocate(byteSize);
+    const uint64_t offset = scratch.offset;
+    auto* buffer = static_cast<Buffer*>(scratch.buffer.get());
     void* pMappedData;
-    if (buffer->staging() && buffer->sizeInBytes() >= byteSize && SUCCEEDED(buffer->handle->Map(0, nullptr, &pMappedData)))
+    if (buffer->staging() && buffer->sizeInBytes() >= offset + byteSize && SUCCEEDED(buffer->handle->Map(0, nullptr, &pMappedData)))
     {
         auto* pCursor = static_cast<std::byte*>(pMappedData);
         memcpy(pCursor + offset, src, byteSize);
         buffer->handle->Unmap(0, nullptr);
 
         addBufferBarrier(dst, CopyDest);
-        m_commandList->CopyBufferRegion(buffDst->handle, 0, buffer->handle, offset, byteSize);
+        m_commandList->CopyBufferRegion(buffDst->handle, dstOffset, buffer->handle, offset, byteSize);
     }
     else
         log::error("Failed to upload to Scratch Buffer");
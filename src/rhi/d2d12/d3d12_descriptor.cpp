@@ -146,8 +146,17 @@ bool BindlessTable::visitTexture(const TexturePtr& texture, uint32_t slot)
     D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
     srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
     srvDesc.Format = image->desc.Format;
-    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels = image->desc.MipLevels;
+    if (image->desc.DepthOrArraySize > 1)
+    {
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+        srvDesc.Texture2DArray.MipLevels = image->desc.MipLevels;
+        srvDesc.Texture2DArray.ArraySize = image->desc.DepthOrArraySize;
+    }
+    else
+    {
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Texture2D.MipLevels = image->desc.MipLevels;
+    }
 
     m_context.device->CreateShaderResourceView(image->handle, &srvDesc, CPUHandle);
     return true;
@@ -174,6 +174,20 @@ void Buffer::getUint(uint32_t* ptr) const
         log::error("Failed to upload to buffer");
 }
 
+void Buffer::downloadToMemory(void* dst, uint64_t byteSize) const
+{
+    void* pMappedData;
+    const D3D12_RANGE range = { 0, byteSize };
+    if (staging() && sizeInBytes() >= byteSize && SUCCEEDED(handle->Map(0, &range, &pMappedData)))
+    {
+        memcpy(dst, pMappedData, byteSize);
+        const D3D12_RANGE written = { 0, 0 };
+        handle->Unmap(0, &written);
+    }
+    else
+        log::error("Failed to read from buffer");
+}
+
 BufferPtr Device::createBuffer(uint64_t byteSize, bool staging)
 {
     auto buffer = std::make_shared<Buffer>();
@@ -208,7 +208,7 @@ coro::task<> Storage::makeMultiTextureTask(coro::latch& latch, BindlessTablePtr
 
             // uint32_t texIndex = table->allocate();
             TexturePtr texture = m_device->createTexture(desc);
-            result.emplace_back(table->createResourceView(texture), desc.debugName);
+            result.emplace_back(table->createResourceView(texture), sys::makeAssetId(desc.debugName));
             log::info("Load texture {:03}: {}", result.back().view->getBindlessIndex(), desc.debugName);
             // table->setResource(texture, texIndex);
 
@@ -249,7 +249,7 @@ coro::task<> Storage::makeMultiTextureTask(coro::latch& latch, BindlessTablePtr
         for (const TextureStreamingMetadata& metadata : textures)
         {
             TexturePtr texture = m_device->createTexture(metadata.desc);
-            result.emplace_back(table->createResourceView(texture), metadata.desc.debugName);
+            result.emplace_back(table->createResourceView(texture), metadata.assetId);
             log::info("Load texture {:03}: {}", result.back().view->getBindlessIndex(), metadata.desc.debugName);
 
             DSTORAGE_REQUEST request = {};
@@ -275,19 +275,18 @@ coro::task<> Storage::makeMultiTextureTask(coro::latch& latch, BindlessTablePtr
     co_return;
 }
 
-coro::task<> Storage::makeBufferTask(coro::latch& latch, ReadOnlyFilePtr file, BufferPtr buffer, uint64_t fileLength,
-                                     uint64_t fileOffset)
+coro::task<> Storage::makeBufferTask(coro::latch& latch, BufferStreamingMetadata metadata)
 {
-    auto* f = checked_cast<ReadOnlyFile*>(file.get());
+    auto* f = checked_cast<ReadOnlyFile*>(metadata.file.get());
 
     DSTORAGE_REQUEST request = {};
     request.Options.DestinationType = DSTORAGE_REQUEST_DESTINATION_BUFFER;
     request.Source.File.Source = f->handle.Get();
-    request.Source.File.Offset = fileOffset;
-    request.Source.File.Size = fileLength;
-    request.Destination.Buffer.Resource = checked_cast<Buffer*>(buffer.get())->handle;
-    request.Destination.Buffer.Offset = 0;
-    request.Destination.Buffer.Size = fileLength;
+    request.Source.File.Offset = metadata.byteOffset;
+    request.Source.File.Size = metadata.byteLength;
+    request.Destination.Buffer.Resource = checked_cast<Buffer*>(metadata.buffer.get())->handle;
+    request.Destination.Buffer.Offset = metadata.bufferOffset;
+    request.Destination.Buffer.Size = metadata.byteLength;
     m_queue->EnqueueRequest(&request);
 
     submitWait();
@@ -137,6 +137,7 @@ struct Buffer : public IBuffer
     [[nodiscard]] bool staging() const override { return allocDesc.HeapType & D3D12_HEAP_TYPE_UPLOAD; }
     void uploadFromMemory(const void* src, uint64_t byteSize) const override;
     void getUint(uint32_t* ptr) const override;
+    void downloadToMemory(void* dst, uint64_t byteSize) const override;
     // clang-format on
 };
 
@@ -276,10 +277,10 @@ class Command : public ICommand
     void addImageBarrier(const TexturePtr& texture, ResourceState new_state) const override;
     void addBufferBarrier(const BufferPtr& buffer, ResourceState new_state) const override;
     void clearColorImage(const TexturePtr& texture, const std::array<float,4>& color) const override;
-    void copyBufferToTexture(const BufferPtr& buffer, const TexturePtr& texture, const Subresource& sub, const unsigned char* pSrcData) const override;
+    void copyBufferToTexture(const BufferPtr& buffer, const TexturePtr& texture, const Subresource& sub, const unsigned char* pSrcData) override;
     void copyBuffer(const BufferPtr& src, const BufferPtr& dst, uint64_t byteSize, uint64_t dstOffset) override;
-    void syncBuffer(const BufferPtr& dst, const void* src, uint64_t byteSize) override;
-    void fillBuffer(const BufferPtr& dst, uint32_t value) const override;
+    void syncBuffer(const BufferPtr& dst, const void* src, uint64_t byteSize, uint64_t dstOffset) override;
+    void fillBuffer(const BufferPtr& dst, uint32_t value) override;
     void bindIndexBuffer(const BufferPtr& indexBuffer) override;
     void bindVertexBuffers(uint32_t slot, const BufferPtr& indexBuffer) override;
     void beginDebugEvent(const std::string& label, const std::array<float, 4>& color) const override;
@@ -379,8 +380,7 @@ class Storage : public CommonStorage
     coro::task<> makeSingleTextureTask(coro::latch& latch, BindlessTablePtr table, ReadOnlyFilePtr file) override;
     coro::task<> makeMultiTextureTask(coro::latch& latch, BindlessTablePtr table,
                                       std::vector<ReadOnlyFilePtr> files) override;
-    coro::task<> makeBufferTask(coro::latch& latch, ReadOnlyFilePtr file, BufferPtr buffer, uint64_t fileLength,
-                                uint64_t fileOffset) override;
+    coro::task<> makeBufferTask(coro::latch& latch, BufferStreamingMetadata metadata) override;
     coro::task<> makeMultiTextureTask(coro::latch& latch, BindlessTablePtr table,
                                       std::vector<TextureStreamingMetadata> textures) override;
 };
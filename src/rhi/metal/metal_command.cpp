@@ -104,7 +104,7 @@ void Command::endRendering() const
     m_renderCommandEncoder->endEncoding();
 }
 
-void Command::copyBufferToTexture(const BufferPtr& buffer, const TexturePtr& texture, const Subresource& sub, const unsigned char* pSrcData) const
+void Command::copyBufferToTexture(const BufferPtr& buffer, const TexturePtr& texture, const Subresource& sub, const unsigned char* pSrcData)
 {
     auto* image = checked_cast<Texture*>(texture.get());
     auto* staging = checked_cast<Buffer*>(buffer.get());
@@ -112,10 +112,10 @@ void Command::copyBufferToTexture(const BufferPtr& buffer, const TexturePtr& tex
     if (pSrcData != nullptr)
         buffer->uploadFromMemory(pSrcData, staging->sizeInBytes());
 
-    const MTL::Origin origin(0, 0, 0);
+    const MTL::Origin origin(sub.x, sub.y, 0);
     const MTL::Size size(sub.width, sub.height, sub.depth);
     MTL::BlitCommandEncoder* cd = cmdBuf->blitCommandEncoder();
-    cd->copyFromBuffer(staging->handle, sub.offset, sub.rowPitch, 0, size, image->handle, 0, sub.index, origin);
+    cd->copyFromBuffer(staging->handle, sub.offset, sub.rowPitch, 0, size, image->handle, sub.layer, sub.index, origin);
     cd->endEncoding();
 }
 
@@ -129,22 +129,22 @@ void Command::copyBuffer(const BufferPtr& src, const BufferPtr& dst, uint64_t by
     cd->endEncoding();
 }
 
-void Command::syncBuffer(const BufferPtr& dst, const void* src, uint64_t byteSize)
+void Command::syncBuffer(const BufferPtr& dst, const void* src, uint64_t byteSize, uint64_t dstOffset)
 {
     const auto* buffDst = checked_cast<Buffer*>(dst.get());
     MTL::Buffer* buffer = buffDst->handle;
 
     assert(buffer->storageMode() == MTL::StorageModeManaged);
 
-    memcpy(buffer->contents(), src, byteSize);
-    buffer->didModifyRange(NS::Range(0, byteSize));
+    memcpy(static_cast<std::byte*>(buffer->contents()) + dstOffset, src, byteSize);
+    buffer->didModifyRange(NS::Range(dstOffset, byteSize));
 
     MTL::BlitCommandEncoder* cd = cmdBuf->blitCommandEncoder();
     cd->synchronizeResource(buffer);
     cd->endEncoding();
 }
 
-void Command::fillBuffer(const BufferPtr& dst, uint32_t value) const
+void Command::fillBuffer(const BufferPtr& dst, uint32_t value)
 {
     const auto* buffDst = checked_cast<Buffer*>(dst.get());
 
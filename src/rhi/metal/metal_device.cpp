@@ -153,4 +153,12 @@ void Buffer::getUint(uint32_t* ptr) const
     else
         log::error("Failed to upload to buffer");
 }
+
+void Buffer::downloadToMemory(void* dst, uint64_t byteSize) const
+{
+    if (staging() && sizeInBytes() >= byteSize)
+        std::memcpy(dst, handle->contents(), byteSize);
+    else
+        log::error("Failed to read from buffer");
+}
 } // namespace ler::rhi::metal
\ No newline at end of file
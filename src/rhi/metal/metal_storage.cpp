@@ -182,13 +182,13 @@ coro::task<> Storage::makeMultiTextureTask(coro::latch& latch, BindlessTablePtr
     co_return;
 }
 
-coro::task<> Storage::makeBufferTask(coro::latch& latch, ReadOnlyFilePtr file, BufferPtr buffer, uint64_t fileLength, uint64_t fileOffset)
+coro::task<> Storage::makeBufferTask(coro::latch& latch, BufferStreamingMetadata metadata)
 {
-    const MTL::Buffer* dstBuffer = checked_cast<Buffer*>(buffer.get())->handle;
-    const MTL::IOFileHandle* srcFile = checked_cast<ReadOnlyFile*>(file.get())->handle;
+    const MTL::Buffer* dstBuffer = checked_cast<Buffer*>(metadata.buffer.get())->handle;
+    const MTL::IOFileHandle* srcFile = checked_cast<ReadOnlyFile*>(metadata.file.get())->handle;
 
     MTL::IOCommandBuffer* cmd = m_queue->commandBuffer();
-    cmd->loadBuffer(dstBuffer, 0, fileLength, srcFile, fileOffset);
+    cmd->loadBuffer(dstBuffer, metadata.bufferOffset, metadata.byteLength, srcFile, metadata.byteOffset);
     cmd->commit();
     cmd->waitUntilCompleted();
 
@@ -31,11 +31,15 @@ void Device::populateTexture(const std::shared_ptr<Texture>& texture, const Text
     //pTextureDesc->setTextureType(MTL::TextureType2D);
     pTextureDesc->setStorageMode(MTL::StorageModePrivate);
     pTextureDesc->setSampleCount(desc.sampleCount);
-    //pTextureDesc->setArrayLength(desc.arrayLayers);
+    if (desc.arrayLayers > 1)
+    {
+        pTextureDesc->setTextureType(MTL::TextureType2DArray);
+        pTextureDesc->setArrayLength(desc.arrayLayers);
+    }
     pTextureDesc->setUsage(usage);
 
     texture->handle = m_device->newTexture(pTextureDesc);
-    texture->view = texture->handle->newTextureView(pTextureDesc->pixelFormat(), MTL::TextureType2DArray, NS::Range(0, desc.mipLevels), NS::Range(0, 1));
+    texture->view = texture->handle->newTextureView(pTextureDesc->pixelFormat(), MTL::TextureType2DArray, NS::Range(0, desc.mipLevels), NS::Range(0, desc.arrayLayers));
     texture->handle->setLabel(NS::String::string(desc.debugName.c_str(), NS::StringEncoding::UTF8StringEncoding));
     //pTextureDesc->release();
 }
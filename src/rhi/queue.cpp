@@ -61,4 +61,9 @@ namespace ler::rhi
         completed = updateLastFinishedID() >= submissionID;
         return completed;
     }
-}
\ No newline at end of file
+
+    void to_json(json& j, const Queue::Stats& stats)
+    {
+        j = json{ { "submits", stats.submits }, { "submit_and_wait", stats.submitAndWait } };
+    }
+}
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "rhi.hpp"
+#include "sys/stats.hpp"
 
 namespace ler::rhi
 {
@@ -14,6 +15,12 @@ namespace ler::rhi
         virtual ~Queue() = default;
         explicit Queue(QueueType queueID);
 
+        struct Stats
+        {
+            sys::Counter submits;
+            sys::LatencyHistogram submitAndWait; // CPU time blocked in one-shot submissions
+        };
+
         // creates a command buffer and its synchronization resources
         rhi::CommandPtr getOrCreateCommandBuffer();
 
@@ -22,6 +29,7 @@ namespace ler::rhi
 
         [[nodiscard]] QueueType getType() const { return m_queueType; }
         [[nodiscard]] uint64_t getLastSubmittedID() const { return m_lastSubmittedID; }
+        [[nodiscard]] const Stats& getStats() const { return m_stats; }
 
     protected:
 
@@ -37,5 +45,9 @@ namespace ler::rhi
 
         std::vector<CommandPtr> m_commandBuffersInFlight;
         std::vector<CommandPtr> m_commandBuffersPool;
+
+        Stats m_stats;
     };
+
+    void to_json(json& j, const Queue::Stats& stats);
 }
\ No newline at end of file
@@ -11,6 +11,9 @@ namespace fs = std::filesystem;
 
 #include "enum.hpp"
 #include "log/log.hpp"
+#include "sys/asset.hpp"
+#include "sys/request.hpp"
+#include "sys/stats.hpp"
 #include "sys/utils.hpp"
 
 #include <coro/coro.hpp>
@@ -62,6 +65,7 @@ struct BufferDesc
     bool isConstantBuffer = false;
     bool isDrawIndirectArgs = false;
     bool isAccelStructBuildInput = false;
+    bool isDirectUpload = false; // Prefer host-visible device-local memory (ReBAR/UMA) when budget allows
 };
 
 struct IBuffer : IResource
@@ -70,6 +74,7 @@ struct IBuffer : IResource
     [[nodiscard]] virtual bool staging() const = 0;
     virtual void uploadFromMemory(const void* src, uint64_t sizeInBytes) const = 0;
     virtual void getUint(uint32_t* ptr) const = 0;
+    virtual void downloadToMemory(void* dst, uint64_t sizeInBytes) const = 0;
 };
 
 using BufferPtr = std::shared_ptr<IBuffer>;
@@ -89,7 +94,10 @@ struct FormatBlockInfo
 
 struct Subresource
 {
-    uint32_t index = 0u;
+    uint32_t index = 0u; // mip level
+    uint32_t layer = 0u;
+    uint32_t x = 0u; // destination texel offset
+    uint32_t y = 0u;
     uint32_t depth = 1u;
     uint32_t width = 0u;
     uint32_t height = 0u;
@@ -242,6 +250,14 @@ struct EncodeIndirectIndexedDrawDesc
     uint32_t maxDrawCount = 0;
 };
 
+// Every mip region of one texture sourced from the same buffer
+struct TextureUpload
+{
+    BufferPtr buffer;
+    TexturePtr texture;
+    std::span<const Subresource> subresources;
+};
+
 class ICommand
 {
   public:
@@ -267,10 +283,13 @@ class ICommand
     virtual void addBufferBarrier(const BufferPtr& buffer, ResourceState new_state) const = 0;
     virtual void clearColorImage(const TexturePtr& texture, const std::array<float, 4>& color) const = 0;
     virtual void copyBufferToTexture(const BufferPtr& buffer, const TexturePtr& texture, const Subresource& sub,
-                                     const unsigned char* pSrcData) const = 0;
+                                     const unsigned char* pSrcData) = 0;
+    // Records a whole streaming batch, backends without batching fall back to copyBufferToTexture
+    virtual void copyBufferToTextures(std::span<const TextureUpload> uploads);
     virtual void copyBuffer(const BufferPtr& src, const BufferPtr& dst, uint64_t sizeInBytes, uint64_t dstOffset) = 0;
-    virtual void syncBuffer(const BufferPtr& dst, const void* src, uint64_t sizeInBytes) = 0;
-    virtual void fillBuffer(const BufferPtr& dst, uint32_t value) const = 0;
+    // Uploads are staged in the frame scratch buffer, backends may defer and merge the copies
+    virtual void syncBuffer(const BufferPtr& dst, const void* src, uint64_t sizeInBytes, uint64_t dstOffset = 0) = 0;
+    virtual void fillBuffer(const BufferPtr& dst, uint32_t value) = 0;
     virtual void bindIndexBuffer(const BufferPtr& indexBuffer) = 0;
     virtual void bindVertexBuffers(uint32_t slot, const BufferPtr& indexBuffer) = 0;
     virtual void beginDebugEvent(const std::string& label, const std::array<float, 4>& color) const = 0;
@@ -311,7 +330,7 @@ using ReadOnlyFilePtr = std::shared_ptr<IReadOnlyFile>;
 struct TextureStreaming
 {
     ResourceViewPtr view;
-    std::string stem;
+    sys::AssetId assetId = 0;
 };
 
 using TextureStreamingBatch = std::vector<TextureStreaming>;
@@ -326,6 +345,22 @@ struct TextureStreamingMetadata
     uint64_t byteOffset = 0;
     uint64_t byteLength = 0;
     ReadOnlyFilePtr file;
+    sys::IoOptions options;
+    // Per mip copy regions relative to byteOffset, computed from desc when empty
+    std::vector<Subresource> footprints;
+    uint64_t contentHash = 0; // xxh3 of the entry, 0 skips verification
+    sys::AssetId assetId = 0;  // storage key once loaded
+};
+
+struct BufferStreamingMetadata
+{
+    BufferPtr buffer;
+    uint64_t bufferOffset = 0; // Destination, for buffers shared by several entries
+    uint64_t byteOffset = 0;
+    uint64_t byteLength = 0;
+    ReadOnlyFilePtr file;
+    sys::IoOptions options;
+    uint64_t contentHash = 0;
 };
 
 class IStorage
@@ -337,12 +372,15 @@ class IStorage
     virtual std::vector<ReadOnlyFilePtr> openFiles(const fs::path& path, const fs::path& ext) = 0;
     virtual void requestLoadTexture(coro::latch& latch, BindlessTablePtr& table,
                                     const std::span<ReadOnlyFilePtr>& files) = 0;
-    virtual void requestLoadBuffer(coro::latch& latch, const ReadOnlyFilePtr& file, BufferPtr& buffer,
-                                   uint64_t fileLength, uint64_t fileOffset) = 0;
+    virtual void requestLoadBuffer(coro::latch& latch, const BufferStreamingMetadata& metadata) = 0;
     virtual void requestOpenTexture(coro::latch& latch, BindlessTablePtr& table, const std::span<fs::path>& paths) = 0;
     virtual void requestLoadTexture(coro::latch& latch, BindlessTablePtr& table,
                                     const std::span<TextureStreamingMetadata>& textures) = 0;
-    virtual std::expected<ResourceViewPtr, StorageError> getResource(uint64_t pathKey) = 0;
+    // Safe from any thread, loose files are keyed by the asset ID of their name
+    virtual std::expected<ResourceViewPtr, StorageError> getResource(sys::AssetId id) = 0;
+    // Forgets a resource, the caller keeps the view until the GPU is done with it
+    virtual ResourceViewPtr releaseResource(sys::AssetId id) = 0;
+    [[nodiscard]] virtual json getTelemetry() const = 0;
 };
 
 using StoragePtr = std::shared_ptr<IStorage>;
@@ -351,6 +389,9 @@ struct DeviceConfig
 {
     bool debug = true;
     bool hostBuffer = true;
+    bool directIo = false; // Stream files bypassing the OS page cache
+    bool verifyContent = false; // Check pak entry checksums as they land in staging (Vulkan)
+    uint64_t defragBytesPerPass = 32ull << 20; // Background texture compaction budget, 0 disables it
     std::vector<const char*> extensions;
 };
 
@@ -366,6 +407,7 @@ class IDevice
 
     // Texture
     virtual TexturePtr createTexture(const TextureDesc& desc) = 0;
+    virtual std::vector<TexturePtr> createTextures(std::span<const TextureDesc> descs);
     virtual SamplerPtr createSampler(const SamplerDesc& desc) = 0;
     virtual SwapChainPtr createSwapChain(GLFWwindow* window, bool vsync) = 0;
 
@@ -410,18 +452,47 @@ class IRenderPass
     // clang-format on
 };
 
+/// @brief Per-frame upload arena made of host visible pages.
+/// Pages are chained when a frame overflows and released after kShrinkFrames frames
+/// that did not need them, requests bigger than a page get a page of their own.
 class ScratchBuffer
 {
   public:
+    struct Allocation
+    {
+        BufferPtr buffer;
+        uint64_t offset = 0;
+    };
+
+    struct Stats
+    {
+        sys::Counter grows;
+        sys::Counter shrinks;
+        sys::Counter oversized; // requests larger than kPageSize
+        sys::Gauge capacity;
+        sys::Gauge frameUsage; // bytes used by the last completed frame, peak is the high-water mark
+    };
+
     explicit ScratchBuffer(IDevice* device);
-    uint64_t allocate(uint32_t sizeInByte);
-    [[nodiscard]] const BufferPtr& getBuffer() const;
+    Allocation allocate(uint64_t sizeInBytes);
     void reset();
+    [[nodiscard]] json getStats() const;
+
+    static constexpr uint64_t kPageSize = sys::C08Mio;
+    static constexpr uint32_t kShrinkFrames = 300;
 
   private:
-    static constexpr uint64_t m_capacity = sys::C08Mio;
-    std::atomic_uint64_t m_size = 0;
-    BufferPtr m_staging;
+    BufferPtr& addPage(size_t index, uint64_t sizeInBytes);
+
+    IDevice* m_device = nullptr;
+    mutable std::mutex m_mutex;
+    std::vector<BufferPtr> m_pages;
+    size_t m_page = 0;
+    uint64_t m_offset = 0;
+    uint64_t m_used = 0;
+    size_t m_windowPages = 1; // most pages needed by a frame since the last shrink check
+    uint32_t m_windowFrames = 0;
+    Stats m_stats;
 };
 
 struct StringFormatMapping
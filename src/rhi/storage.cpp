@@ -4,6 +4,8 @@
 
 #include "storage.hpp"
 
+#include <xxhash.h>
+
 namespace ler::rhi
 {
 CommonStorage::CommonStorage(IDevice* device, std::shared_ptr<coro::thread_pool>& tp)
@@ -19,24 +21,33 @@ CommonStorage::CommonStorage(IDevice* device, std::shared_ptr<coro::thread_pool>
 
 void CommonStorage::update()
 {
-    sys::PathHash hash;
     TextureStreamingBatch batch;
     while (m_dispatcher.dequeue(batch))
     {
         for (auto& e : batch)
-            m_resources[hash(e.stem)] = e.view;
+            m_resources.insert(e.assetId, std::move(e.view));
+        m_stats.texturesLoaded.add(batch.size());
     }
 }
 
 std::vector<ReadOnlyFilePtr> CommonStorage::openFiles(const fs::path& path, const fs::path& ext)
 {
-    std::vector<ReadOnlyFilePtr> files;
+    std::vector<fs::path> paths;
     for (const fs::directory_entry& entry : fs::directory_iterator(path))
     {
         if (entry.is_regular_file() && entry.path().extension() == ext)
-            files.emplace_back(openFile(entry.path()));
+            paths.emplace_back(entry.path());
     }
-    return files;
+    return coro::sync_wait(openFilesAsync(std::move(paths)));
+}
+
+coro::task<std::vector<ReadOnlyFilePtr>> CommonStorage::openFilesAsync(std::vector<fs::path> paths)
+{
+    std::vector<ReadOnlyFilePtr> files;
+    files.reserve(paths.size());
+    for (const fs::path& p : paths)
+        files.emplace_back(openFile(p));
+    co_return files;
 }
 
 img::ITexture* CommonStorage::factoryTexture(const ReadOnlyFilePtr& file, std::byte* metadata)
@@ -76,22 +87,32 @@ void CommonStorage::requestLoadTexture(coro::latch& latch, BindlessTablePtr& tab
     }
 }
 
-void CommonStorage::requestLoadBuffer(coro::latch& latch, const ReadOnlyFilePtr& file, BufferPtr& buffer,
-                                      uint64_t fileLength, uint64_t fileOffset)
+void CommonStorage::requestLoadBuffer(coro::latch& latch, const BufferStreamingMetadata& metadata)
 {
-    m_scheduler.spawn(makeBufferTask(latch, file, buffer, fileLength, fileOffset));
+    m_scheduler.spawn(makeBufferTask(latch, metadata));
 }
 
 void CommonStorage::requestOpenTexture(coro::latch& latch, BindlessTablePtr& table, const std::span<fs::path>& paths)
 {
+    m_scheduler.spawn(makeOpenTextureTask(latch, table, std::vector(paths.begin(), paths.end())));
+}
+
+coro::task<> CommonStorage::makeOpenTextureTask(coro::latch& latch, BindlessTablePtr table, std::vector<fs::path> paths)
+{
+    co_await m_scheduler.schedule();
+    // Files are opened in a single batch then sliced straight into read batches
+    const size_t requested = paths.size();
+    std::vector<ReadOnlyFilePtr> opened = co_await openFilesAsync(std::move(paths));
+    // The caller counted every path, files that failed to open are done already
+    if (opened.size() < requested)
+        latch.count_down(static_cast<int64_t>(requested - opened.size()));
+
     int batchCount = 0;
     uint64_t totalByteSizes = 0;
     std::list<std::vector<ReadOnlyFilePtr>> ranges;
     std::vector<ReadOnlyFilePtr> files;
-    for (const fs::path& p : paths)
+    for (const ReadOnlyFilePtr& file : opened)
     {
-        ReadOnlyFilePtr file = openFile(p);
-        static constexpr uint64_t alignment = 16;
         const uint64_t byteSizes = file->sizeInBytes();
         if (totalByteSizes + byteSizes > kStagingSize)
         {
@@ -110,7 +131,7 @@ void CommonStorage::requestOpenTexture(coro::latch& latch, BindlessTablePtr& tab
         ++batchCount;
     }
 
-    log::info("[OpenTexture] Requested {} tasks ({} files)", batchCount, paths.size());
+    log::info("[OpenTexture] Requested {} tasks ({}/{} files)", batchCount, opened.size(), requested);
 
     for (std::vector<ReadOnlyFilePtr>& f : ranges)
         m_scheduler.spawn(makeMultiTextureTask(latch, table, std::move(f)));
@@ -119,14 +140,22 @@ void CommonStorage::requestOpenTexture(coro::latch& latch, BindlessTablePtr& tab
 void CommonStorage::requestLoadTexture(coro::latch& latch, BindlessTablePtr& table,
                                        const std::span<TextureStreamingMetadata>& textures)
 {
+    // Most urgent textures are batched (and thus spawned) first
+    std::vector<TextureStreamingMetadata> sorted(textures.begin(), textures.end());
+    std::ranges::stable_sort(sorted, {}, [](const TextureStreamingMetadata& m) { return m.options.priority; });
+
     int batchCount = 0;
     uint64_t totalByteSizes = 0;
     std::list<std::vector<TextureStreamingMetadata>> ranges;
     std::vector<TextureStreamingMetadata> files;
-    for (const TextureStreamingMetadata& metadata : textures)
+    for (const TextureStreamingMetadata& metadata : sorted)
     {
-        const uint64_t byteSizes = metadata.byteLength;
-        if (totalByteSizes + byteSizes > kStagingSize)
+        // Each texture lands on a direct IO aligned staging offset
+        const uint64_t byteSizes = align(metadata.byteLength, sys::ReadOnlyFile::kDirectAlignment);
+        // A batch shares one IO priority and cancel token
+        const bool sameOptions = files.empty() || (files.front().options.priority == metadata.options.priority &&
+                                                   files.front().options.token == metadata.options.token);
+        if (totalByteSizes + byteSizes > kStagingSize || !sameOptions)
         {
             ranges.emplace_back(std::move(files));
             totalByteSizes = 0;
@@ -152,26 +181,99 @@ void CommonStorage::requestLoadTexture(coro::latch& latch, BindlessTablePtr& tab
 void CommonStorage::releaseStaging(uint32_t index)
 {
     const std::scoped_lock staging_lock(m_mutex);
+    m_stats.stagingHold.record(sys::IoClock::now() - m_stagingAcquireTime[index]);
+    m_stats.stagingInUse.sub();
     m_bitset.clear(index);
     m_semaphore.release();
 }
 
 coro::task<int> CommonStorage::acquireStaging()
 {
+    const sys::IoClock::time_point start = sys::IoClock::now();
     // If no staging buffers are available re-schedule the task
     while (!m_semaphore.try_acquire())
+    {
+        m_stats.stagingSpins.add();
         co_await m_scheduler.schedule();
+    }
     const std::scoped_lock staging_lock(m_mutex);
     const int idx = m_bitset.findFirst();
     m_bitset.set(idx);
+    m_stagingAcquireTime[idx] = sys::IoClock::now();
+    m_stats.stagingWait.record(m_stagingAcquireTime[idx] - start);
+    m_stats.stagingAcquired.add();
+    m_stats.stagingInUse.add();
     co_return idx;
 }
 
-std::expected<ResourceViewPtr, StorageError> CommonStorage::getResource(uint64_t pathKey)
+bool CommonStorage::verifyContent(std::span<const std::span<const std::byte>> chunks, uint64_t hash,
+                                  std::string_view name)
 {
-    if (m_resources.contains(pathKey))
-        return m_resources.at(pathKey);
-    else
-        return std::unexpected(StorageError());
+    XXH3_state_t state;
+    XXH3_64bits_reset(&state);
+    for (const std::span<const std::byte>& chunk : chunks)
+    {
+        XXH3_64bits_update(&state, chunk.data(), chunk.size());
+        m_stats.verifiedBytes.add(chunk.size());
+    }
+
+    if (XXH3_64bits_digest(&state) == hash)
+        return true;
+
+    m_stats.corruptEntries.add();
+    log::error("[Storage] Checksum mismatch, entry dropped: {}", name);
+    return false;
+}
+
+coro::task<> CommonStorage::makeVerifyTask(coro::latch& latch, ContentCheck check, uint8_t& valid)
+{
+    co_await m_scheduler.schedule();
+    valid = verifyContent({ &check.data, 1 }, check.hash, check.name);
+    latch.count_down();
+}
+
+coro::task<std::vector<uint8_t>> CommonStorage::verifyContent(std::vector<ContentCheck> checks)
+{
+    std::vector<uint8_t> valid(checks.size(), 1);
+    coro::latch latch(static_cast<int64_t>(checks.size()));
+    for (size_t i = 0; i < checks.size(); ++i)
+    {
+        // Entries from paks without checksums are trusted
+        if (checks[i].hash == 0)
+            latch.count_down();
+        else
+            m_scheduler.spawn(makeVerifyTask(latch, checks[i], valid[i]));
+    }
+    co_await latch;
+    co_return valid;
+}
+
+json CommonStorage::getTelemetry() const
+{
+    json j;
+    j["staging"] = { { "count", kStagingCount },
+                     { "size", kStagingSize },
+                     { "acquired", m_stats.stagingAcquired },
+                     { "spins", m_stats.stagingSpins },
+                     { "in_use", m_stats.stagingInUse },
+                     { "wait", m_stats.stagingWait },
+                     { "hold", m_stats.stagingHold } };
+    j["textures_loaded"] = m_stats.texturesLoaded;
+    j["direct_upload_bytes"] = m_stats.directUploadBytes;
+    j["verified_bytes"] = m_stats.verifiedBytes;
+    j["corrupt_entries"] = m_stats.corruptEntries;
+    return j;
+}
+
+std::expected<ResourceViewPtr, StorageError> CommonStorage::getResource(sys::AssetId id)
+{
+    if (std::optional<ResourceViewPtr> view = m_resources.find(id))
+        return std::move(*view);
+    return std::unexpected(StorageError());
+}
+
+ResourceViewPtr CommonStorage::releaseResource(sys::AssetId id)
+{
+    return m_resources.erase(id).value_or(nullptr);
 }
 } // namespace ler::rhi
\ No newline at end of file
@@ -24,12 +24,13 @@ class CommonStorage : public IStorage
 
     void requestLoadTexture(coro::latch& latch, BindlessTablePtr& table,
                             const std::span<ReadOnlyFilePtr>& files) override;
-    void requestLoadBuffer(coro::latch& latch, const ReadOnlyFilePtr& file, BufferPtr& buffer, uint64_t fileLength,
-                           uint64_t fileOffset) override;
+    void requestLoadBuffer(coro::latch& latch, const BufferStreamingMetadata& metadata) override;
     void requestOpenTexture(coro::latch& latch, BindlessTablePtr& table, const std::span<fs::path>& paths) override;
     void requestLoadTexture(coro::latch& latch, BindlessTablePtr& table,
                             const std::span<TextureStreamingMetadata>& textures) override;
-    std::expected<ResourceViewPtr, StorageError> getResource(uint64_t pathKey) override;
+    std::expected<ResourceViewPtr, StorageError> getResource(sys::AssetId id) override;
+    ResourceViewPtr releaseResource(sys::AssetId id) override;
+    [[nodiscard]] json getTelemetry() const override;
 
     img::ITexture* factoryTexture(const ReadOnlyFilePtr& file, std::byte* metadata);
     const BufferPtr& getStaging(int index) const { return m_stagings[index]; }
@@ -40,20 +41,50 @@ class CommonStorage : public IStorage
     static constexpr int kStagingCount = 8;
     static constexpr uint64_t kStagingSize = sys::C64Mio;
 
+    struct Stats
+    {
+        sys::Counter stagingAcquired;
+        sys::Counter stagingSpins; // reschedules while every slot was busy
+        sys::Gauge stagingInUse;
+        sys::LatencyHistogram stagingWait; // time spent in acquireStaging
+        sys::LatencyHistogram stagingHold; // acquire -> release
+        sys::Counter texturesLoaded;
+        sys::Counter directUploadBytes; // read straight into mapped device memory
+        sys::Counter verifiedBytes;
+        sys::Counter corruptEntries; // checksum mismatches, never uploaded
+    };
+
   protected:
+    // Opens every path, failed ones are logged and skipped
+    virtual coro::task<std::vector<ReadOnlyFilePtr>> openFilesAsync(std::vector<fs::path> paths);
+
+    struct ContentCheck
+    {
+        std::span<const std::byte> data;
+        uint64_t hash = 0;
+        std::string_view name;
+    };
+
+    // Hashes chunks in order against the expected xxh3, mismatches are reported by name
+    bool verifyContent(std::span<const std::span<const std::byte>> chunks, uint64_t hash, std::string_view name);
+    // Hashes every entry in parallel on the pool, returns which ones matched
+    coro::task<std::vector<uint8_t>> verifyContent(std::vector<ContentCheck> checks);
+
     IDevice* m_device = nullptr;
     std::vector<BufferPtr> m_stagings;
     sys::MpscQueue<TextureStreamingBatch> m_dispatcher;
-    std::unordered_map<uint64_t, ResourceViewPtr> m_resources;
+    sys::AssetMap<ResourceViewPtr> m_resources;
+    Stats m_stats;
 
   private:
+    coro::task<> makeOpenTextureTask(coro::latch& latch, BindlessTablePtr table, std::vector<fs::path> paths);
+    coro::task<> makeVerifyTask(coro::latch& latch, ContentCheck check, uint8_t& valid);
     virtual coro::task<> makeSingleTextureTask(coro::latch& latch, BindlessTablePtr table, ReadOnlyFilePtr file) = 0;
     virtual coro::task<> makeMultiTextureTask(coro::latch& latch, BindlessTablePtr table,
                                               std::vector<ReadOnlyFilePtr> files) = 0;
     virtual coro::task<> makeMultiTextureTask(coro::latch& latch, BindlessTablePtr table,
                                               std::vector<TextureStreamingMetadata> textures) = 0;
-    virtual coro::task<> makeBufferTask(coro::latch& latch, ReadOnlyFilePtr file, BufferPtr buffer, uint64_t fileLength,
-                                        uint64_t fileOffset) = 0;
+    virtual coro::task<> makeBufferTask(coro::latch& latch, BufferStreamingMetadata metadata) = 0;
 
     using task_container = coro::thread_pool&;
     task_container m_scheduler;
@@ -61,6 +92,7 @@ class CommonStorage : public IStorage
     sys::Bitset m_bitset;
     mutable std::mutex m_mutex;
     std::counting_semaphore<> m_semaphore;
+    std::array<sys::IoClock::time_point, kStagingCount> m_stagingAcquireTime;
 
     std::unique_ptr<std::byte[]> m_buffer = std::make_unique<std::byte[]>(sys::C04Mio);
     std::pmr::monotonic_buffer_resource m_memory;
@@ -12,6 +12,8 @@
 #include "sys/thread.hpp"
 
 #define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+#include <atomic>
+#include <map>
 #include <set>
 #include <vk_mem_alloc.h>
 #include <vulkan/vulkan.hpp>
@@ -55,6 +57,36 @@ struct VulkanFeatures
     bool mutableDescriptor = false;
     bool multiDrawIndirect = false;
     bool drawIndirectCount = false;
+    bool hostImageCopy = false;
+};
+
+enum class MemoryClass : uint8_t
+{
+    StreamedTexture,
+    RenderTarget,
+    StaticGeometry,
+    Transient, // Staging, readback and scratch
+    Count
+};
+
+/// @brief VMA custom pools, one per memory class and memory type, created on first use.
+/// Resources are sub-allocated from large blocks instead of owning a VkDeviceMemory each.
+class MemoryPools
+{
+  public:
+    ~MemoryPools() { clear(); }
+
+    void init(VmaAllocator allocator);
+    void clear();
+    [[nodiscard]] VmaPool get(MemoryClass memoryClass, uint32_t memoryTypeIndex);
+    [[nodiscard]] std::vector<VmaPool> list(MemoryClass memoryClass) const;
+    [[nodiscard]] json getStats() const;
+    static uint64_t blockSize(MemoryClass memoryClass);
+
+  private:
+    VmaAllocator m_allocator = nullptr;
+    mutable std::mutex m_mutex;
+    std::map<std::pair<MemoryClass, uint32_t>, VmaPool> m_pools;
 };
 
 /// @brief Contains all shared vulkan context structures
@@ -74,6 +106,10 @@ struct VulkanContext
     uint64_t hostPointerAlignment = 4096u;
     uint32_t frameIndex = 0;
     bool hostBuffer = true;
+    bool directIo = false;
+    bool verifyContent = false;
+    bool hostImageCopy = false; // VK_EXT_host_image_copy into ShaderReadOnlyOptimal
+    uint32_t directUploadHeap = UINT32_MAX; // Large host-visible device-local heap (ReBAR/UMA)
     bool debug = false;
 };
 
@@ -96,6 +132,7 @@ struct Buffer final : IBuffer
     [[nodiscard]] vk::ArrayProxyNoTemporaries<const vk::BufferView> view();
     void uploadFromMemory(const void* src, uint64_t sizeInBytes) const override;
     void getUint(uint32_t* ptr) const override;
+    void downloadToMemory(void* dst, uint64_t sizeInBytes) const override;
     void setName(const std::string& debugName);
     // clang-format on
 
@@ -106,13 +143,15 @@ struct Buffer final : IBuffer
     vk::UniqueBufferView m_view;
 };
 
-struct Texture final : ITexture
+struct Texture final : ITexture, std::enable_shared_from_this<Texture>
 {
     vk::Image handle;
     std::string name;
     vk::ImageCreateInfo info;
     VmaAllocation allocation = nullptr;
     VmaAllocationCreateInfo allocInfo = {};
+    bool hostTransfer = false; // created with eHostTransferEXT usage
+    std::atomic<bool> movable = false; // upload fence signalled, the defragmenter may relocate it
 
     // clang-format off
     ~Texture() override { if(allocation) vmaDestroyImage(m_context.allocator, handle, allocation); }
@@ -122,6 +161,9 @@ struct Texture final : ITexture
     void setName(const std::string& debugName);
     // clang-format on
 
+    // Swap in an image bound to relocated memory, the previous image and its views are handed back
+    vk::Image relocate(vk::Image image, std::vector<vk::UniqueImageView>& retired);
+
     static constexpr vk::ImageSubresourceRange DefaultSub{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
 
   private:
@@ -268,18 +310,36 @@ class Command final : public ICommand
     void addImageBarrier(const TexturePtr& texture, ResourceState new_state) const override;
     void addBufferBarrier(const BufferPtr& buffer, ResourceState new_state) const override;
     void clearColorImage(const TexturePtr& texture, const std::array<float,4>& color) const override;
-    void copyBufferToTexture(const BufferPtr& buffer, const TexturePtr& texture, const Subresource& sub, const unsigned char* pSrcData) const override;
+    void copyBufferToTexture(const BufferPtr& buffer, const TexturePtr& texture, const Subresource& sub, const unsigned char* pSrcData) override;
+    void copyBufferToTextures(std::span<const TextureUpload> uploads) override;
     void copyBuffer(const BufferPtr& src, const BufferPtr& dst, uint64_t sizeInBytes, uint64_t dstOffset) override;
-    void syncBuffer(const BufferPtr& dst, const void* src, uint64_t sizeInBytes) override;
-    void fillBuffer(const BufferPtr& dst, uint32_t value) const override;
+    void syncBuffer(const BufferPtr& dst, const void* src, uint64_t sizeInBytes, uint64_t dstOffset) override;
+    void fillBuffer(const BufferPtr& dst, uint32_t value) override;
     void bindIndexBuffer(const BufferPtr& indexBuffer) override;
     void bindVertexBuffers(uint32_t slot, const BufferPtr& indexBuffer) override;
     void beginDebugEvent(const std::string& label, const std::array<float, 4>& color) const override;
     void endDebugEvent() const override;
     // clang-format on
 
+    // Records the pending syncBuffer uploads, called before any command that could read them
+    void flushSyncs();
+
   private:
+    struct PendingSync
+    {
+        BufferPtr dst;
+        BufferPtr src; // scratch page
+        uint64_t srcOffset = 0;
+        uint64_t dstOffset = 0;
+        uint64_t size = 0;
+        uint32_t order = 0; // overlapping uploads keep the last write
+    };
+
+    vk::ImageMemoryBarrier2 makeImageBarrier(const TexturePtr& texture, ResourceState new_state) const;
+    vk::BufferMemoryBarrier2 makeBufferBarrier(const BufferPtr& buffer, ResourceState new_state) const;
+
     const VulkanContext& m_context;
+    std::vector<PendingSync> m_syncs;
 };
 
 class Queue final : public rhi::Queue
@@ -351,7 +411,8 @@ struct SwapChain final : ISwapChain
 struct ReadOnlyFile final : IReadOnlyFile
 {
     // clang-format off
-    explicit ReadOnlyFile(const fs::path& path) : handle(path) {}
+    explicit ReadOnlyFile(const fs::path& path, bool direct) : handle(path, direct) {}
+    ReadOnlyFile(const fs::path& path, FD fd, uint64_t size, bool direct) : handle(path, fd, size, direct) {}
     std::string getFilename() override { return handle.getPath(); }
     uint64_t sizeInBytes() override { return handle.m_size; }
     // clang-format on
@@ -364,17 +425,20 @@ class Storage final : public CommonStorage
   public:
     Storage(Device* device, std::shared_ptr<coro::thread_pool>& tp);
     ReadOnlyFilePtr openFile(const fs::path& path) override;
+    [[nodiscard]] json getTelemetry() const override;
 
   private:
     sys::IoService m_ios;
 
+    coro::task<std::vector<ReadOnlyFilePtr>> openFilesAsync(std::vector<fs::path> paths) override;
+    void uploadTextures(std::span<const TextureUpload> uploads);
+
     coro::task<> makeSingleTextureTask(coro::latch& latch, BindlessTablePtr table, ReadOnlyFilePtr file) override;
     coro::task<> makeMultiTextureTask(coro::latch& latch, BindlessTablePtr table,
                                       std::vector<ReadOnlyFilePtr> files) override;
     coro::task<> makeMultiTextureTask(coro::latch& latch, BindlessTablePtr table,
                                       std::vector<TextureStreamingMetadata> textures) override;
-    coro::task<> makeBufferTask(coro::latch& latch, ReadOnlyFilePtr file, BufferPtr buffer, uint64_t fileLength,
-                                uint64_t fileOffset) override;
+    coro::task<> makeBufferTask(coro::latch& latch, BufferStreamingMetadata metadata) override;
 };
 
 class PSOLibrary
@@ -398,6 +462,63 @@ class ImGuiPass final : public IRenderPass
     vk::UniqueDescriptorPool m_descriptorPool;
 };
 
+/// @brief Incremental compaction of the streamed texture pools.
+/// A pass moves at most the configured byte budget, copies run on the graphics queue after the frames
+/// still sampling the old images, and the old images are released once every frame in flight retired.
+class Defragmenter
+{
+  public:
+    struct Stats
+    {
+        sys::Counter passes;
+        sys::Counter movedBytes;
+        sys::Counter movedTextures;
+        sys::Counter skipped; // moves ignored because the texture was not idle
+    };
+
+    Defragmenter(Device* device, MemoryPools& pools, uint64_t bytesPerPass);
+    ~Defragmenter();
+
+    void track(const std::shared_ptr<CommonBindlessTable>& table);
+    void update();
+    [[nodiscard]] json getStats() const;
+
+  private:
+    enum class State : uint8_t
+    {
+        Idle,
+        Copying,
+        Retiring
+    };
+
+    struct Relocation
+    {
+        std::shared_ptr<Texture> texture;
+        vk::Image image; // Destination while copying, previous image once swapped
+        std::vector<vk::UniqueImageView> views;
+    };
+
+    bool beginDefragmentation();
+    void endDefragmentation();
+    void beginPass();
+    void swapImages();
+    void endPass();
+
+    Device* m_device = nullptr;
+    MemoryPools& m_pools;
+    uint64_t m_bytesPerPass = 0;
+    uint64_t m_frame = 0;
+    uint64_t m_retireFrame = 0;
+    uint64_t m_submissionID = 0;
+    size_t m_nextPool = 0;
+    State m_state = State::Idle;
+    VmaDefragmentationContext m_defrag = nullptr;
+    VmaDefragmentationPassMoveInfo m_pass = {};
+    std::vector<Relocation> m_relocations;
+    std::vector<std::weak_ptr<CommonBindlessTable>> m_tables;
+    Stats m_stats;
+};
+
 class Device final : public IDevice
 {
   public:
@@ -411,6 +532,7 @@ class Device final : public IDevice
 
     // Texture
     TexturePtr createTexture(const TextureDesc& desc) override;
+    std::vector<TexturePtr> createTextures(std::span<const TextureDesc> descs) override;
     SamplerPtr createSampler(const SamplerDesc& desc) override;
     SwapChainPtr createSwapChain(GLFWwindow* window, bool vsync) override;
 
@@ -447,9 +569,23 @@ class Device final : public IDevice
     [[nodiscard]] Queue* getTransferQueue() const { return m_queues[2].get(); }
     // clang-format on
 
+    [[nodiscard]] json getMemoryStats() const;
+
+    // Upload without staging nor queue submit, texture must have been created with hostTransfer
+    void copyMemoryToTexture(const TexturePtr& texture, std::span<const Subresource> subresources,
+                             const std::byte* src) const;
+
   private:
     static uint32_t formatSize(VkFormat format);
     void populateTexture(const std::shared_ptr<Texture>& texture, const TextureDesc& desc) const;
+    [[nodiscard]] bool supportsHostCopyLayout() const;
+    [[nodiscard]] bool isHostCopyCompatible(vk::Format format) const;
+    [[nodiscard]] uint32_t findDirectUploadHeap() const;
+    [[nodiscard]] bool hasDirectUploadBudget(uint64_t sizeInBytes) const;
+    void selectPool(VmaAllocationCreateInfo& allocInfo, MemoryClass memoryClass, uint64_t sizeInBytes,
+                    uint32_t memoryTypeIndex);
+    VkResult allocateBuffer(Buffer& buffer, MemoryClass memoryClass, uint32_t alignment);
+    VkResult allocateTexture(Texture& texture, MemoryClass memoryClass, VmaAllocationInfo& hostInfo);
 
     vk::UniqueInstance m_instance;
     vk::PhysicalDevice m_physicalDevice;
@@ -461,6 +597,8 @@ class Device final : public IDevice
     vk::UniqueDescriptorSetLayout m_constantLayout;
     std::shared_ptr<coro::thread_pool> m_threadPool;
     VulkanContext m_context;
+    MemoryPools m_pools;
+    std::unique_ptr<Defragmenter> m_defrag;
     std::array<std::unique_ptr<Queue>, static_cast<uint32_t>(QueueType::Count)> m_queues;
     std::shared_ptr<Storage> m_storage;
     std::shared_ptr<PSOLibrary> m_library;
@@ -43,6 +43,7 @@ void Device::runGarbageCollection()
     }
 
     m_storage->update();
+    m_defrag->update();
 }
 
 Queue::Queue(const VulkanContext& context, QueueType queueID) : rhi::Queue(queueID), m_context(context)
@@ -114,12 +115,14 @@ uint64_t Queue::submit(const std::span<CommandPtr>& ppCmd)
     }
 
     m_lastSubmittedID++;
+    m_stats.submits.add();
 
     for (size_t i = 0; i < ppCmd.size(); i++)
     {
         const CommandPtr& commandBuffer = ppCmd[i];
 
         // It's time!
+        commandBuffer->flushSyncs();
         commandBuffer->cmdBuf.end();
 
         commandBuffers[i] = commandBuffer->cmdBuf;
@@ -163,9 +166,12 @@ uint64_t Queue::submit(const std::span<CommandPtr>& ppCmd)
 
 void Queue::submitAndWait(const rhi::CommandPtr& command)
 {
+    const sys::IoClock::time_point start = sys::IoClock::now();
     auto* nativeCmd = checked_cast<Command*>(command.get());
+    nativeCmd->flushSyncs();
     nativeCmd->cmdBuf.end();
     vk::UniqueFence fence = m_context.device.createFenceUnique({});
+    m_stats.submits.add();
 
     {
         std::lock_guard lock(m_mutexSend);
@@ -176,6 +182,7 @@ void Queue::submitAndWait(const rhi::CommandPtr& command)
 
     const vk::Result res = m_context.device.waitForFences(fence.get(), true, std::numeric_limits<uint64_t>::max());
     assert(res == vk::Result::eSuccess);
+    m_stats.submitAndWait.record(sys::IoClock::now() - start);
 }
 
 vk::AccessFlags2 util_to_vk_access_flags(ResourceState state)
@@ -348,7 +355,7 @@ void Command::reset()
     cmdBuf.begin({ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
 }
 
-void Command::addImageBarrier(const TexturePtr& texture, ResourceState new_state) const
+vk::ImageMemoryBarrier2 Command::makeImageBarrier(const TexturePtr& texture, ResourceState new_state) const
 {
     const auto* image = checked_cast<Texture*>(texture.get());
     ResourceState old_state = texture->state;
@@ -367,6 +374,12 @@ void Command::addImageBarrier(const TexturePtr& texture, ResourceState new_state
         vk::ImageSubresourceRange(aspect, 0, VK_REMAINING_MIP_LEVELS, 0, image->info.arrayLayers));
 
     texture->state = new_state;
+    return barrier;
+}
+
+void Command::addImageBarrier(const TexturePtr& texture, ResourceState new_state) const
+{
+    const vk::ImageMemoryBarrier2 barrier = makeImageBarrier(texture, new_state);
     vk::DependencyInfoKHR dependency_info;
     dependency_info.imageMemoryBarrierCount = 1;
     dependency_info.pImageMemoryBarriers = &barrier;
@@ -377,7 +390,7 @@ void Command::addImageBarrier(const TexturePtr& texture, ResourceState new_state
     cmdBuf.pipelineBarrier2(dependency_info);
 }
 
-void Command::addBufferBarrier(const BufferPtr& buffer, ResourceState new_state) const
+vk::BufferMemoryBarrier2 Command::makeBufferBarrier(const BufferPtr& buffer, ResourceState new_state) const
 {
     const auto* buf = checked_cast<Buffer*>(buffer.get());
     ResourceState old_state = buffer->state;
@@ -394,6 +407,12 @@ void Command::addBufferBarrier(const BufferPtr& buffer, ResourceState new_state)
     barrier.size = VK_WHOLE_SIZE;
 
     buffer->state = new_state;
+    return barrier;
+}
+
+void Command::addBufferBarrier(const BufferPtr& buffer, ResourceState new_state) const
+{
+    const vk::BufferMemoryBarrier2 barrier = makeBufferBarrier(buffer, new_state);
     vk::DependencyInfoKHR dependency_info;
     dependency_info.bufferMemoryBarrierCount = 1;
     dependency_info.pBufferMemoryBarriers = &barrier;
@@ -412,8 +431,9 @@ void Command::clearColorImage(const TexturePtr& texture, const std::array<float,
 }
 
 void Command::copyBufferToTexture(const BufferPtr& buffer, const TexturePtr& texture, const Subresource& sub,
-                                  const unsigned char* pSrcData) const
+                                  const unsigned char* pSrcData)
 {
+    flushSyncs();
     const auto* image = checked_cast<Texture*>(texture.get());
     const auto* staging = checked_cast<Buffer*>(buffer.get());
 
@@ -424,18 +444,58 @@ void Command::copyBufferToTexture(const BufferPtr& buffer, const TexturePtr& tex
     addImageBarrier(texture, CopyDest);
     // Copy buffer to texture
     vk::BufferImageCopy copyRegion(sub.offset, 0, 0);
+    copyRegion.imageOffset = vk::Offset3D(static_cast<int32_t>(sub.x), static_cast<int32_t>(sub.y), 0);
     copyRegion.imageExtent.depth = sub.depth;
     copyRegion.imageExtent.width = sub.width;
     copyRegion.imageExtent.height = sub.height;
     copyRegion.bufferRowLength = sub.rowPitch;
-    copyRegion.imageSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, sub.index, 0, 1);
+    copyRegion.imageSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, sub.index, sub.layer, 1);
     cmdBuf.copyBufferToImage(staging->handle, image->handle, vk::ImageLayout::eTransferDstOptimal, 1, &copyRegion);
     // prepare texture to color layout
     addImageBarrier(texture, ShaderResource);
 }
 
+void Command::copyBufferToTextures(std::span<const TextureUpload> uploads)
+{
+    flushSyncs();
+    // One barrier for the whole batch instead of one per mip
+    std::vector<vk::ImageMemoryBarrier2> barriers;
+    barriers.reserve(uploads.size());
+    for (const TextureUpload& upload : uploads)
+        barriers.emplace_back(makeImageBarrier(upload.texture, CopyDest));
+
+    vk::DependencyInfo dependency_info;
+    dependency_info.setImageMemoryBarriers(barriers);
+    cmdBuf.pipelineBarrier2(dependency_info);
+
+    std::vector<vk::BufferImageCopy> regions;
+    for (const TextureUpload& upload : uploads)
+    {
+        const auto* image = checked_cast<Texture*>(upload.texture.get());
+        const auto* staging = checked_cast<Buffer*>(upload.buffer.get());
+
+        regions.clear();
+        for (const Subresource& sub : upload.subresources)
+        {
+            vk::BufferImageCopy& copyRegion = regions.emplace_back(sub.offset, sub.rowPitch, 0);
+            copyRegion.imageOffset = vk::Offset3D(static_cast<int32_t>(sub.x), static_cast<int32_t>(sub.y), 0);
+            copyRegion.imageExtent = vk::Extent3D(sub.width, sub.height, sub.depth);
+            copyRegion.imageSubresource =
+                vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, sub.index, sub.layer, 1);
+        }
+        cmdBuf.copyBufferToImage(staging->handle, image->handle, vk::ImageLayout::eTransferDstOptimal, regions);
+    }
+
+    barriers.clear();
+    for (const TextureUpload& upload : uploads)
+        barriers.emplace_back(makeImageBarrier(upload.texture, ShaderResource));
+    dependency_info.setImageMemoryBarriers(barriers);
+    cmdBuf.pipelineBarrier2(dependency_info);
+}
+
 void Command::copyBuffer(const BufferPtr& src, const BufferPtr& dst, uint64_t byteSize, uint64_t dstOffset)
 {
+    flushSyncs();
     const auto* buffSrc = checked_cast<Buffer*>(src.get());
     const auto* buffDst = checked_cast<Buffer*>(dst.get());
 
@@ -443,28 +503,122 @@ void Command::copyBuffer(const BufferPtr& src, const BufferPtr& dst, uint64_t by
     cmdBuf.copyBuffer(buffSrc->handle, buffDst->handle, 1, &copyRegion);
 }
 
-void Command::syncBuffer(const BufferPtr& dst, const void* src, uint64_t byteSize)
+void Command::syncBuffer(const BufferPtr& dst, const void* src, uint64_t byteSize, uint64_t dstOffset)
 {
     assert(queueType == QueueType::Graphics);
     const std::unique_ptr<ScratchBuffer>& scratchBuffer = m_context.scratchBufferPool[m_context.frameIndex];
-    const auto* buffSrc = checked_cast<Buffer*>(scratchBuffer->getBuffer().get());
-    const auto* buffDst = checked_cast<Buffer*>(dst.get());
-    uint64_t srcOffset = scratchBuffer->allocate(byteSize);
-    if (buffSrc->staging() && buffSrc->sizeInBytes() >= byteSize)
+    ScratchBuffer::Allocation scratch = scratchBuffer->allocate(byteSize);
+    const auto* buffSrc = checked_cast<Buffer*>(scratch.buffer.get());
+    if (buffSrc->staging() && buffSrc->sizeInBytes() >= scratch.offset + byteSize)
     {
         auto* pCursor = static_cast<std::byte*>(buffSrc->hostInfo.pMappedData);
-        memcpy(pCursor + srcOffset, src, byteSize);
+        memcpy(pCursor + scratch.offset, src, byteSize);
 
-        addBufferBarrier(dst, CopyDest);
-        const vk::BufferCopy copyRegion(srcOffset, 0u, byteSize);
-        cmdBuf.copyBuffer(buffSrc->handle, buffDst->handle, 1, &copyRegion);
+        // Copy is recorded by flushSyncs, merged with the other uploads to the same buffer
+        const auto order = static_cast<uint32_t>(m_syncs.size());
+        m_syncs.emplace_back(dst, std::move(scratch.buffer), scratch.offset, dstOffset, byteSize, order);
     }
     else
         log::error("Failed to upload to Scratch Buffer");
 }
 
-void Command::fillBuffer(const BufferPtr& dst, uint32_t value) const
+void Command::flushSyncs()
+{
+    if (m_syncs.empty())
+        return;
+
+    std::ranges::sort(m_syncs, [](const PendingSync& a, const PendingSync& b) {
+        return std::tie(a.dst, a.dstOffset, a.order) < std::tie(b.dst, b.dstOffset, b.order);
+    });
+
+    const std::unique_ptr<ScratchBuffer>& scratchBuffer = m_context.scratchBufferPool[m_context.frameIndex];
+    const auto mapped = [](const BufferPtr& buffer) {
+        return static_cast<std::byte*>(checked_cast<Buffer*>(buffer.get())->hostInfo.pMappedData);
+    };
+
+    struct Region
+    {
+        vk::Buffer dst;
+        BufferPtr src;
+        vk::BufferCopy copy;
+    };
+    std::vector<Region> regions;
+    std::vector<vk::BufferMemoryBarrier2> before;
+    std::vector<vk::BufferMemoryBarrier2> after;
+    std::vector<const PendingSync*> members;
+
+    for (size_t first = 0; first < m_syncs.size();)
+    {
+        const BufferPtr& dst = m_syncs[first].dst;
+        const vk::Buffer handle = checked_cast<Buffer*>(dst.get())->handle;
+        size_t last = first;
+        while (last < m_syncs.size() && m_syncs[last].dst == dst)
+            ++last;
+
+        // One barrier per destination, restored afterward to what the pass asked for
+        const ResourceState state = dst->state;
+        before.emplace_back(makeBufferBarrier(dst, CopyDest));
+        if (state != Undefined && state != CopyDest)
+            after.emplace_back(makeBufferBarrier(dst, state));
+
+        // Adjacent or overlapping uploads become a single region
+        for (size_t i = first; i < last;)
+        {
+            uint64_t end = m_syncs[i].dstOffset + m_syncs[i].size;
+            bool contiguous = true;
+            size_t j = i + 1;
+            for (; j < last && m_syncs[j].dstOffset <= end; ++j)
+            {
+                const PendingSync& prev = m_syncs[j - 1];
+                const PendingSync& next = m_syncs[j];
+                contiguous &= next.dstOffset == prev.dstOffset + prev.size && next.src == prev.src &&
+                              next.srcOffset == prev.srcOffset + prev.size;
+                end = std::max(end, next.dstOffset + next.size);
+            }
+
+            const PendingSync& head = m_syncs[i];
+            const uint64_t size = end - head.dstOffset;
+            if (contiguous)
+                regions.emplace_back(handle, head.src, vk::BufferCopy(head.srcOffset, head.dstOffset, size));
+            else
+            {
+                // Compose the run in a fresh scratch range, replayed in submission order
+                ScratchBuffer::Allocation merged = scratchBuffer->allocate(size);
+                std::byte* base = mapped(merged.buffer) + merged.offset;
+                members.clear();
+                for (size_t k = i; k < j; ++k)
+                    members.emplace_back(&m_syncs[k]);
+                std::ranges::sort(members, {}, &PendingSync::order);
+                for (const PendingSync* sync : members)
+                    std::memcpy(base + (sync->dstOffset - head.dstOffset), mapped(sync->src) + sync->srcOffset,
+                                sync->size);
+                regions.emplace_back(handle, std::move(merged.buffer), vk::BufferCopy(merged.offset, head.dstOffset, size));
+            }
+            i = j;
+        }
+        first = last;
+    }
+
+    cmdBuf.pipelineBarrier2(vk::DependencyInfo().setBufferMemoryBarriers(before));
+    std::vector<vk::BufferCopy> copies;
+    for (size_t i = 0; i < regions.size();)
+    {
+        copies.clear();
+        size_t j = i;
+        for (; j < regions.size() && regions[j].dst == regions[i].dst && regions[j].src == regions[i].src; ++j)
+            copies.emplace_back(regions[j].copy);
+        cmdBuf.copyBuffer(checked_cast<Buffer*>(regions[i].src.get())->handle, regions[i].dst, copies);
+        i = j;
+    }
+    if (!after.empty())
+        cmdBuf.pipelineBarrier2(vk::DependencyInfo().setBufferMemoryBarriers(after));
+
+    m_syncs.clear();
+}
+
+void Command::fillBuffer(const BufferPtr& dst, uint32_t value)
 {
+    flushSyncs();
     const auto* buff = checked_cast<Buffer*>(dst.get());
     cmdBuf.fillBuffer(buff->handle, 0, VK_WHOLE_SIZE, value);
 }
@@ -511,6 +665,7 @@ void Command::encodeIndirectIndexedPrimitives(const EncodeIndirectIndexedDrawDes
 
 void Command::dispatch(uint32_t x, uint32_t y, uint32_t z)
 {
+    flushSyncs();
     cmdBuf.dispatch(x, y, z);
 }
 
@@ -583,6 +738,7 @@ void Command::pushConstant(const rhi::PipelinePtr& pipeline, ShaderType stage, u
 
 void Command::beginRendering(const RenderingInfo& renderingInfo)
 {
+    flushSyncs();
     vk::RenderingInfo renderInfo;
     vk::RenderingAttachmentInfo depthAttachment;
     std::vector<vk::RenderingAttachmentInfo> colorAttachments;
@@ -626,6 +782,7 @@ void Command::beginRendering(const RenderingInfo& renderingInfo)
 
 void Command::beginRendering(const rhi::PipelinePtr& pipeline, TexturePtr& backBuffer)
 {
+    flushSyncs();
     auto* image = checked_cast<Texture*>(backBuffer.get());
 
     vk::RenderingInfo renderInfo;
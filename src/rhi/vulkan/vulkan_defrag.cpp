@@ -0,0 +1,240 @@
+#include "log/log.hpp"
+#include "rhi/vulkan.hpp"
+
+namespace ler::rhi::vulkan
+{
+static constexpr uint32_t kPollInterval = 120; // Frames between two fragmentation checks
+static constexpr uint32_t kMaxMovesPerPass = 64;
+
+Defragmenter::Defragmenter(Device* device, MemoryPools& pools, uint64_t bytesPerPass)
+    : m_device(device), m_pools(pools), m_bytesPerPass(bytesPerPass)
+{
+}
+
+Defragmenter::~Defragmenter()
+{
+    if (m_defrag == nullptr)
+        return;
+
+    m_device->getContext().device.waitIdle();
+    if (m_state == State::Copying)
+    {
+        // Destination images were never swapped in, VMA keeps the previous placement
+        for (VmaDefragmentationMove& move : std::span(m_pass.pMoves, m_pass.moveCount))
+            move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+    }
+    if (m_state != State::Idle)
+        endPass();
+    if (m_defrag != nullptr)
+        endDefragmentation();
+}
+
+void Defragmenter::track(const std::shared_ptr<CommonBindlessTable>& table)
+{
+    std::erase_if(m_tables, [](const std::weak_ptr<CommonBindlessTable>& t) { return t.expired(); });
+    m_tables.emplace_back(table);
+}
+
+void Defragmenter::update()
+{
+    ++m_frame;
+    switch (m_state)
+    {
+    case State::Idle:
+        if (m_defrag == nullptr && (m_bytesPerPass == 0 || m_frame % kPollInterval != 0 || !beginDefragmentation()))
+            return;
+        beginPass();
+        break;
+    case State::Copying:
+        if (m_device->getGraphicsQueue()->pollCommandList(m_submissionID))
+            swapImages();
+        break;
+    case State::Retiring:
+        if (m_frame >= m_retireFrame)
+            endPass();
+        break;
+    }
+}
+
+bool Defragmenter::beginDefragmentation()
+{
+    const VmaAllocator allocator = m_device->getContext().allocator;
+    const std::vector<VmaPool> pools = m_pools.list(MemoryClass::StreamedTexture);
+    for (size_t i = 0; i < pools.size(); ++i)
+    {
+        // Only worth it once a whole block could be given back
+        const VmaPool pool = pools[(m_nextPool + i) % pools.size()];
+        VmaStatistics stats;
+        vmaGetPoolStatistics(allocator, pool, &stats);
+        if (stats.blockBytes - stats.allocationBytes < MemoryPools::blockSize(MemoryClass::StreamedTexture))
+            continue;
+
+        m_nextPool = (m_nextPool + i + 1) % pools.size();
+        VmaDefragmentationInfo info = {};
+        info.flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT;
+        info.pool = pool;
+        info.maxBytesPerPass = m_bytesPerPass;
+        info.maxAllocationsPerPass = kMaxMovesPerPass;
+        return vmaBeginDefragmentation(allocator, &info, &m_defrag) == VK_SUCCESS;
+    }
+    return false;
+}
+
+void Defragmenter::endDefragmentation()
+{
+    VmaDefragmentationStats stats;
+    vmaEndDefragmentation(m_device->getContext().allocator, m_defrag, &stats);
+    m_defrag = nullptr;
+    log::info("Defragmentation: moved {} MB, freed {} blocks", stats.bytesMoved >> 20,
+              stats.deviceMemoryBlocksFreed);
+}
+
+void Defragmenter::beginPass()
+{
+    const VulkanContext& context = m_device->getContext();
+    if (vmaBeginDefragmentationPass(context.allocator, m_defrag, &m_pass) == VK_SUCCESS)
+    {
+        endDefragmentation();
+        return;
+    }
+
+    std::vector<vk::ImageMemoryBarrier2> before;
+    std::vector<vk::ImageMemoryBarrier2> after;
+    for (VmaDefragmentationMove& move : std::span(m_pass.pMoves, m_pass.moveCount))
+    {
+        VmaAllocationInfo info;
+        vmaGetAllocationInfo(context.allocator, move.srcAllocation, &info);
+        auto* texture = static_cast<Texture*>(info.pUserData);
+
+        // Textures still uploading or being released keep their place
+        std::shared_ptr<Texture> owner = texture ? texture->weak_from_this().lock() : nullptr;
+        if (owner == nullptr || !texture->movable.load(std::memory_order_acquire))
+        {
+            move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+            m_stats.skipped.add();
+            continue;
+        }
+
+        Relocation& relocation = m_relocations.emplace_back(std::move(owner));
+        relocation.image = context.device.createImage(texture->info);
+        vmaBindImageMemory(context.allocator, move.dstTmpAllocation, relocation.image);
+
+        const vk::ImageSubresourceRange range(Device::guessImageAspectFlags(texture->info.format, false), 0,
+                                              VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS);
+        vk::ImageMemoryBarrier2 barrier;
+        barrier.setSubresourceRange(range);
+
+        // Previous frames may still sample the old image, wait for every prior command
+        barrier.setImage(texture->handle);
+        barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+        barrier.setSrcAccessMask(vk::AccessFlagBits2::eShaderRead);
+        barrier.setDstStageMask(vk::PipelineStageFlagBits2::eCopy);
+        barrier.setDstAccessMask(vk::AccessFlagBits2::eTransferRead);
+        barrier.setOldLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+        barrier.setNewLayout(vk::ImageLayout::eTransferSrcOptimal);
+        before.emplace_back(barrier);
+
+        barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eCopy);
+        barrier.setSrcAccessMask({});
+        barrier.setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+        barrier.setDstAccessMask(vk::AccessFlagBits2::eShaderRead);
+        barrier.setOldLayout(vk::ImageLayout::eTransferSrcOptimal);
+        barrier.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+        after.emplace_back(barrier);
+
+        barrier.setImage(relocation.image);
+        barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eNone);
+        barrier.setSrcAccessMask({});
+        barrier.setDstStageMask(vk::PipelineStageFlagBits2::eCopy);
+        barrier.setDstAccessMask(vk::AccessFlagBits2::eTransferWrite);
+        barrier.setOldLayout(vk::ImageLayout::eUndefined);
+        barrier.setNewLayout(vk::ImageLayout::eTransferDstOptimal);
+        before.emplace_back(barrier);
+
+        barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eCopy);
+        barrier.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite);
+        barrier.setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+        barrier.setDstAccessMask(vk::AccessFlagBits2::eShaderRead);
+        barrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
+        barrier.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+        after.emplace_back(barrier);
+    }
+
+    if (m_relocations.empty())
+    {
+        endPass();
+        return;
+    }
+
+    CommandPtr command = m_device->createCommand(QueueType::Graphics);
+    const vk::CommandBuffer cmdBuf = checked_cast<Command*>(command.get())->cmdBuf;
+    cmdBuf.pipelineBarrier2(vk::DependencyInfo().setImageMemoryBarriers(before));
+    std::vector<vk::ImageCopy> regions;
+    for (const Relocation& relocation : m_relocations)
+    {
+        const vk::ImageCreateInfo& info = relocation.texture->info;
+        const vk::ImageAspectFlags aspect = Device::guessImageAspectFlags(info.format, false);
+        regions.clear();
+        for (uint32_t mip = 0; mip < info.mipLevels; ++mip)
+        {
+            const vk::ImageSubresourceLayers layers(aspect, mip, 0, info.arrayLayers);
+            const vk::Extent3D extent(std::max(1u, info.extent.width >> mip), std::max(1u, info.extent.height >> mip),
+                                      std::max(1u, info.extent.depth >> mip));
+            regions.emplace_back(layers, vk::Offset3D(), layers, vk::Offset3D(), extent);
+        }
+        cmdBuf.copyImage(relocation.texture->handle, vk::ImageLayout::eTransferSrcOptimal, relocation.image,
+                         vk::ImageLayout::eTransferDstOptimal, regions);
+    }
+    cmdBuf.pipelineBarrier2(vk::DependencyInfo().setImageMemoryBarriers(after));
+
+    m_device->submitCommand(command);
+    m_submissionID = checked_cast<Command*>(command.get())->submissionID;
+    m_state = State::Copying;
+}
+
+void Defragmenter::swapImages()
+{
+    const VulkanContext& context = m_device->getContext();
+    for (Relocation& relocation : m_relocations)
+    {
+        relocation.image = relocation.texture->relocate(relocation.image, relocation.views);
+        for (const std::weak_ptr<CommonBindlessTable>& weak : m_tables)
+        {
+            if (const std::shared_ptr<CommonBindlessTable> table = weak.lock())
+                table->refreshTexture(relocation.texture.get());
+        }
+
+        VmaAllocationInfo info;
+        vmaGetAllocationInfo(context.allocator, relocation.texture->allocation, &info);
+        m_stats.movedBytes.add(info.size);
+        m_stats.movedTextures.add();
+    }
+
+    // Frames recorded before the swap still reference the old images
+    m_retireFrame = m_frame + ISwapChain::FrameCount;
+    m_state = State::Retiring;
+}
+
+void Defragmenter::endPass()
+{
+    const VulkanContext& context = m_device->getContext();
+    for (Relocation& relocation : m_relocations)
+    {
+        relocation.views.clear();
+        context.device.destroyImage(relocation.image);
+    }
+    m_relocations.clear();
+    m_state = State::Idle;
+    m_stats.passes.add();
+
+    if (vmaEndDefragmentationPass(context.allocator, m_defrag, &m_pass) == VK_SUCCESS)
+        endDefragmentation();
+}
+
+json Defragmenter::getStats() const
+{
+    return json{ { "active", m_defrag != nullptr },     { "passes", m_stats.passes },
+                 { "moved_bytes", m_stats.movedBytes }, { "moved_textures", m_stats.movedTextures },
+                 { "skipped", m_stats.skipped },        { "bytes_per_pass", m_bytesPerPass } };
+}
+} // namespace ler::rhi::vulkan
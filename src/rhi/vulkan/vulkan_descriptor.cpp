@@ -174,7 +174,15 @@ bool BindlessTable::visitTexture(const TexturePtr& texture, uint32_t slot)
 
     vk::DescriptorImageInfo imageInfo;
     imageInfo.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
-    imageInfo.setImageView(image->view());
+    // Texture arrays are sampled as Texture2DArray from the same heap
+    if (image->info.arrayLayers > 1)
+    {
+        const vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, image->info.mipLevels, 0,
+                                              image->info.arrayLayers);
+        imageInfo.setImageView(image->view(range));
+    }
+    else
+        imageInfo.setImageView(image->view());
 
     const vk::DescriptorGetInfoEXT info(type, &imageInfo);
     m_context.device.getDescriptorEXT(info, getDescriptorSizeForType(type), cpuHandle);
@@ -240,6 +248,8 @@ uint64_t BindlessTable::getOffsetFromIndex(uint32_t index) const
 
 BindlessTablePtr Device::createBindlessTable(uint32_t count)
 {
-    return std::make_shared<BindlessTable>(m_context, count);
+    auto table = std::make_shared<BindlessTable>(m_context, count);
+    m_defrag->track(table);
+    return table;
 }
 } // namespace ler::rhi::vulkan
\ No newline at end of file
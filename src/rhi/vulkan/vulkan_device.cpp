@@ -31,6 +31,8 @@ Device::~Device()
     for(auto& sb : m_context.scratchBufferPool)
         sb.reset();
     m_storage.reset();
+    m_defrag.reset();
+    m_pools.clear();
     vmaDestroyAllocator(m_context.allocator);
 }
 
@@ -50,7 +52,8 @@ using FeaturesChain = vk::StructureChain<vk::PhysicalDeviceFeatures2,
                     vk::PhysicalDeviceDescriptorBufferFeaturesEXT,
                     vk::PhysicalDeviceRayQueryFeaturesKHR,
                     vk::PhysicalDeviceRayTracingPipelineFeaturesKHR,
-                    vk::PhysicalDeviceAccelerationStructureFeaturesKHR>;
+                    vk::PhysicalDeviceAccelerationStructureFeaturesKHR,
+                    vk::PhysicalDeviceHostImageCopyFeaturesEXT>;
 
 using InfoChain = vk::StructureChain<vk::DeviceCreateInfo,
                     vk::PhysicalDeviceVulkan11Features,
@@ -62,7 +65,8 @@ using InfoChain = vk::StructureChain<vk::DeviceCreateInfo,
                     vk::PhysicalDeviceDescriptorBufferFeaturesEXT,
                     vk::PhysicalDeviceRayQueryFeaturesKHR,
                     vk::PhysicalDeviceRayTracingPipelineFeaturesKHR,
-                    vk::PhysicalDeviceAccelerationStructureFeaturesKHR>;
+                    vk::PhysicalDeviceAccelerationStructureFeaturesKHR,
+                    vk::PhysicalDeviceHostImageCopyFeaturesEXT>;
 // clang-format on
 
 VulkanFeatures getSupportedFeatures(const std::set<std::string>& supportedExtensionSet, const PropertiesChain& p,
@@ -85,6 +89,8 @@ VulkanFeatures getSupportedFeatures(const std::set<std::string>& supportedExtens
         features.mutableDescriptor = true;
     if (supportedExtensionSet.contains(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME))
         features.descriptorBuffer = true;
+    if (supportedExtensionSet.contains(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME))
+        features.hostImageCopy = f.get<vk::PhysicalDeviceHostImageCopyFeaturesEXT>().hostImageCopy;
 
     return features;
 }
@@ -132,6 +138,10 @@ void populateRequiredDeviceExtensions(const VulkanFeatures& features, std::vecto
     // Enable Descriptor Buffer
     if (features.descriptorBuffer)
         deviceExtensions.emplace_back(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+
+    // Enable Host Image Copy (VK_KHR_copy_commands2 and VK_KHR_format_feature_flags2 are core in 1.3)
+    if (features.hostImageCopy)
+        deviceExtensions.emplace_back(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME);
 }
 
 void printVulkanFeatures(const VulkanFeatures& features, const PropertiesChain& p, const FeaturesChain& f)
@@ -147,6 +157,7 @@ void printVulkanFeatures(const VulkanFeatures& features, const PropertiesChain&
     log::info("HostBuffer: {}", features.hostBuffer);
     log::info("DescriptorBuffer: {}", features.descriptorBuffer);
     log::info("MutableDescriptor: {}", features.mutableDescriptor);
+    log::info("HostImageCopy: {}", features.hostImageCopy);
     log::info("MultiDrawIndirect: {}", features.multiDrawIndirect);
     log::info("DrawIndirectCount: {}", features.drawIndirectCount);
     log::info("SubgroupSize: {}", subgroupProps.subgroupSize);
@@ -170,6 +181,8 @@ void unlinkUnsupportedFeatures(InfoChain& createInfoChain, const VulkanFeatures&
         createInfoChain.unlink<vk::PhysicalDeviceMutableDescriptorTypeFeaturesEXT>();
     if (!features.descriptorBuffer)
         createInfoChain.unlink<vk::PhysicalDeviceDescriptorBufferFeaturesEXT>();
+    if (!features.hostImageCopy)
+        createInfoChain.unlink<vk::PhysicalDeviceHostImageCopyFeaturesEXT>();
     if (!features.rayTracing)
     {
         createInfoChain.unlink<vk::PhysicalDeviceRayQueryFeaturesKHR>();
@@ -337,6 +350,9 @@ Device::Device(const DeviceConfig& config)
     vk::PhysicalDeviceAccelerationStructureFeaturesKHR accelerationStructureFeatures;
     accelerationStructureFeatures.setAccelerationStructure(true);
 
+    vk::PhysicalDeviceHostImageCopyFeaturesEXT hostImageCopyFeatures;
+    hostImageCopyFeatures.setHostImageCopy(true);
+
     // clang-format off
     InfoChain createInfoChain(deviceInfo,
         ff.get<vk::PhysicalDeviceVulkan11Features>(),
@@ -348,7 +364,8 @@ Device::Device(const DeviceConfig& config)
         descriptorFeature,
         rayQueryFeatures,
         rayTracingPipelineFeatures,
-        accelerationStructureFeatures);
+        accelerationStructureFeatures,
+        hostImageCopyFeatures);
     // clang-format on
 
     unlinkUnsupportedFeatures(createInfoChain, vulkanFeatures);
@@ -370,6 +387,7 @@ Device::Device(const DeviceConfig& config)
 
     VmaAllocator allocator;
     vmaCreateAllocator(&allocatorCreateInfo, &allocator);
+    m_pools.init(allocator);
 
     m_context.device = m_device.get();
     m_context.instance = m_instance.get();
@@ -387,8 +405,12 @@ Device::Device(const DeviceConfig& config)
     m_context.constantLayout = m_constantLayout.get();
 
     m_context.hostBuffer = config.hostBuffer;
+    m_context.directIo = config.directIo;
+    m_context.verifyContent = config.verifyContent;
     m_context.hostPointerAlignment =
         pp.get<vk::PhysicalDeviceExternalMemoryHostPropertiesEXT>().minImportedHostPointerAlignment;
+    m_context.hostImageCopy = vulkanFeatures.hostImageCopy && supportsHostCopyLayout();
+    m_context.directUploadHeap = findDirectUploadHeap();
 
     m_queues[static_cast<int>(QueueType::Graphics)] = std::make_unique<Queue>(m_context, QueueType::Graphics);
     m_queues[static_cast<int>(QueueType::Transfer)] = std::make_unique<Queue>(m_context, QueueType::Transfer);
@@ -399,6 +421,7 @@ Device::Device(const DeviceConfig& config)
     m_threadPool = std::make_shared<coro::thread_pool>(coro::thread_pool::options{ .thread_count = 8 });
 
     m_storage = std::make_shared<Storage>(this, m_threadPool);
+    m_defrag = std::make_unique<Defragmenter>(this, m_pools, config.defragBytesPerPass);
     m_library = std::make_shared<PSOLibrary>(this);
 }
 
@@ -421,6 +444,17 @@ void Buffer::getUint(uint32_t* ptr) const
         log::error("Failed to read into buffer");
 }
 
+void Buffer::downloadToMemory(void* dst, uint64_t sizeBytes) const
+{
+    if (staging() && sizeInBytes() >= sizeBytes)
+    {
+        vmaInvalidateAllocation(m_context.allocator, allocation, 0, sizeBytes);
+        std::memcpy(dst, hostInfo.pMappedData, sizeBytes);
+    }
+    else
+        log::error("Failed to read from buffer");
+}
+
 static void aligned_free(void* pMemory)
 {
 #ifdef _WIN32
@@ -529,12 +563,11 @@ BufferPtr Device::createBuffer(uint64_t sizeInBytes, bool staging)
     buffer->info.setSharingMode(vk::SharingMode::eExclusive);
 
     buffer->allocInfo.usage = VMA_MEMORY_USAGE_AUTO;
-    buffer->allocInfo.flags =
-        staging ? VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT
-                : VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+    if (staging)
+        buffer->allocInfo.flags =
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
 
-    vmaCreateBuffer(m_context.allocator, reinterpret_cast<VkBufferCreateInfo*>(&buffer->info), &buffer->allocInfo,
-                    reinterpret_cast<VkBuffer*>(&buffer->handle), &buffer->allocation, &buffer->hostInfo);
+    allocateBuffer(*buffer, staging ? MemoryClass::Transient : MemoryClass::StaticGeometry, 0);
 
     return buffer;
 }
@@ -569,24 +602,31 @@ BufferPtr Device::createBuffer(const BufferDesc& desc)
     buffer->info.setSharingMode(vk::SharingMode::eExclusive);
 
     log::debug("Create Buffer {} -> {}", desc.debugName, vk::to_string(usageFlags));
-    buffer->allocInfo.usage = VMA_MEMORY_USAGE_AUTO;
-    buffer->allocInfo.flags =
-        desc.isStaging || desc.isReadBack
-            ? VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT
-            : VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
 
-    if (desc.alignment == 0)
-    {
-        vmaCreateBuffer(m_context.allocator, reinterpret_cast<VkBufferCreateInfo*>(&buffer->info), &buffer->allocInfo,
-                        reinterpret_cast<VkBuffer*>(&buffer->handle), &buffer->allocation, &buffer->hostInfo);
-    }
-    else
+    // Mapped device-local memory lets the IO service read straight into the final allocation
+    if (desc.isDirectUpload && hasDirectUploadBudget(desc.sizeInBytes))
     {
-        vmaCreateBufferWithAlignment(m_context.allocator, reinterpret_cast<VkBufferCreateInfo*>(&buffer->info),
-                                     &buffer->allocInfo, desc.alignment, reinterpret_cast<VkBuffer*>(&buffer->handle),
-                                     &buffer->allocation, &buffer->hostInfo);
+        buffer->allocInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+        buffer->allocInfo.flags =
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        buffer->allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+        if (allocateBuffer(*buffer, MemoryClass::StaticGeometry, desc.alignment) == VK_SUCCESS)
+        {
+            buffer->setName(desc.debugName);
+            return buffer;
+        }
+        log::warn("Direct upload allocation failed for {}, using staging", desc.debugName);
+        buffer->allocInfo = {};
+        buffer->hostInfo = {};
     }
 
+    const bool host = desc.isStaging || desc.isReadBack;
+    buffer->allocInfo.usage = VMA_MEMORY_USAGE_AUTO;
+    if (host)
+        buffer->allocInfo.flags =
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    allocateBuffer(*buffer, host ? MemoryClass::Transient : MemoryClass::StaticGeometry, desc.alignment);
+
     buffer->setName(desc.debugName);
     return buffer;
 }
@@ -624,9 +664,296 @@ vk::DeviceAddress Buffer::getGPUAddress() const
 
 TexturePtr Device::createTexture(const TextureDesc& desc)
 {
-    auto texture = std::make_shared<Texture>(m_context);
-    populateTexture(texture, desc);
-    return texture;
+    return createTextures(std::span(&desc, 1)).front();
+}
+
+std::vector<TexturePtr> Device::createTextures(std::span<const TextureDesc> descs)
+{
+    std::vector<TexturePtr> textures;
+    textures.reserve(descs.size());
+
+    for (const TextureDesc& desc : descs)
+    {
+        auto texture = std::make_shared<Texture>(m_context);
+        populateTexture(texture, desc);
+        texture->handle = m_context.device.createImage(texture->info);
+        texture->setName(desc.debugName);
+
+        const MemoryClass memoryClass =
+            desc.isRenderTarget || desc.isUAV ? MemoryClass::RenderTarget : MemoryClass::StreamedTexture;
+        VmaAllocationInfo hostInfo;
+        VkResult res = allocateTexture(*texture, memoryClass, hostInfo);
+        if (res == VK_SUCCESS)
+            res = vmaBindImageMemory2(m_context.allocator, texture->allocation, 0, texture->handle, nullptr);
+        if (res != VK_SUCCESS)
+        {
+            log::error("Failed to allocate texture {}: {}", desc.debugName, vk::to_string(vk::Result(res)));
+            if (texture->allocation == nullptr)
+                m_context.device.destroyImage(texture->handle);
+            throw std::runtime_error("failed to create texture!");
+        }
+        // Lets the defragmenter find the texture behind a moved allocation
+        if (memoryClass == MemoryClass::StreamedTexture)
+            vmaSetAllocationUserData(m_context.allocator, texture->allocation, texture.get());
+
+        textures.emplace_back(std::move(texture));
+    }
+
+    return textures;
+}
+
+void Device::selectPool(VmaAllocationCreateInfo& allocInfo, MemoryClass memoryClass, uint64_t sizeInBytes,
+                        uint32_t memoryTypeIndex)
+{
+    // Resources bigger than half a block would waste most of it, they keep their own memory
+    if (sizeInBytes > MemoryPools::blockSize(memoryClass) / 2)
+        allocInfo.flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+    else
+        allocInfo.pool = m_pools.get(memoryClass, memoryTypeIndex);
+}
+
+VkResult Device::allocateBuffer(Buffer& buffer, MemoryClass memoryClass, uint32_t alignment)
+{
+    auto* info = reinterpret_cast<VkBufferCreateInfo*>(&buffer.info);
+    uint32_t memoryTypeIndex;
+    if (vmaFindMemoryTypeIndexForBufferInfo(m_context.allocator, info, &buffer.allocInfo, &memoryTypeIndex) ==
+        VK_SUCCESS)
+        selectPool(buffer.allocInfo, memoryClass, buffer.info.size, memoryTypeIndex);
+
+    const auto create = [&] {
+        if (alignment == 0)
+            return vmaCreateBuffer(m_context.allocator, info, &buffer.allocInfo,
+                                   reinterpret_cast<VkBuffer*>(&buffer.handle), &buffer.allocation, &buffer.hostInfo);
+        return vmaCreateBufferWithAlignment(m_context.allocator, info, &buffer.allocInfo, alignment,
+                                            reinterpret_cast<VkBuffer*>(&buffer.handle), &buffer.allocation,
+                                            &buffer.hostInfo);
+    };
+
+    VkResult res = create();
+    if (res != VK_SUCCESS && buffer.allocInfo.pool)
+    {
+        log::warn("Pool allocation failed for buffer {}, using default heap", buffer.info.size);
+        buffer.allocInfo.pool = nullptr;
+        res = create();
+    }
+    return res;
+}
+
+VkResult Device::allocateTexture(Texture& texture, MemoryClass memoryClass, VmaAllocationInfo& hostInfo)
+{
+    // AUTO usage needs the create info, resolve the memory type first then allocate against it
+    VmaAllocationCreateInfo search = {};
+    search.usage = VMA_MEMORY_USAGE_AUTO;
+    uint32_t memoryTypeIndex;
+    VkResult res = vmaFindMemoryTypeIndexForImageInfo(
+        m_context.allocator, reinterpret_cast<VkImageCreateInfo*>(&texture.info), &search, &memoryTypeIndex);
+    if (res != VK_SUCCESS)
+        return res;
+
+    const vk::MemoryRequirements requirements = m_context.device.getImageMemoryRequirements(texture.handle);
+    texture.allocInfo = {};
+    texture.allocInfo.memoryTypeBits = 1u << memoryTypeIndex;
+    selectPool(texture.allocInfo, memoryClass, requirements.size, memoryTypeIndex);
+
+    const auto allocate = [&] {
+        return vmaAllocateMemoryForImage(m_context.allocator, texture.handle, &texture.allocInfo, &texture.allocation,
+                                         &hostInfo);
+    };
+
+    res = allocate();
+    if (res != VK_SUCCESS && texture.allocInfo.pool)
+    {
+        log::warn("Pool allocation failed for texture {}, using default heap", texture.name);
+        texture.allocInfo.pool = nullptr;
+        res = allocate();
+    }
+    return res;
+}
+
+json Device::getMemoryStats() const
+{
+    json j = m_pools.getStats();
+    j["defrag"] = m_defrag->getStats();
+    return j;
+}
+
+void MemoryPools::init(VmaAllocator allocator)
+{
+    m_allocator = allocator;
+}
+
+void MemoryPools::clear()
+{
+    std::lock_guard lock(m_mutex);
+    for (const VmaPool pool : m_pools | std::views::values)
+        vmaDestroyPool(m_allocator, pool);
+    m_pools.clear();
+}
+
+uint64_t MemoryPools::blockSize(MemoryClass memoryClass)
+{
+    switch (memoryClass)
+    {
+    case MemoryClass::StreamedTexture:
+        return 256ull << 20;
+    case MemoryClass::RenderTarget:
+    case MemoryClass::StaticGeometry:
+        return 128ull << 20;
+    default:
+        return 64ull << 20;
+    }
+}
+
+std::vector<VmaPool> MemoryPools::list(MemoryClass memoryClass) const
+{
+    std::vector<VmaPool> pools;
+    std::lock_guard lock(m_mutex);
+    for (const auto& [key, pool] : m_pools)
+        if (key.first == memoryClass && pool != nullptr)
+            pools.emplace_back(pool);
+    return pools;
+}
+
+VmaPool MemoryPools::get(MemoryClass memoryClass, uint32_t memoryTypeIndex)
+{
+    std::lock_guard lock(m_mutex);
+    const auto key = std::make_pair(memoryClass, memoryTypeIndex);
+    if (const auto it = m_pools.find(key); it != m_pools.end())
+        return it->second;
+
+    VmaPoolCreateInfo info = {};
+    info.memoryTypeIndex = memoryTypeIndex;
+    info.blockSize = blockSize(memoryClass);
+
+    VmaPool pool = nullptr;
+    if (vmaCreatePool(m_allocator, &info, &pool) != VK_SUCCESS)
+        log::warn("Failed to create memory pool for type {}", memoryTypeIndex);
+    m_pools.emplace(key, pool);
+    return pool;
+}
+
+json MemoryPools::getStats() const
+{
+    static constexpr std::array kNames = { "streamed_texture", "render_target", "static_geometry", "transient" };
+
+    std::array<VmaStatistics, static_cast<size_t>(MemoryClass::Count)> total = {};
+    {
+        std::lock_guard lock(m_mutex);
+        for (const auto& [key, pool] : m_pools)
+        {
+            if (pool == nullptr)
+                continue;
+            VmaStatistics stats;
+            vmaGetPoolStatistics(m_allocator, pool, &stats);
+            VmaStatistics& sum = total[static_cast<size_t>(key.first)];
+            sum.blockCount += stats.blockCount;
+            sum.allocationCount += stats.allocationCount;
+            sum.blockBytes += stats.blockBytes;
+            sum.allocationBytes += stats.allocationBytes;
+        }
+    }
+
+    json j;
+    for (size_t i = 0; i < total.size(); ++i)
+        j[kNames[i]] = { { "blocks", total[i].blockCount },
+                         { "allocations", total[i].allocationCount },
+                         { "block_bytes", total[i].blockBytes },
+                         { "allocation_bytes", total[i].allocationBytes } };
+    return j;
+}
+
+bool Device::supportsHostCopyLayout() const
+{
+    // Uploads land directly in the sampling layout, skip the extension if it cannot target it
+    vk::PhysicalDeviceHostImageCopyPropertiesEXT hostCopyProps;
+    vk::PhysicalDeviceProperties2 props;
+    props.pNext = &hostCopyProps;
+    m_physicalDevice.getProperties2(&props);
+
+    std::vector<vk::ImageLayout> layouts(hostCopyProps.copyDstLayoutCount);
+    hostCopyProps.pCopyDstLayouts = layouts.data();
+    m_physicalDevice.getProperties2(&props);
+
+    if (std::ranges::find(layouts, vk::ImageLayout::eShaderReadOnlyOptimal) != layouts.end())
+        return true;
+
+    log::warn("HostImageCopy: ShaderReadOnlyOptimal is not a supported destination layout");
+    return false;
+}
+
+uint32_t Device::findDirectUploadHeap() const
+{
+    // Small BAR windows (256MB) are left to the driver, only resizable BAR or UMA heaps qualify
+    static constexpr vk::DeviceSize kMinHeapSize = 256ull << 20;
+    static constexpr vk::MemoryPropertyFlags kFlags =
+        vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eHostVisible;
+
+    const vk::PhysicalDeviceMemoryProperties props = m_physicalDevice.getMemoryProperties();
+    for (uint32_t i = 0; i < props.memoryTypeCount; ++i)
+    {
+        const vk::MemoryType& type = props.memoryTypes[i];
+        if ((type.propertyFlags & kFlags) != kFlags || props.memoryHeaps[type.heapIndex].size <= kMinHeapSize)
+            continue;
+        log::info("DirectUpload: heap {} ({} MB)", type.heapIndex, props.memoryHeaps[type.heapIndex].size >> 20);
+        return type.heapIndex;
+    }
+
+    log::info("DirectUpload: false");
+    return UINT32_MAX;
+}
+
+bool Device::hasDirectUploadBudget(uint64_t sizeInBytes) const
+{
+    if (m_context.directUploadHeap == UINT32_MAX)
+        return false;
+
+    // Keep a quarter of the heap for render targets and driver allocations
+    std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets = {};
+    vmaGetHeapBudgets(m_context.allocator, budgets.data());
+    const VmaBudget& budget = budgets[m_context.directUploadHeap];
+    return budget.usage + sizeInBytes <= budget.budget - budget.budget / 4;
+}
+
+bool Device::isHostCopyCompatible(vk::Format format) const
+{
+    vk::FormatProperties3 props3;
+    vk::FormatProperties2 props;
+    props.pNext = &props3;
+    m_physicalDevice.getFormatProperties2(format, &props);
+    return static_cast<bool>(props3.optimalTilingFeatures & vk::FormatFeatureFlagBits2::eHostImageTransferEXT);
+}
+
+void Device::copyMemoryToTexture(const TexturePtr& texture, std::span<const Subresource> subresources,
+                                 const std::byte* src) const
+{
+    const auto* image = checked_cast<Texture*>(texture.get());
+    assert(image->hostTransfer);
+
+    constexpr vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal;
+    const vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, VK_REMAINING_MIP_LEVELS, 0,
+                                          VK_REMAINING_ARRAY_LAYERS);
+    const vk::HostImageLayoutTransitionInfoEXT transition(image->handle, vk::ImageLayout::eUndefined, layout, range);
+    m_device->transitionImageLayoutEXT(transition);
+
+    std::vector<vk::MemoryToImageCopyEXT> regions;
+    regions.reserve(subresources.size());
+    for (const Subresource& sub : subresources)
+    {
+        vk::MemoryToImageCopyEXT& region = regions.emplace_back();
+        region.pHostPointer = src + sub.offset;
+        region.memoryRowLength = sub.rowPitch;
+        region.imageSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, sub.index, sub.layer, 1);
+        region.imageExtent = vk::Extent3D(sub.width, sub.height, sub.depth);
+    }
+
+    vk::CopyMemoryToImageInfoEXT copyInfo;
+    copyInfo.setDstImage(image->handle);
+    copyInfo.setDstImageLayout(layout);
+    copyInfo.setRegions(regions);
+    m_device->copyMemoryToImageEXT(copyInfo);
+
+    // Host copies are complete on return and visible to later submissions
+    texture->state = ShaderResource;
 }
 
 void Device::waitIdle()
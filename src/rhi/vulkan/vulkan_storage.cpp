@@ -21,7 +21,43 @@ Storage::Storage(Device* device, std::shared_ptr<coro::thread_pool>& tp) : Commo
 
 ReadOnlyFilePtr Storage::openFile(const fs::path& path)
 {
-    return std::make_shared<ReadOnlyFile>(path);
+    const VulkanContext& context = checked_cast<Device*>(m_device)->getContext();
+    return std::make_shared<ReadOnlyFile>(path, context.directIo);
+}
+
+coro::task<std::vector<ReadOnlyFilePtr>> Storage::openFilesAsync(std::vector<fs::path> paths)
+{
+    std::vector<sys::IoService::FileOpenRequest> requests(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i)
+        requests[i].path = std::move(paths[i]);
+
+    co_await m_ios.open(requests);
+
+    const VulkanContext& context = checked_cast<Device*>(m_device)->getContext();
+    std::vector<ReadOnlyFilePtr> files;
+    files.reserve(requests.size());
+    for (const sys::IoService::FileOpenRequest& req : requests)
+    {
+        if (req.error != 0)
+        {
+            log::error("[Storage] Failed to open {}: {}", req.path.string(), std::system_category().message(req.error));
+            continue;
+        }
+        files.emplace_back(std::make_shared<ReadOnlyFile>(req.path, req.handle, req.size, context.directIo));
+    }
+    co_return files;
+}
+
+json Storage::getTelemetry() const
+{
+    json j = CommonStorage::getTelemetry();
+    j["io"] = m_ios.getStats();
+    j["io"]["backend"] = sys::toString(m_ios.getBackend());
+    j["transfer_queue"] = checked_cast<Device*>(m_device)->getTransferQueue()->getStats();
+    j["memory_pools"] = checked_cast<Device*>(m_device)->getMemoryStats();
+    for (const std::unique_ptr<ScratchBuffer>& scratch : checked_cast<Device*>(m_device)->getContext().scratchBufferPool)
+        j["scratch"].push_back(scratch->getStats());
+    return j;
 }
 
 static void queueTexture(const ReadOnlyFilePtr& file, sys::IoService::FileLoadRequest& req)
@@ -46,7 +82,13 @@ coro::task<> Storage::makeSingleTextureTask(coro::latch& latch, BindlessTablePtr
     queueTexture(file, request);
     const int bufferIndex = co_await acquireStaging();
     request.buffIndex = bufferIndex;
-    co_await m_ios.submit(request);
+    if (!co_await m_ios.submit(request))
+    {
+        log::error("Failed to read texture header: {}", file->getFilename());
+        latch.count_down();
+        releaseStaging(bufferIndex);
+        co_return;
+    }
 
     const img::ITexture* tex = factoryTexture(file, m_ios.getMemPtr(bufferIndex));
 
@@ -62,24 +104,26 @@ coro::task<> Storage::makeSingleTextureTask(coro::latch& latch, BindlessTablePtr
     request.fileOffset = head;
     request.buffIndex = bufferIndex;
 
-    CommandPtr cmd = m_device->createCommand(QueueType::Transfer);
+    std::vector<Subresource> regions;
     for (const uint32_t mip : std::views::iota(0u, levels.size()))
     {
         const img::ITexture::LevelIndexEntry& level = levels[mip];
         log::info("byteOffset = {}, byteLength = {}", level.byteOffset, level.byteLength);
 
-        Subresource sub;
+        Subresource& sub = regions.emplace_back();
         sub.index = mip;
         sub.offset = level.byteOffset - head;
         sub.width = desc.width >> mip;
         sub.height = desc.height >> mip;
-
-        cmd->copyBufferToTexture(getStaging(bufferIndex), texture, sub, nullptr);
     }
 
-    co_await m_ios.submit(request);
-
-    m_device->submitOneShot(cmd);
+    if (co_await m_ios.submit(request))
+    {
+        const TextureUpload upload(getStaging(bufferIndex), texture, regions);
+        uploadTextures({ &upload, 1 });
+    }
+    else
+        log::error("Failed to read texture: {}", desc.debugName);
 
     latch.count_down();
     releaseStaging(bufferIndex);
@@ -87,6 +131,36 @@ coro::task<> Storage::makeSingleTextureTask(coro::latch& latch, BindlessTablePtr
     co_return;
 }
 
+void Storage::uploadTextures(std::span<const TextureUpload> uploads)
+{
+    // Host image copy skips the transfer command entirely, the rest is batched on the GPU
+    const auto* device = checked_cast<Device*>(m_device);
+    std::vector<TextureUpload> gpuUploads;
+    for (const TextureUpload& upload : uploads)
+    {
+        if (checked_cast<Texture*>(upload.texture.get())->hostTransfer)
+        {
+            const auto* staging = checked_cast<Buffer*>(upload.buffer.get());
+            const auto* data = static_cast<const std::byte*>(staging->hostInfo.pMappedData);
+            device->copyMemoryToTexture(upload.texture, upload.subresources, data);
+            checked_cast<Texture*>(upload.texture.get())->movable.store(true, std::memory_order_release);
+        }
+        else
+            gpuUploads.emplace_back(upload);
+    }
+
+    if (gpuUploads.empty())
+        return;
+
+    CommandPtr cmd = m_device->createCommand(QueueType::Transfer);
+    cmd->copyBufferToTextures(gpuUploads);
+    m_device->submitOneShot(cmd);
+
+    // submitOneShot returns once the fence has signalled
+    for (const TextureUpload& upload : gpuUploads)
+        checked_cast<Texture*>(upload.texture.get())->movable.store(true, std::memory_order_release);
+}
+
 size_t computeDDSPadding(size_t headerSize = 148, size_t existingOffset = 0, size_t alignment = 16)
 {
     // Calculate the total offset (header + existing offset)
@@ -132,27 +206,44 @@ coro::task<> Storage::makeMultiTextureTask(coro::latch& latch, BindlessTablePtr
         offset += byteSizes;
     }
 
-    co_await m_ios.submit(requests);
+    if (!co_await m_ios.submit(requests))
+    {
+        log::error("Failed to read {} textures", files.size());
+        latch.count_down();
+        for (const uint32_t buffId : stagings)
+            releaseStaging(buffId);
+        co_return;
+    }
 
-    CommandPtr cmd = m_device->createCommand(QueueType::Transfer);
     std::vector<TextureStreaming> result;
     result.reserve(files.size());
+    std::vector<std::vector<Subresource>> regions(files.size());
+    std::vector<TextureUpload> uploads;
+    uploads.reserve(files.size());
+
+    // Parse every header first so the images are created in one batch
+    std::vector<const img::ITexture*> images(files.size());
+    std::vector<TextureDesc> descs(files.size());
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        const sys::IoService::FileLoadRequest& req = requests[i];
+        images[i] = factoryTexture(files[i], m_ios.getMemPtr(req.buffIndex) + req.buffOffset);
+        descs[i] = images[i]->desc();
+        descs[i].debugName = files[i]->getFilename();
+    }
+    const std::vector<TexturePtr> textures = m_device->createTextures(descs);
 
     {
         std::lock_guard lock = table->lock();
         for (size_t i = 0; i < files.size(); ++i)
         {
-            const ReadOnlyFilePtr& file = files[i];
             const sys::IoService::FileLoadRequest& req = requests[i];
-            std::byte* data = m_ios.getMemPtr(req.buffIndex);
-            const img::ITexture* tex = factoryTexture(file, data + req.buffOffset);
-            std::span levels = tex->levels();
-            TextureDesc desc = tex->desc();
-            desc.debugName = file->getFilename();
+            std::span levels = images[i]->levels();
+            const TextureDesc& desc = descs[i];
 
             // uint32_t texIndex = table->allocate();
-            TexturePtr texture = m_device->createTexture(desc);
-            result.emplace_back(table->createResourceView(texture), desc.debugName);
+            const TexturePtr& texture = textures[i];
+            result.emplace_back(table->createResourceView(texture), sys::makeAssetId(desc.debugName));
             log::info("Load texture {:03}: {}", result.back().view->getBindlessIndex(), desc.debugName);
             // table->setResource(texture, texIndex);
 
@@ -161,17 +252,17 @@ coro::task<> Storage::makeMultiTextureTask(coro::latch& latch, BindlessTablePtr
                 const img::ITexture::LevelIndexEntry& level = levels[mip];
                 // log::info("byteOffset = {}, byteLength = {}", level.byteOffset, level.byteLength);
 
-                Subresource sub;
+                Subresource& sub = regions[i].emplace_back();
                 sub.index = mip;
                 sub.offset = level.byteOffset + req.buffOffset;
                 sub.width = desc.width >> mip;
                 sub.height = desc.height >> mip;
-                cmd->copyBufferToTexture(getStaging(req.buffIndex), texture, sub, nullptr);
             }
+            uploads.emplace_back(getStaging(req.buffIndex), texture, regions[i]);
         }
     }
 
-    m_device->submitOneShot(cmd);
+    uploadTextures(uploads);
     m_dispatcher.enqueue(result);
 
     latch.count_down();
@@ -213,6 +304,28 @@ static constexpr size_t computePitch(Format fmt, size_t width, size_t height)
     return static_cast<size_t>(pitch);
 }
 
+// Same padded layout as the packer, for paks written without footprints
+static std::vector<Subresource> computeFootprints(const TextureDesc& desc)
+{
+    std::vector<Subresource> footprints;
+    uint64_t offset = 0;
+    const FormatBlockInfo info = formatToBlockInfo(desc.format);
+    for (const uint32_t mip : std::views::iota(0u, desc.mipLevels))
+    {
+        Subresource& sub = footprints.emplace_back();
+        sub.index = mip;
+        sub.offset = offset;
+        sub.width = desc.width >> mip;
+        sub.height = desc.height >> mip;
+        const uint64_t rowPitch = align<uint64_t>(computePitch(desc.format, sub.width, sub.height), 256);
+        sub.rowPitch = rowPitch / info.blockSizeByte * info.blockWidth;
+
+        const uint64_t height = std::max<uint64_t>(1, (sub.height + 3) / 4);
+        offset += align<uint64_t>(rowPitch * height, 512);
+    }
+    return footprints;
+}
+
 coro::task<> Storage::makeMultiTextureTask(coro::latch& latch, BindlessTablePtr table,
                                            std::vector<TextureStreamingMetadata> textures)
 {
@@ -222,58 +335,84 @@ coro::task<> Storage::makeMultiTextureTask(coro::latch& latch, BindlessTablePtr
     std::vector<sys::IoService::FileLoadRequest> requests(textures.size());
 
     uint64_t offset = 0;
-    uint64_t offsetSubresource = 0;
     int bufferId = co_await acquireStaging();
-    CommandPtr cmd = m_device->createCommand(QueueType::Transfer);
 
+    sys::IoOptions options = textures.front().options;
+    for (size_t i = 0; i < textures.size(); ++i)
     {
-        std::lock_guard lock = table->lock();
-        for (size_t i = 0; i < textures.size(); ++i)
-        {
-            const TextureStreamingMetadata& metadata = textures[i];
-            const TextureDesc& desc = metadata.desc;
-            TexturePtr texture = m_device->createTexture(desc);
-            result.emplace_back(table->createResourceView(texture), metadata.desc.debugName);
-            log::info("Load texture {:03}: {}", result.back().view->getBindlessIndex(), desc.debugName);
+        const TextureStreamingMetadata& metadata = textures[i];
+        queueTexture(metadata.file, requests[i]);
 
-            queueTexture(metadata.file, requests[i]);
+        // Keep staging and file offsets congruent so pak entries can be read with direct IO
+        offset = align(offset, sys::ReadOnlyFile::kDirectAlignment);
 
-            requests[i].buffOffset = offset;
-            requests[i].buffIndex = bufferId;
-            requests[i].fileLength = metadata.byteLength;
-            requests[i].fileOffset = metadata.byteOffset;
+        requests[i].buffOffset = offset;
+        requests[i].buffIndex = bufferId;
+        requests[i].fileLength = metadata.byteLength;
+        requests[i].fileOffset = metadata.byteOffset;
 
-            offsetSubresource = offset;
+        options.deadline = std::min(options.deadline, metadata.options.deadline);
+        offset += metadata.byteLength;
+    }
 
-            for (const uint32_t mip : std::views::iota(0u, metadata.desc.mipLevels))
-            {
-                Subresource sub;
-                sub.index = mip;
-                sub.offset = offsetSubresource;
-                sub.width = desc.width >> mip;
-                sub.height = desc.height >> mip;
-                uint64_t rowPitch = computePitch(desc.format, sub.width, sub.height);
-                sub.rowPitch = rowPitch;
-                sub.rowPitch = align(sub.rowPitch, 256u);
-                const FormatBlockInfo info = formatToBlockInfo(desc.format);
-                sub.rowPitch /= info.blockSizeByte;
-                sub.rowPitch *= info.blockWidth;
-                cmd->copyBufferToTexture(getStaging(bufferId), texture, sub, nullptr);
-
-                size_t height = std::max<size_t>(1, (sub.height + 3) / 4);
-                size_t subResourceSize = align(rowPitch, 256ull) * height;
-                subResourceSize = align(subResourceSize, 512ull);
-                offsetSubresource += subResourceSize;
-            }
+    const auto resCountDown = static_cast<int64_t>(textures.size());
+    if (!co_await m_ios.submit(requests, options))
+    {
+        latch.count_down(resCountDown);
+        releaseStaging(bufferId);
+        co_return;
+    }
 
-            offset += metadata.byteLength;
+    // Entries are hashed while still in staging, corrupt ones never reach the GPU
+    std::vector<uint8_t> valid(textures.size(), 1);
+    if (checked_cast<Device*>(m_device)->getContext().verifyContent)
+    {
+        std::vector<ContentCheck> checks;
+        checks.reserve(textures.size());
+        for (size_t i = 0; i < textures.size(); ++i)
+        {
+            const std::span data(m_ios.getMemPtr(bufferId) + requests[i].buffOffset, textures[i].byteLength);
+            checks.emplace_back(data, textures[i].contentHash, textures[i].desc.debugName);
         }
+        valid = co_await verifyContent(std::move(checks));
     }
 
-    co_await m_ios.submit(requests);
+    std::vector<size_t> kept;
+    std::vector<TextureDesc> descs;
+    descs.reserve(textures.size());
+    for (size_t i = 0; i < textures.size(); ++i)
+    {
+        if (!valid[i])
+            continue;
+        kept.emplace_back(i);
+        descs.emplace_back(textures[i].desc);
+    }
+    const std::vector<TexturePtr> images = m_device->createTextures(descs);
 
-    m_device->submitOneShot(cmd);
-    auto resCountDown = static_cast<int64_t>(result.size());
+    std::vector<std::vector<Subresource>> regions(textures.size());
+    std::vector<TextureUpload> uploads;
+    uploads.reserve(textures.size());
+
+    {
+        std::lock_guard lock = table->lock();
+        for (size_t k = 0; k < kept.size(); ++k)
+        {
+            const size_t i = kept[k];
+            const TextureStreamingMetadata& metadata = textures[i];
+            const TextureDesc& desc = metadata.desc;
+            const TexturePtr& texture = images[k];
+            result.emplace_back(table->createResourceView(texture), metadata.assetId);
+            log::info("Load texture {:03}: {}", result.back().view->getBindlessIndex(), desc.debugName);
+
+            // Footprints come straight from the pak, no header to parse
+            regions[i] = metadata.footprints.empty() ? computeFootprints(desc) : metadata.footprints;
+            for (Subresource& sub : regions[i])
+                sub.offset += requests[i].buffOffset;
+            uploads.emplace_back(getStaging(bufferId), texture, regions[i]);
+        }
+    }
+
+    uploadTextures(uploads);
     m_dispatcher.enqueue(result);
 
     latch.count_down(resCountDown);
@@ -438,37 +577,71 @@ coro::task<> makeMultiTextureTaskDeprecated(coro::latch& latch, TexturePoolPtr t
     co_return;
 }*/
 
-coro::task<> Storage::makeBufferTask(coro::latch& latch, ReadOnlyFilePtr file, BufferPtr buffer, uint64_t fileLength,
-                                     uint64_t fileOffset)
+coro::task<> Storage::makeBufferTask(coro::latch& latch, BufferStreamingMetadata metadata)
 {
-    std::vector<uint32_t> stagings;
-    uint64_t offset = 0;
-    uint64_t remains = fileLength;
+    const VulkanContext& context = checked_cast<Device*>(m_device)->getContext();
+    const bool verify = context.verifyContent && metadata.contentHash != 0;
+    const uint64_t fileLength = metadata.byteLength;
+    const uint64_t fileOffset = metadata.byteOffset;
+    auto* file = &checked_cast<ReadOnlyFile*>(metadata.file.get())->handle;
+
+    // Host-visible device-local destination: read in place, no staging nor transfer.
+    // Hashing would read back from uncached device memory, verified entries use staging.
+    const auto* target = checked_cast<Buffer*>(metadata.buffer.get());
+    auto* mapped = static_cast<std::byte*>(target->hostInfo.pMappedData);
+    if (mapped != nullptr && !verify)
+    {
+        std::vector<sys::IoService::FileLoadRequest> requests;
+        for (uint64_t offset = 0; offset < fileLength; offset += kStagingSize)
+        {
+            sys::IoService::FileLoadRequest& request = requests.emplace_back();
+            request.file = file;
+            request.fileLength = std::min(fileLength - offset, kStagingSize);
+            request.fileOffset = fileOffset + offset;
+            request.address = mapped + metadata.bufferOffset + offset;
+        }
 
-    std::vector<sys::IoService::FileLoadRequest> requests;
-    CommandPtr cmd = m_device->createCommand(QueueType::Transfer);
+        if (co_await m_ios.submit(requests, metadata.options))
+        {
+            vmaFlushAllocation(context.allocator, target->allocation, metadata.bufferOffset, fileLength);
+            m_stats.directUploadBytes.add(fileLength);
+        }
+
+        latch.count_down();
+        co_return;
+    }
 
-    while (offset < fileLength)
+    std::vector<uint32_t> stagings;
+    std::vector<sys::IoService::FileLoadRequest> requests;
+    for (uint64_t offset = 0; offset < fileLength; offset += kStagingSize)
     {
         int bufferId = co_await acquireStaging();
         stagings.emplace_back(bufferId);
 
-        sys::IoService::FileLoadRequest request;
-        request.file = &checked_cast<ReadOnlyFile*>(file.get())->handle;
-        request.fileLength = std::min(remains, kStagingSize);
+        sys::IoService::FileLoadRequest& request = requests.emplace_back();
+        request.file = file;
+        request.fileLength = std::min(fileLength - offset, kStagingSize);
         request.fileOffset = fileOffset + offset;
         request.buffIndex = bufferId;
-        requests.push_back(request);
-
-        cmd->copyBuffer(getStaging(bufferId), buffer, request.fileLength, offset);
-
-        offset += kStagingSize;
-        remains -= kStagingSize;
     }
 
-    co_await m_ios.submit(requests);
+    bool valid = co_await m_ios.submit(requests, metadata.options);
+    if (valid && verify)
+    {
+        std::vector<std::span<const std::byte>> chunks;
+        for (const sys::IoService::FileLoadRequest& request : requests)
+            chunks.emplace_back(m_ios.getMemPtr(request.buffIndex), request.fileLength);
+        valid = verifyContent(chunks, metadata.contentHash, target->name);
+    }
 
-    m_device->submitOneShot(cmd);
+    if (valid)
+    {
+        CommandPtr cmd = m_device->createCommand(QueueType::Transfer);
+        for (const sys::IoService::FileLoadRequest& request : requests)
+            cmd->copyBuffer(getStaging(request.buffIndex), metadata.buffer, request.fileLength,
+                            metadata.bufferOffset + request.fileOffset - fileOffset);
+        m_device->submitOneShot(cmd);
+    }
 
     latch.count_down();
     for (const uint32_t buffId : stagings)
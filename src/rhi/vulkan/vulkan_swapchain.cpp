@@ -196,6 +196,7 @@ uint32_t SwapChain::present(const RenderPass& renderPass)
 
     // Record pass
     renderPass(m_images[swapChainIndex], m_command[currentFrame]);
+    checked_cast<Command*>(m_command[currentFrame].get())->flushSyncs();
     m_rawCommand[currentFrame].end();
 
     // Submit
@@ -209,9 +209,6 @@ static constexpr vk::ImageUsageFlags pickImageUsage(const TextureDesc& desc, vk:
 
 void Device::populateTexture(const std::shared_ptr<Texture>& texture, const TextureDesc& desc) const
 {
-    texture->allocInfo.usage = VMA_MEMORY_USAGE_AUTO;
-    texture->allocInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
-
     const vk::Format format = convertFormat(desc.format);
     texture->info = vk::ImageCreateInfo();
     texture->info.setImageType(pickImageType(desc.dimension));
@@ -221,16 +218,16 @@ void Device::populateTexture(const std::shared_ptr<Texture>& texture, const Text
     texture->info.setFormat(format);
     texture->info.setInitialLayout(vk::ImageLayout::eUndefined);
     texture->info.setUsage(pickImageUsage(desc, format));
+    // Sampled only textures can be filled from the host
+    if (m_context.hostImageCopy && !desc.isRenderTarget && !desc.isUAV && isHostCopyCompatible(format))
+    {
+        texture->info.usage |= vk::ImageUsageFlagBits::eHostTransferEXT;
+        texture->hostTransfer = true;
+    }
     texture->info.setSharingMode(vk::SharingMode::eExclusive);
     texture->info.setSamples(pickImageSample(desc.sampleCount));
     texture->info.setFlags({});
     texture->info.setTiling(vk::ImageTiling::eOptimal);
-
-    const VkResult res =
-        vmaCreateImage(m_context.allocator, reinterpret_cast<VkImageCreateInfo*>(&texture->info), &texture->allocInfo,
-                       reinterpret_cast<VkImage*>(&texture->handle), &texture->allocation, nullptr);
-    assert(res == VK_SUCCESS);
-    texture->setName(desc.debugName);
 }
 
 Extent Texture::extent() const
@@ -251,6 +248,14 @@ void Texture::setName(const std::string& debugName)
     m_context.device.setDebugUtilsObjectNameEXT(nameInfo);
 }
 
+vk::Image Texture::relocate(vk::Image image, std::vector<vk::UniqueImageView>& retired)
+{
+    for (vk::UniqueImageView& view : m_views | std::views::values)
+        retired.emplace_back(std::move(view));
+    m_views.clear();
+    return std::exchange(handle, image);
+}
+
 vk::ImageView Texture::view(vk::ImageSubresourceRange subresource)
 {
     if (m_views.contains(subresource))
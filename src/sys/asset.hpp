@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string_view>
+#include <vector>
+
+#include <xxhash.h>
+
+namespace ler::sys
+{
+// Stable 64-bit identifier assigned by the packer, 0 means no asset
+using AssetId = uint64_t;
+
+inline AssetId makeAssetId(std::string_view name)
+{
+    return XXH3_64bits(name.data(), name.size());
+}
+
+/// @brief Flat hash map keyed by asset IDs.
+/// IDs are already hashes so they index the slots directly, collisions are resolved
+/// by linear probing and removals shift the following entries back (no tombstones).
+/// Lookups share the lock, only inserts and removals are exclusive.
+template <typename T> class AssetMap
+{
+  public:
+    explicit AssetMap(size_t capacity = 64);
+
+    // Inserts or replaces, returns true when the ID was not present
+    bool insert(AssetId id, T value);
+    [[nodiscard]] std::optional<T> find(AssetId id) const;
+    [[nodiscard]] bool contains(AssetId id) const;
+    std::optional<T> erase(AssetId id);
+    void clear();
+
+    [[nodiscard]] size_t size() const;
+    template <typename F> void forEach(F&& func) const;
+
+  private:
+    struct Slot
+    {
+        AssetId id = 0;
+        T value = {};
+    };
+
+    static constexpr size_t kMaxLoadNum = 7; // Grows past 70% occupancy
+    static constexpr size_t kMaxLoadDen = 10;
+
+    [[nodiscard]] size_t probe(AssetId id) const;
+    void grow();
+
+    std::vector<Slot> m_slots;
+    size_t m_mask = 0;
+    size_t m_size = 0;
+    mutable std::shared_mutex m_mutex;
+};
+
+#include "asset.inl"
+} // namespace ler::sys
@@ -0,0 +1,116 @@
+template <typename T> AssetMap<T>::AssetMap(size_t capacity)
+{
+    m_slots.resize(std::bit_ceil(std::max<size_t>(capacity, 16)));
+    m_mask = m_slots.size() - 1;
+}
+
+template <typename T> size_t AssetMap<T>::probe(AssetId id) const
+{
+    // Slot holding id, or the empty slot ending its probe sequence
+    size_t index = (id ^ (id >> 32)) & m_mask;
+    while (m_slots[index].id != 0 && m_slots[index].id != id)
+        index = (index + 1) & m_mask;
+    return index;
+}
+
+template <typename T> void AssetMap<T>::grow()
+{
+    std::vector<Slot> slots(m_slots.size() * 2);
+    std::swap(slots, m_slots);
+    m_mask = m_slots.size() - 1;
+    for (Slot& slot : slots)
+    {
+        if (slot.id != 0)
+            m_slots[probe(slot.id)] = std::move(slot);
+    }
+}
+
+template <typename T> bool AssetMap<T>::insert(AssetId id, T value)
+{
+    if (id == 0)
+        return false;
+
+    std::unique_lock lock(m_mutex);
+    if ((m_size + 1) * kMaxLoadDen > m_slots.size() * kMaxLoadNum)
+        grow();
+
+    Slot& slot = m_slots[probe(id)];
+    slot.value = std::move(value);
+    if (slot.id == id)
+        return false;
+    slot.id = id;
+    ++m_size;
+    return true;
+}
+
+template <typename T> std::optional<T> AssetMap<T>::find(AssetId id) const
+{
+    if (id == 0)
+        return std::nullopt;
+
+    std::shared_lock lock(m_mutex);
+    const Slot& slot = m_slots[probe(id)];
+    if (slot.id == 0)
+        return std::nullopt;
+    return slot.value;
+}
+
+template <typename T> bool AssetMap<T>::contains(AssetId id) const
+{
+    if (id == 0)
+        return false;
+
+    std::shared_lock lock(m_mutex);
+    return m_slots[probe(id)].id == id;
+}
+
+template <typename T> std::optional<T> AssetMap<T>::erase(AssetId id)
+{
+    if (id == 0)
+        return std::nullopt;
+
+    std::unique_lock lock(m_mutex);
+    size_t hole = probe(id);
+    if (m_slots[hole].id == 0)
+        return std::nullopt;
+
+    std::optional<T> value = std::move(m_slots[hole].value);
+    m_slots[hole] = Slot();
+    --m_size;
+
+    // Backward shift: move up every entry whose home slot is at or before the hole
+    for (size_t next = (hole + 1) & m_mask; m_slots[next].id != 0; next = (next + 1) & m_mask)
+    {
+        const size_t home = (m_slots[next].id ^ (m_slots[next].id >> 32)) & m_mask;
+        if (((next - home) & m_mask) >= ((next - hole) & m_mask))
+        {
+            m_slots[hole] = std::move(m_slots[next]);
+            m_slots[next] = Slot();
+            hole = next;
+        }
+    }
+    return value;
+}
+
+template <typename T> void AssetMap<T>::clear()
+{
+    std::unique_lock lock(m_mutex);
+    std::ranges::fill(m_slots, Slot());
+    m_size = 0;
+}
+
+template <typename T> size_t AssetMap<T>::size() const
+{
+    std::shared_lock lock(m_mutex);
+    return m_size;
+}
+
+template <typename T> template <typename F> void AssetMap<T>::forEach(F&& func) const
+{
+    std::shared_lock lock(m_mutex);
+    for (const Slot& slot : m_slots)
+    {
+        if (slot.id != 0)
+            func(slot.id, slot.value);
+    }
+}
@@ -11,6 +11,7 @@
 #include <winternl.h>
 #include <windows.h>
 #else
+#include <cstring>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
@@ -18,7 +19,7 @@
 
 namespace ler::sys
 {
-ReadOnlyFile::ReadOnlyFile(const fs::path& path) : m_path(path)
+ReadOnlyFile::ReadOnlyFile(const fs::path& path, bool direct) : m_path(path)
 {
     fs::path cleanPath = path;
     std::string str = cleanPath.make_preferred().string();
@@ -52,9 +53,57 @@ ReadOnlyFile::ReadOnlyFile(const fs::path& path) : m_path(path)
         if(errno == EISDIR)
             log::error("ERROR_IS_DIR");
     }
-    struct stat st = {};
-    stat(str.c_str(), &st);
-    m_size = st.st_size;
+    else
+    {
+        struct stat st = {};
+        fstat(m_hFile, &st);
+        m_size = st.st_size;
+    }
+#endif
+
+    if (direct)
+        openDirect(str);
+}
+
+ReadOnlyFile::ReadOnlyFile(const fs::path& path, FD handle, uint64_t size, bool direct)
+    : m_size(size), m_path(path), m_hFile(handle)
+{
+    if (direct)
+    {
+        fs::path cleanPath = path;
+        openDirect(cleanPath.make_preferred().string());
+    }
+}
+
+void ReadOnlyFile::openDirect(const std::string& path)
+{
+#ifdef _WIN32
+    auto pFileName = reinterpret_cast<LPCSTR>(path.c_str());
+    m_hDirect = CreateFile(pFileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | FILE_FLAG_NO_BUFFERING, nullptr);
+    if (m_hDirect == INVALID_HANDLE_VALUE)
+        m_hDirect = nullptr;
+#elif defined(__APPLE__)
+    m_hDirect = open(path.c_str(), O_RDONLY);
+    if (m_hDirect != -1 && fcntl(m_hDirect, F_NOCACHE, 1) == -1)
+    {
+        close(m_hDirect);
+        m_hDirect = -1;
+    }
+#else
+    m_hDirect = open(path.c_str(), O_RDONLY | O_DIRECT);
+#endif
+
+#ifndef _WIN32
+    if (m_hDirect == -1)
+    {
+        // EINVAL: the filesystem does not support direct IO (tmpfs, some FUSE...)
+        log::warn("[IoRing] Direct IO unavailable for {}: {}", path, strerror(errno));
+        m_hDirect = 0;
+    }
+#else
+    if (m_hDirect == nullptr)
+        log::warn("[IoRing] Direct IO unavailable for {}", path);
 #endif
 }
 
@@ -65,8 +114,8 @@ static constexpr int fd_null = 0;
 #endif
 
 ReadOnlyFile::ReadOnlyFile(ReadOnlyFile&& other) noexcept
-    : m_path{ std::exchange(other.m_path, {}) }, m_hFile{ std::exchange(other.m_hFile, fd_null) },
-      m_size{ std::exchange(other.m_size, 0) }
+    : m_size{ std::exchange(other.m_size, 0) }, m_path{ std::exchange(other.m_path, {}) },
+      m_hFile{ std::exchange(other.m_hFile, fd_null) }, m_hDirect{ std::exchange(other.m_hDirect, fd_null) }
 {
 }
 
@@ -78,6 +127,15 @@ ReadOnlyFile::~ReadOnlyFile()
         CloseHandle(m_hFile);
 #else
         close(m_hFile);
+#endif
+    }
+
+    if (m_hDirect)
+    {
+#ifdef _WIN32
+        CloseHandle(m_hDirect);
+#else
+        close(m_hDirect);
 #endif
     }
 }
@@ -87,6 +145,16 @@ FD ReadOnlyFile::getNativeHandle() const
     return m_hFile;
 }
 
+FD ReadOnlyFile::getDirectHandle() const
+{
+    return m_hDirect;
+}
+
+bool ReadOnlyFile::isDirect() const
+{
+    return m_hDirect != fd_null;
+}
+
 std::string ReadOnlyFile::getPath() const
 {
     return m_path.filename().string();
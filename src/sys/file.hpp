@@ -19,20 +19,31 @@ namespace ler::sys
 class ReadOnlyFile
 {
   public:
-    explicit ReadOnlyFile(const fs::path& path);
+    // Direct mode opens a second handle bypassing the page cache (falls back to buffered if unsupported)
+    explicit ReadOnlyFile(const fs::path& path, bool direct = false);
+    // Adopts a handle already opened and sized by IoService::open
+    ReadOnlyFile(const fs::path& path, FD handle, uint64_t size, bool direct = false);
     ReadOnlyFile(ReadOnlyFile&& other) noexcept;
     ~ReadOnlyFile();
 
     [[nodiscard]] FD getNativeHandle() const;
+    [[nodiscard]] FD getDirectHandle() const;
+    [[nodiscard]] bool isDirect() const;
     [[nodiscard]] std::string getPath() const;
 
+    // Offset, length and memory alignment required by direct reads
+    static constexpr uint64_t kDirectAlignment = 4096;
+
     static std::vector<ReadOnlyFile*> openFiles(const fs::path& path, const fs::path& ext);
 
     uint64_t m_size = 0;
 
   private:
+    void openDirect(const std::string& path);
+
     fs::path m_path;
     FD m_hFile = 0;
+    FD m_hDirect = 0;
 };
 using ReadOnlyFilePtr = std::shared_ptr<ReadOnlyFile>;
 } // namespace ler::sys
\ No newline at end of file
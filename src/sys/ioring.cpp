@@ -22,8 +22,30 @@ static std::string getErrorMsg(HRESULT hr)
 
 std::mutex IoService::m_tasks_mutex = {};
 
-IoService::IoService(std::shared_ptr<coro::thread_pool>& tp) : m_threadPool(tp)
+IoService::IoService(std::shared_ptr<coro::thread_pool>& tp, Backend backend) : m_threadPool(tp)
 {
+#ifdef PLATFORM_LINUX
+    if (backend == Backend::Auto)
+    {
+        const char* env = std::getenv("LER_IO_BACKEND");
+        const std::string_view name = env ? env : "";
+        if (name == "threadpool")
+            backend = Backend::ThreadPool;
+        else if (name == "ioring")
+            backend = Backend::IoRing;
+    }
+
+    // io_uring is often blocked by seccomp in containers, fallback to preadv
+    if (backend != Backend::ThreadPool && setupRing())
+        m_backend = Backend::IoRing;
+    else
+    {
+        m_backend = Backend::ThreadPool;
+        m_readers = std::make_unique<coro::thread_pool>(coro::thread_pool::options{ .thread_count = kReaderCount });
+    }
+    log::info("[IoService] Backend: {}", toString(m_backend));
+#endif
+
     constexpr uint32_t num_threads = kWorkerCount;
     m_threads = std::make_unique<std::jthread[]>(num_threads);
     m_setup_mutex.test_and_set(std::memory_order_acquire);
@@ -31,31 +53,210 @@ IoService::IoService(std::shared_ptr<coro::thread_pool>& tp) : m_threadPool(tp)
         m_threads[i] = std::jthread(std::bind_front(&IoService::worker, this));
 }
 
-IoService::Awaiter IoService::submit(FileLoadRequest& request)
+IoService::Awaiter IoService::submit(FileLoadRequest& request, const IoOptions& options)
 {
     Awaiter operation;
     operation.service = this;
+    operation.options = options;
     operation.requests.emplace_back(request);
     return operation;
 }
 
-IoService::Awaiter IoService::submit(std::vector<FileLoadRequest>& request)
+IoService::Awaiter IoService::submit(std::vector<FileLoadRequest>& request, const IoOptions& options)
 {
     Awaiter operation;
     operation.service = this;
+    operation.options = options;
     operation.requests = request; // std::move(request);
     return operation;
 }
 
+IoService::Awaiter IoService::open(std::vector<FileOpenRequest>& requests, const IoOptions& options)
+{
+    Awaiter operation;
+    operation.service = this;
+    operation.options = options;
+    operation.opens = requests;
+    return operation;
+}
+
 void IoService::enqueue(IoBatchRequest& batch)
 {
     {
         const std::scoped_lock tasks_lock(m_tasks_mutex);
-        m_tasks.emplace(std::move(batch));
+        batch.sequence = m_sequence++;
+        batch.submitTime = IoClock::now();
+        m_tasks.emplace_back(&batch);
+        m_stats.queueDepth.add();
     }
     m_task_available_cv.notify_one();
 }
 
+IoService::IoBatchRequest* IoService::dequeue()
+{
+    // Must be called with m_tasks_mutex held and a non-empty queue.
+    // The queue stays short (one batch per streaming task), a linear scan
+    // lets expired deadlines be promoted without rebuilding a heap.
+    const IoClock::time_point now = IoClock::now();
+    const auto rank = [now](const IoBatchRequest* batch) {
+        const IoOptions& opt = batch->options;
+        const IoPriority priority = opt.deadline <= now ? IoPriority::Critical : opt.priority;
+        return std::tuple(priority, opt.deadline, batch->sequence);
+    };
+
+    const auto it = std::ranges::min_element(m_tasks, {}, rank);
+    IoBatchRequest* batch = *it;
+    *it = m_tasks.back();
+    m_tasks.pop_back();
+
+    m_stats.queueDepth.sub();
+    m_stats.queueWait.record(now - batch->submitTime);
+    return batch;
+}
+
+bool IoService::dropCancelled(IoBatchRequest* batch)
+{
+    if (!batch->options.token.isCancelled())
+        return false;
+
+    batch->cancelled = true;
+    m_stats.cancelled.add();
+    m_threadPool->resume(batch->continuation);
+    return true;
+}
+
+void IoService::retire(IoBatchRequest* batch, IoClock::time_point start)
+{
+    const IoClock::time_point now = IoClock::now();
+    uint64_t bytes = 0;
+    for (const FileLoadRequest& req : batch->requests)
+        bytes += req.fileLength;
+
+    m_stats.batches.add();
+    m_stats.requests.add(batch->requests.size());
+    m_stats.filesOpened.add(batch->opens.size());
+    m_stats.bytesRead.add(bytes);
+    if (batch->failed)
+        m_stats.failed.add();
+    m_stats.serviceTime.record(now - start);
+    m_stats.batchLatency.record(now - batch->submitTime);
+    if (now > batch->options.deadline)
+        m_stats.deadlineMissed.add();
+
+    // The batch lives in the coroutine frame, do not touch it after resuming
+    m_threadPool->resume(batch->continuation);
+}
+
+static void openBlocking(IoService::FileOpenRequest& file)
+{
+    file.error = 0;
+#ifdef PLATFORM_WIN
+    file.handle = CreateFileW(file.path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, nullptr);
+    if (file.handle == INVALID_HANDLE_VALUE)
+    {
+        file.error = static_cast<int>(GetLastError());
+        file.handle = nullptr;
+        return;
+    }
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(file.handle, &size);
+    file.size = size.QuadPart;
+#else
+    file.handle = ::open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file.handle == -1)
+    {
+        file.error = errno;
+        file.handle = 0;
+        return;
+    }
+
+    struct stat st = {};
+    fstat(file.handle, &st);
+    file.size = st.st_size;
+#endif
+}
+
+void IoService::openFiles(std::span<FileOpenRequest> files)
+{
+#ifdef PLATFORM_LINUX
+    if (m_backend == Backend::IoRing)
+    {
+        openRing(files);
+        return;
+    }
+
+    // Spread blocking open/fstat over the readers
+    const size_t chunk = (files.size() + kReaderCount - 1) / kReaderCount;
+    coro::latch latch(static_cast<std::int64_t>((files.size() + chunk - 1) / chunk));
+    for (size_t first = 0; first < files.size(); first += chunk)
+        m_readers->spawn(makeOpenTask(files.subspan(first, std::min(chunk, files.size() - first)), latch));
+    coro::sync_wait(latch);
+#else
+    for (FileOpenRequest& file : files)
+        openBlocking(file);
+#endif
+}
+
+void IoService::expand(const FileLoadRequest& req)
+{
+    const ReadOnlyFile* file = req.file;
+    // A request with its own address bypasses the registered buffers
+    std::byte* address = req.address ? req.address : getMemPtr(req.buffIndex) + req.buffOffset;
+    const int32_t buffIndex = req.address ? -1 : req.buffIndex;
+    const ReadSpan buffered = { file->getNativeHandle(), req.fileLength, req.fileOffset, address, req.buffOffset,
+                                buffIndex };
+    if (!file->isDirect() || req.fileLength == 0)
+    {
+        m_spans.emplace_back(buffered);
+        return;
+    }
+
+    constexpr uint64_t kAlign = ReadOnlyFile::kDirectAlignment;
+    const uint64_t end = req.fileOffset + req.fileLength;
+    const uint64_t bodyBegin = (req.fileOffset + kAlign - 1) & ~(kAlign - 1);
+    const uint64_t bodyEnd = end & ~(kAlign - 1);
+
+    // Memory must share the file alignment, otherwise keep the whole request buffered
+    const std::byte* dst = address + (bodyBegin - req.fileOffset);
+    if (bodyEnd <= bodyBegin || reinterpret_cast<uintptr_t>(dst) % kAlign != 0)
+    {
+        m_spans.emplace_back(buffered);
+        return;
+    }
+
+    // Unaligned head and tail go through the page cache, the aligned body bypasses it
+    const auto emplace = [&](HANDLE handle, uint64_t begin, uint64_t length) {
+        const uint64_t delta = begin - req.fileOffset;
+        m_spans.emplace_back(handle, length, begin, address + delta, req.buffOffset + static_cast<uint32_t>(delta),
+                             buffIndex);
+    };
+    if (bodyBegin > req.fileOffset)
+        emplace(buffered.handle, req.fileOffset, bodyBegin - req.fileOffset);
+    emplace(file->getDirectHandle(), bodyBegin, bodyEnd - bodyBegin);
+    if (end > bodyEnd)
+        emplace(buffered.handle, bodyEnd, end - bodyEnd);
+
+    m_stats.directBytes.add(bodyEnd - bodyBegin);
+}
+
+void to_json(json& j, const IoService::Stats& stats)
+{
+    j = json{ { "batches", stats.batches },
+              { "requests", stats.requests },
+              { "bytes_read", stats.bytesRead },
+              { "direct_bytes", stats.directBytes },
+              { "files_opened", stats.filesOpened },
+              { "cancelled", stats.cancelled },
+              { "failed", stats.failed },
+              { "deadline_missed", stats.deadlineMissed },
+              { "queue_depth", stats.queueDepth },
+              { "queue_wait", stats.queueWait },
+              { "service_time", stats.serviceTime },
+              { "batch_latency", stats.batchLatency } };
+}
+
 void IoService::IoBatchRequest::await_suspend(std::coroutine_handle<> handle) noexcept
 {
     continuation = handle;
@@ -64,10 +265,11 @@ void IoService::IoBatchRequest::await_suspend(std::coroutine_handle<> handle) no
 
 void IoService::registerBuffers(std::vector<BufferInfo>& buffers, bool enabled)
 {
-    m_useFixedBuffer = enabled;
+    // Plain preadv has no notion of registered buffers
+    m_useFixedBuffer = enabled && m_backend == Backend::IoRing;
     for (const BufferInfo& b : buffers)
         m_buffers.emplace_back(b.address, b.length);
-    if (enabled)
+    if (m_useFixedBuffer)
     {
         // SpinLock waiting for setup to be completed
         while (m_setup_mutex.test_and_set(std::memory_order_acquire)) {;}
@@ -102,7 +304,7 @@ void IoService::worker(const std::stop_token& stoken)
     assert(res == S_OK);
     m_setup_mutex.clear(std::memory_order_release);
 
-    IoBatchRequest batch;
+    IoBatchRequest* batch;
     uint32_t submittedEntries;
 
     for (;;)
@@ -117,32 +319,41 @@ void IoService::worker(const std::stop_token& stoken)
                 return;
             }
 
-            batch = std::move(m_tasks.front());
-            m_tasks.pop();
+            batch = dequeue();
         }
 
+        if (dropCancelled(batch))
+            continue;
+        const IoClock::time_point start = IoClock::now();
+
+        if (!batch->opens.empty())
+        {
+            openFiles(batch->opens);
+            retire(batch, start);
+            continue;
+        }
+
+        m_spans.clear();
         m_handles.clear();
-        for (const FileLoadRequest& req : batch.requests)
-            m_handles.emplace_back(req.file->getNativeHandle());
+        for (const FileLoadRequest& req : batch->requests)
+            expand(req);
+        for (const ReadSpan& span : m_spans)
+            m_handles.emplace_back(span.handle);
 
         res = BuildIoRingRegisterFileHandles(m_ring, m_handles.size(), m_handles.data(), 0);
 
-        for (uint32_t index = 0; index < batch.requests.size(); ++index)
+        for (uint32_t index = 0; index < m_spans.size(); ++index)
         {
-            FileLoadRequest& req = batch.requests[index];
+            const ReadSpan& req = m_spans[index];
 
             IORING_HANDLE_REF handleRef(index);
             IORING_BUFFER_REF bufferRef(nullptr);
-            if (m_useFixedBuffer)
+            if (m_useFixedBuffer && req.buffIndex >= 0)
                 bufferRef = IORING_BUFFER_REF(req.buffIndex, req.buffOffset);
             else
-            {
-                auto* data = static_cast<std::byte*>(m_buffers[req.buffIndex].Address);
-                bufferRef = IORING_BUFFER_REF(data + req.buffOffset);
-            }
+                bufferRef = IORING_BUFFER_REF(req.address);
 
-            res =
-                BuildIoRingReadFile(m_ring, handleRef, bufferRef, req.fileLength, req.fileOffset, 0, IOSQE_FLAGS_NONE);
+            res = BuildIoRingReadFile(m_ring, handleRef, bufferRef, req.length, req.fileOffset, 0, IOSQE_FLAGS_NONE);
             if (FAILED(res))
             {
                 throw std::runtime_error("[IoRing] Failed building IO ring read file structure: " + getErrorMsg(res));
@@ -161,14 +372,19 @@ void IoService::worker(const std::stop_token& stoken)
             }
         }
 
-        m_threadPool->resume(batch.continuation);
+        retire(batch, start);
     }
 #elif PLATFORM_LINUX
-    int res = io_uring_queue_init(1024, &m_ring, 0);
-    assert(res == 0);
+    // The ring is created by the constructor
     m_setup_mutex.clear(std::memory_order_release);
+    if (m_backend == Backend::ThreadPool)
+    {
+        readerWorker(stoken);
+        return;
+    }
 
-    IoBatchRequest batch;
+    int res;
+    IoBatchRequest* batch;
     uint32_t submittedEntries;
 
     ::rlimit limit = {};
@@ -191,30 +407,42 @@ void IoService::worker(const std::stop_token& stoken)
                 return;
             }
 
-            batch = std::move(m_tasks.front());
-            m_tasks.pop();
+            batch = dequeue();
+        }
+
+        if (dropCancelled(batch))
+            continue;
+        const IoClock::time_point start = IoClock::now();
+
+        if (!batch->opens.empty())
+        {
+            openFiles(batch->opens);
+            retire(batch, start);
+            continue;
         }
 
+        m_spans.clear();
         m_handles.clear();
-        for (const FileLoadRequest& req : batch.requests)
-            m_handles.emplace_back(req.file->getNativeHandle());
+        for (const FileLoadRequest& req : batch->requests)
+            expand(req);
+        for (const ReadSpan& span : m_spans)
+            m_handles.emplace_back(span.handle);
 
         res = io_uring_register_files(&m_ring, m_handles.data(), m_handles.size());
         assert(res == 0);
 
-        for (int index = 0; index < batch.requests.size(); ++index)
+        for (int index = 0; index < m_spans.size(); ++index)
         {
-            const FileLoadRequest& req = batch.requests[index];
+            const ReadSpan& req = m_spans[index];
 
-            auto* data = static_cast<std::byte*>(m_buffers[req.buffIndex].iov_base);
             io_uring_sqe* sqe = io_uring_get_sqe(&m_ring);
             sqe->flags = IOSQE_FIXED_FILE;
 
-            if (m_useFixedBuffer)
-                io_uring_prep_read_fixed(sqe, index, data + req.buffOffset, req.fileLength, req.fileOffset,
-                                         req.buffIndex);
+            if (m_useFixedBuffer && req.buffIndex >= 0)
+                io_uring_prep_read_fixed(sqe, index, req.address, req.length, req.fileOffset, req.buffIndex);
             else
-                io_uring_prep_read(sqe, index, data + req.buffOffset, req.fileLength, req.fileOffset);
+                io_uring_prep_read(sqe, index, req.address, req.length, req.fileOffset);
+            sqe->user_data = index;
         }
 
         submittedEntries = io_uring_submit_and_wait(&m_ring, m_handles.size());
@@ -222,10 +450,13 @@ void IoService::worker(const std::stop_token& stoken)
         io_uring_cqe* cqe;
         for (int i = 0; i < submittedEntries && io_uring_peek_cqe(&m_ring, &cqe) == 0; ++i)
         {
-            if (cqe->res < 0)
+            // A short read is past the end of the file, the span is left partially filled
+            const ReadSpan& span = m_spans[cqe->user_data];
+            if (cqe->res < 0 || static_cast<uint64_t>(cqe->res) < span.length)
             {
-                std::string msg = strerror(-cqe->res);
-                throw std::runtime_error("[IoRing] Read request failed: " + msg);
+                log::error("[IoRing] Read request failed at offset {}: {}", span.fileOffset,
+                           cqe->res < 0 ? strerror(-cqe->res) : "end of file");
+                batch->failed = true;
             }
             io_uring_cqe_seen(&m_ring, cqe);
         }
@@ -233,10 +464,10 @@ void IoService::worker(const std::stop_token& stoken)
         res = io_uring_unregister_files(&m_ring);
         assert(res == 0);
 
-        m_threadPool->resume(batch.continuation);
+        retire(batch, start);
     }
 #elif PLATFORM_MACOS
-    IoBatchRequest batch;
+    IoBatchRequest* batch;
 
     for (;;)
     {
@@ -247,32 +478,276 @@ void IoService::worker(const std::stop_token& stoken)
             if (stoken.stop_requested())
                 return;
 
-            batch = std::move(m_tasks.front());
-            m_tasks.pop();
+            batch = dequeue();
         }
 
-        for (const FileLoadRequest& req : batch.requests)
+        if (dropCancelled(batch))
+            continue;
+        const IoClock::time_point start = IoClock::now();
+
+        if (!batch->opens.empty())
         {
-            auto* data = static_cast<std::byte*>(m_buffers[req.buffIndex].address);
-
-            aiocb cb = {};
-            cb.aio_nbytes = req.fileLength;
-            cb.aio_offset = req.fileOffset;
-            cb.aio_buf = data + req.buffOffset;
-            cb.aio_fildes = req.file->getNativeHandle();
-            if (aio_read(&cb) < 0)
-                log::error("[AIO] Failed to start aio_read for file '{}': {}", req.file->getPath(), strerror(errno));
-            else
+            openFiles(batch->opens);
+            retire(batch, start);
+            continue;
+        }
+
+        for (const FileLoadRequest& req : batch->requests)
+        {
+            m_spans.clear();
+            expand(req);
+            for (const ReadSpan& span : m_spans)
             {
-                aiocb* cbp = &cb;
-                while(aio_error(&cb) == EINPROGRESS)
-                    aio_suspend(&cbp, 1, nullptr);
-                aio_return(&cb);
+                aiocb cb = {};
+                cb.aio_nbytes = span.length;
+                cb.aio_offset = span.fileOffset;
+                cb.aio_buf = span.address;
+                cb.aio_fildes = span.handle;
+                if (aio_read(&cb) < 0)
+                {
+                    log::error("[AIO] Failed to start aio_read for file '{}': {}", req.file->getPath(), strerror(errno));
+                    batch->failed = true;
+                }
+                else
+                {
+                    aiocb* cbp = &cb;
+                    while(aio_error(&cb) == EINPROGRESS)
+                        aio_suspend(&cbp, 1, nullptr);
+                    if (aio_return(&cb) != static_cast<ssize_t>(span.length))
+                    {
+                        log::error("[AIO] Read failed for file '{}' at offset {}", req.file->getPath(),
+                                   span.fileOffset);
+                        batch->failed = true;
+                    }
+                }
             }
         }
 
-        m_threadPool->resume(batch.continuation);
+        retire(batch, start);
     }
 #endif
 }
+
+#ifdef PLATFORM_LINUX
+bool IoService::setupRing()
+{
+    const int res = io_uring_queue_init(1024, &m_ring, 0);
+    if (res == 0)
+        return true;
+
+    log::warn("[IoRing] io_uring unavailable: {}", strerror(-res));
+    return false;
+}
+
+void IoService::readerWorker(const std::stop_token& stoken)
+{
+    // Larger runs are split so one big buffer still spreads over every reader
+    constexpr static uint64_t kMaxRunSize = 8u << 20;
+
+    IoBatchRequest* batch;
+    std::vector<ReadSpan> spans;
+    std::vector<std::span<const ReadSpan>> runs;
+
+    for (;;)
+    {
+        {
+            std::unique_lock tasks_lock(m_tasks_mutex);
+            m_task_available_cv.wait(tasks_lock, stoken, [&] { return !m_tasks.empty(); });
+
+            if (stoken.stop_requested())
+                return;
+
+            batch = dequeue();
+        }
+
+        if (dropCancelled(batch))
+            continue;
+        const IoClock::time_point start = IoClock::now();
+
+        if (!batch->opens.empty())
+        {
+            openFiles(batch->opens);
+            retire(batch, start);
+            continue;
+        }
+
+        m_spans.clear();
+        for (const FileLoadRequest& req : batch->requests)
+            expand(req);
+
+        spans.clear();
+        for (ReadSpan span : m_spans)
+        {
+            while (span.length > 0)
+            {
+                const uint64_t length = std::min(span.length, kMaxRunSize);
+                spans.emplace_back(span.handle, length, span.fileOffset, span.address, span.buffOffset,
+                                   span.buffIndex);
+                span.length -= length;
+                span.fileOffset += length;
+                span.address += length;
+                span.buffOffset += static_cast<uint32_t>(length);
+            }
+        }
+
+        // Contiguous spans of the same file are gathered into a single preadv
+        std::ranges::sort(spans, {}, [](const ReadSpan& s) { return std::tuple(s.handle, s.fileOffset); });
+        runs.clear();
+        size_t first = 0;
+        uint64_t runSize = 0;
+        for (size_t i = 0; i < spans.size(); ++i)
+        {
+            if (i > first)
+            {
+                const ReadSpan& prev = spans[i - 1];
+                const bool contiguous =
+                    spans[i].handle == prev.handle && spans[i].fileOffset == prev.fileOffset + prev.length;
+                if (!contiguous || runSize + spans[i].length > kMaxRunSize)
+                {
+                    runs.emplace_back(spans.data() + first, i - first);
+                    first = i;
+                    runSize = 0;
+                }
+            }
+            runSize += spans[i].length;
+        }
+        if (first < spans.size())
+            runs.emplace_back(spans.data() + first, spans.size() - first);
+
+        if (!runs.empty())
+        {
+            coro::latch latch(static_cast<std::int64_t>(runs.size()));
+            std::atomic<bool> failed = false;
+            for (const std::span<const ReadSpan>& run : runs)
+                m_readers->spawn(makeReadTask(run, latch, failed));
+            coro::sync_wait(latch);
+            batch->failed = failed.load();
+        }
+
+        retire(batch, start);
+    }
+}
+
+void IoService::openRing(std::span<FileOpenRequest> files)
+{
+    // openat and statx by path do not depend on each other, both are queued at once
+    constexpr size_t kChunk = 512;
+    std::vector<struct statx> stx(std::min(files.size(), kChunk));
+    for (size_t base = 0; base < files.size(); base += kChunk)
+    {
+        const size_t count = std::min(kChunk, files.size() - base);
+        std::ranges::fill(stx, statx{});
+        for (size_t i = 0; i < count; ++i)
+        {
+            FileOpenRequest& file = files[base + i];
+            io_uring_sqe* sqe = io_uring_get_sqe(&m_ring);
+            io_uring_prep_openat(sqe, AT_FDCWD, file.path.c_str(), O_RDONLY | O_CLOEXEC, 0);
+            io_uring_sqe_set_data64(sqe, i << 1);
+
+            sqe = io_uring_get_sqe(&m_ring);
+            io_uring_prep_statx(sqe, AT_FDCWD, file.path.c_str(), 0, STATX_SIZE, &stx[i]);
+            io_uring_sqe_set_data64(sqe, i << 1 | 1);
+        }
+
+        io_uring_submit_and_wait(&m_ring, count * 2);
+
+        io_uring_cqe* cqe;
+        for (size_t i = 0; i < count * 2 && io_uring_wait_cqe(&m_ring, &cqe) == 0; ++i)
+        {
+            const uint64_t data = io_uring_cqe_get_data64(cqe);
+            FileOpenRequest& file = files[base + (data >> 1)];
+            // statx writes straight into stx, only the open result matters here
+            if ((data & 1) == 0)
+            {
+                if (cqe->res < 0)
+                    file.error = -cqe->res;
+                else
+                    file.handle = cqe->res;
+            }
+            io_uring_cqe_seen(&m_ring, cqe);
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            FileOpenRequest& file = files[base + i];
+            if (file.error == EINVAL) // Kernel older than 5.6, without IORING_OP_OPENAT
+                openBlocking(file);
+            else if (file.error == 0 && (stx[i].stx_mask & STATX_SIZE) == 0)
+            {
+                struct stat st = {};
+                fstat(file.handle, &st);
+                file.size = st.st_size;
+            }
+            else
+                file.size = stx[i].stx_size;
+        }
+    }
+}
+
+coro::task<> IoService::makeOpenTask(std::span<FileOpenRequest> files, coro::latch& latch)
+{
+    co_await m_readers->schedule();
+    for (FileOpenRequest& file : files)
+        openBlocking(file);
+    latch.count_down();
+}
+
+coro::task<> IoService::makeReadTask(std::span<const ReadSpan> run, coro::latch& latch, std::atomic<bool>& failed)
+{
+    co_await m_readers->schedule();
+    if (!readv(run))
+        failed.store(true);
+    latch.count_down();
+}
+
+bool IoService::readv(std::span<const ReadSpan> run)
+{
+    std::vector<iovec> iov;
+    iov.reserve(run.size());
+    for (const ReadSpan& span : run)
+        iov.emplace_back(span.address, span.length);
+
+    const HANDLE handle = run.front().handle;
+    auto offset = static_cast<off_t>(run.front().fileOffset);
+    size_t first = 0;
+    while (first < iov.size())
+    {
+        const auto count = static_cast<int>(std::min<size_t>(iov.size() - first, IOV_MAX));
+        const ssize_t res = preadv(handle, iov.data() + first, count, offset);
+        if (res < 0 && errno == EINTR)
+            continue;
+        if (res <= 0)
+        {
+            log::error("[IoService] preadv failed at offset {}: {}", offset, res < 0 ? strerror(errno) : "end of file");
+            return false;
+        }
+
+        // Short read: skip the completed vectors and resume inside the partial one
+        offset += res;
+        auto left = static_cast<size_t>(res);
+        while (first < iov.size() && left >= iov[first].iov_len)
+            left -= iov[first++].iov_len;
+        if (left > 0)
+        {
+            iov[first].iov_base = static_cast<std::byte*>(iov[first].iov_base) + left;
+            iov[first].iov_len -= left;
+        }
+    }
+    return true;
+}
+#endif
+
+std::string_view toString(IoService::Backend backend)
+{
+    switch (backend)
+    {
+    case IoService::Backend::Auto:
+        return "Auto";
+    case IoService::Backend::IoRing:
+        return "IoRing";
+    case IoService::Backend::ThreadPool:
+        return "ThreadPool";
+    }
+    return "Unknown";
+}
 } // namespace ler::sys
\ No newline at end of file
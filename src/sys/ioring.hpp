@@ -16,9 +16,12 @@
 #include <ioringapi.h>
 #include <winternl.h>
 #elif PLATFORM_LINUX
+#include <fcntl.h>
 #include <liburing.h>
+#include <sys/stat.h>
 #include <sys/resource.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
 using HANDLE = int;
 #elif PLATFORM_MACOS
 #include <aio.h>
@@ -26,15 +29,18 @@ using HANDLE = int;
 using HANDLE = int;
 #endif
 
+#include <algorithm>
 #include <cassert>
 #include <thread>
 #include <stop_token>
 #include <coro/coro.hpp>
 #include <coroutine>
-#include <queue>
+#include <span>
 
 #include "log/log.hpp"
 #include "file.hpp"
+#include "request.hpp"
+#include "stats.hpp"
 
 namespace ler::sys
 {
@@ -48,6 +54,15 @@ class IoService
         uint64_t fileOffset = 0u;
         uint32_t buffOffset = 0u;
         int32_t buffIndex = 0;
+        std::byte* address = nullptr; // Read straight into this memory instead of a registered buffer
+    };
+
+    struct FileOpenRequest
+    {
+        fs::path path;
+        FD handle = {};
+        uint64_t size = 0u;
+        int error = 0; // errno (GetLastError on Windows), handle is empty when set
     };
 
     struct BufferInfo
@@ -61,21 +76,58 @@ class IoService
       public:
         friend class IoService;
         void await_suspend(std::coroutine_handle<> handle) noexcept;
+        // Returns false when the batch was dropped by its cancel token or one of its reads failed
+        bool await_resume() const noexcept { return !cancelled && !failed; }
 
       private:
         IoService* service = nullptr;
         std::coroutine_handle<> continuation;
         std::vector<FileLoadRequest> requests;
+        std::span<FileOpenRequest> opens;
+        IoOptions options;
+        IoClock::time_point submitTime;
+        uint64_t sequence = 0;
+        bool cancelled = false;
+        bool failed = false; // a read errored or stopped short, the destination holds partial data
     };
 
     using Awaiter = IoBatchRequest;
 
-    explicit IoService(std::shared_ptr<coro::thread_pool>& tp);
+    struct Stats
+    {
+        Counter batches;
+        Counter requests;
+        Counter bytesRead;
+        Counter directBytes; // part of bytesRead served with direct IO
+        Counter filesOpened;
+        Counter cancelled;
+        Counter failed;
+        Counter deadlineMissed;
+        Gauge queueDepth;
+        LatencyHistogram queueWait;    // submit -> picked by the worker
+        LatencyHistogram serviceTime;  // picked -> every read completed
+        LatencyHistogram batchLatency; // submit -> completion
+    };
+
+    enum class Backend : uint8_t
+    {
+        Auto,      // Native ring when available, ThreadPool otherwise
+        IoRing,    // io_uring / IoRing / aio
+        ThreadPool // Batched preadv on dedicated readers (Linux only)
+    };
 
-    Awaiter submit(FileLoadRequest& request);
-    Awaiter submit(std::vector<FileLoadRequest>& request);
+    // LER_IO_BACKEND=ioring|threadpool overrides an Auto backend
+    explicit IoService(std::shared_ptr<coro::thread_pool>& tp, Backend backend = Backend::Auto);
+
+    [[nodiscard]] Backend getBackend() const { return m_backend; }
+
+    Awaiter submit(FileLoadRequest& request, const IoOptions& options = {});
+    Awaiter submit(std::vector<FileLoadRequest>& request, const IoOptions& options = {});
+    // Open and size every file in one batch, results are written back into the requests
+    Awaiter open(std::vector<FileOpenRequest>& requests, const IoOptions& options = {});
 
     void registerBuffers(std::vector<BufferInfo>& buffers, bool enabled);
+    [[nodiscard]] const Stats& getStats() const { return m_stats; }
 #ifdef PLATFORM_WIN
     [[nodiscard]] std::byte* getMemPtr(int id) const { return static_cast<std::byte*>(m_buffers[id].Address); }
 #elif PLATFORM_LINUX
@@ -85,13 +137,40 @@ class IoService
 #endif
 
   private:
+    // One native read, a direct file request can expand into head/body/tail spans
+    struct ReadSpan
+    {
+        HANDLE handle;
+        uint64_t length = 0;
+        uint64_t fileOffset = 0;
+        std::byte* address = nullptr;
+        uint32_t buffOffset = 0;
+        int32_t buffIndex = 0; // -1 for memory outside the registered buffers
+    };
+
+    void expand(const FileLoadRequest& req);
+    void openFiles(std::span<FileOpenRequest> files);
     void worker(const std::stop_token& stoken);
+#ifdef PLATFORM_LINUX
+    bool setupRing();
+    void openRing(std::span<FileOpenRequest> files);
+    coro::task<> makeOpenTask(std::span<FileOpenRequest> files, coro::latch& latch);
+    void readerWorker(const std::stop_token& stoken);
+    coro::task<> makeReadTask(std::span<const ReadSpan> run, coro::latch& latch, std::atomic<bool>& failed);
+    bool readv(std::span<const ReadSpan> run);
+#endif
     void enqueue(IoBatchRequest& batch);
+    IoBatchRequest* dequeue();
+    bool dropCancelled(IoBatchRequest* batch);
+    void retire(IoBatchRequest* batch, IoClock::time_point start);
 
     static constexpr uint32_t kWorkerCount = 1;
+    static constexpr uint32_t kReaderCount = 4;
 
+    Backend m_backend = Backend::IoRing;
     bool m_useFixedBuffer = false;
     std::vector<HANDLE> m_handles;
+    std::vector<ReadSpan> m_spans;
 #ifdef PLATFORM_WIN
     HIORING m_ring = nullptr;
     std::vector<IORING_BUFFER_INFO> m_buffers;
@@ -102,10 +181,18 @@ class IoService
     std::vector<BufferInfo> m_buffers;
 #endif
     std::condition_variable_any m_task_available_cv = {};
+    // Must outlive the worker threads which spawn read tasks on it
+    std::unique_ptr<coro::thread_pool> m_readers;
     std::unique_ptr<std::jthread[]> m_threads = nullptr;
-    std::queue<IoBatchRequest> m_tasks = {};
+    // Pending batches live in their coroutine frame until resumed
+    std::vector<IoBatchRequest*> m_tasks = {};
+    uint64_t m_sequence = 0;
     static std::mutex m_tasks_mutex;
     std::shared_ptr<coro::thread_pool> m_threadPool;
     std::atomic_flag m_setup_mutex = ATOMIC_FLAG_INIT;
+    Stats m_stats;
 };
+
+void to_json(json& j, const IoService::Stats& stats);
+std::string_view toString(IoService::Backend backend);
 } // namespace ler::sys
@@ -15,6 +15,15 @@ void VariableSizeAllocator::reset(OffsetType maxSize)
     addNewBlock(0, m_freeSize);
 }
 
+void VariableSizeAllocator::extend(OffsetType size)
+{
+    if (size == 0)
+        return;
+    const OffsetType offset = m_maxSize;
+    m_maxSize += size;
+    free(offset, size);
+}
+
 void VariableSizeAllocator::addNewBlock(OffsetType offset, OffsetType size)
 {
     auto NewBlockIt = m_freeBlocksByOffset.emplace(offset, size);
@@ -18,9 +18,18 @@ class VariableSizeAllocator
     static constexpr OffsetType InvalidOffset = std::numeric_limits<OffsetType>::max();
 
     void reset(OffsetType maxSize);
+    // Appends free space at the end, merged with a trailing free block
+    void extend(OffsetType size);
     OffsetType allocate(OffsetType size);
     void free(OffsetType offset, OffsetType size);
 
+    [[nodiscard]] OffsetType getMaxSize() const { return m_maxSize; }
+    [[nodiscard]] OffsetType getFreeSize() const { return m_freeSize; }
+    [[nodiscard]] OffsetType getLargestFreeBlock() const
+    {
+        return m_freeBlocksBySize.empty() ? 0 : m_freeBlocksBySize.rbegin()->first;
+    }
+
   private:
     struct FreeBlockInfo;
 
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace ler::sys
+{
+enum class IoPriority : uint8_t
+{
+    Critical = 0, // Data blocking the current frame (visible mips, geometry in view)
+    High,
+    Normal,
+    Prefetch // Speculative reads, served last
+};
+
+using IoClock = std::chrono::steady_clock;
+
+/// @brief Shared flag used to drop queued reads for assets that are no longer needed.
+/// A default constructed token is empty and can never be cancelled.
+class CancelToken
+{
+  public:
+    CancelToken() = default;
+    static CancelToken create() { return CancelToken(std::make_shared<std::atomic_bool>(false)); }
+
+    // clang-format off
+    void cancel() const { if (m_state) m_state->store(true, std::memory_order_release); }
+    [[nodiscard]] bool isCancelled() const { return m_state && m_state->load(std::memory_order_acquire); }
+    [[nodiscard]] bool valid() const { return m_state != nullptr; }
+    bool operator==(const CancelToken& other) const { return m_state == other.m_state; }
+    // clang-format on
+
+  private:
+    explicit CancelToken(std::shared_ptr<std::atomic_bool> state) : m_state(std::move(state)) {}
+    std::shared_ptr<std::atomic_bool> m_state;
+};
+
+struct IoOptions
+{
+    IoPriority priority = IoPriority::Normal;
+    // Batches past their deadline are promoted to Critical
+    IoClock::time_point deadline = IoClock::time_point::max();
+    CancelToken token;
+};
+} // namespace ler::sys
@@ -0,0 +1,107 @@
+#include "stats.hpp"
+
+namespace ler::sys
+{
+void Gauge::add(int64_t n)
+{
+    const int64_t value = m_value.fetch_add(n, std::memory_order_relaxed) + n;
+    int64_t peak = m_peak.load(std::memory_order_relaxed);
+    while (value > peak && !m_peak.compare_exchange_weak(peak, value, std::memory_order_relaxed))
+        ;
+}
+
+uint32_t LatencyHistogram::bucketIndex(uint64_t value)
+{
+    value = std::min<uint64_t>(value, (uint64_t(1) << kMaxValueBits) - 1);
+    if (value < kSubBucketCount)
+        return static_cast<uint32_t>(value);
+
+    // value >> shift lands in [kSubBucketCount, 2 * kSubBucketCount)
+    const uint32_t shift = std::bit_width(value) - 1 - kSubBucketBits;
+    const auto sub = static_cast<uint32_t>(value >> shift) - kSubBucketCount;
+    return (shift + 1) * kSubBucketCount + sub;
+}
+
+uint64_t LatencyHistogram::bucketValue(uint32_t index)
+{
+    if (index < kSubBucketCount)
+        return index;
+
+    // Middle of the bucket range
+    const uint32_t shift = index / kSubBucketCount - 1;
+    const uint64_t low = uint64_t(kSubBucketCount + index % kSubBucketCount) << shift;
+    return low + ((uint64_t(1) << shift) >> 1);
+}
+
+void LatencyHistogram::record(Duration d)
+{
+    record(static_cast<uint64_t>(std::max<Duration::rep>(0, d.count())));
+}
+
+void LatencyHistogram::record(uint64_t nanoseconds)
+{
+    m_buckets[bucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (nanoseconds > max && !m_max.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed))
+        ;
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const
+{
+    // Buckets are read one by one while writers keep going,
+    // percentiles are computed on this copy to stay consistent.
+    std::array<uint64_t, kBucketCount> buckets;
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < kBucketCount; ++i)
+    {
+        buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        count += buckets[i];
+    }
+
+    Snapshot snap;
+    snap.count = count;
+    if (count == 0)
+        return snap;
+
+    static constexpr double kToMicro = 1e-3;
+    snap.mean = static_cast<double>(m_sum.load(std::memory_order_relaxed)) / static_cast<double>(count) * kToMicro;
+    snap.max = static_cast<double>(m_max.load(std::memory_order_relaxed)) * kToMicro;
+
+    const std::array quantiles = { 0.5, 0.9, 0.99, 0.999 };
+    const std::array outputs = { &snap.p50, &snap.p90, &snap.p99, &snap.p999 };
+
+    uint64_t seen = 0;
+    size_t q = 0;
+    for (uint32_t i = 0; i < kBucketCount && q < quantiles.size(); ++i)
+    {
+        seen += buckets[i];
+        while (q < quantiles.size() && static_cast<double>(seen) >= quantiles[q] * static_cast<double>(count))
+            *outputs[q++] = static_cast<double>(bucketValue(i)) * kToMicro;
+    }
+
+    return snap;
+}
+
+void to_json(json& j, const Counter& c)
+{
+    j = c.get();
+}
+
+void to_json(json& j, const Gauge& g)
+{
+    j = json{ { "value", g.get() }, { "peak", g.peak() } };
+}
+
+void to_json(json& j, const LatencyHistogram& h)
+{
+    j = h.snapshot();
+}
+
+void to_json(json& j, const LatencyHistogram::Snapshot& s)
+{
+    j = json{ { "count", s.count }, { "mean_us", s.mean }, { "p50_us", s.p50 }, { "p90_us", s.p90 },
+              { "p99_us", s.p99 }, { "p999_us", s.p999 }, { "max_us", s.max } };
+}
+} // namespace ler::sys
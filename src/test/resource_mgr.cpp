@@ -0,0 +1,195 @@
+#include "render/resource_mgr.hpp"
+#include "rhi/vulkan.hpp"
+
+#include <fstream>
+#include <glm/gtc/matrix_transform.hpp>
+#include <thread>
+#include <xxhash.h>
+
+using namespace ler;
+
+// Same layout as lerPak: header and flatbuffer first, then 64 KiB aligned entries
+static constexpr uint64_t kDataOffset = 256 * 1024;
+static constexpr uint64_t kEntryAlignment = 64 * 1024;
+static constexpr float kCellSize = 100.f;
+static constexpr uint32_t kMaxFrames = 600;
+static constexpr uint32_t kSceneInstances = 16384;
+
+// One triangle mesh per instance, instances placed along X far enough apart to stream one cell at a time
+static bool writeArchive(const fs::path& path, std::string_view name, uint32_t meshCount, bool partitioned)
+{
+    std::vector<uint32_t> indices;
+    std::vector<glm::vec3> positions;
+    for (uint32_t i = 0; i < meshCount; ++i)
+    {
+        const auto base = static_cast<uint32_t>(positions.size());
+        indices.insert(indices.end(), { base, base + 1, base + 2 });
+        positions.insert(positions.end(), { glm::vec3(0.f), glm::vec3(1.f, 0.f, 0.f), glm::vec3(0.f, 1.f, 0.f) });
+    }
+
+    flatbuffers::FlatBufferBuilder builder;
+    std::vector<char> content(kDataOffset);
+    std::vector<flatbuffers::Offset<pak::PakEntry>> entries;
+    const auto appendEntry = [&](pak::BufferType type, const void* data, uint64_t size) {
+        const uint64_t offset = content.size();
+        content.insert(content.end(), static_cast<const char*>(data), static_cast<const char*>(data) + size);
+        content.resize((content.size() + kEntryAlignment - 1) / kEntryAlignment * kEntryAlignment);
+        const pak::Buffer buffer(type);
+        entries.emplace_back(pak::CreatePakEntry(builder, size, offset, pak::ResourceType_Buffer,
+                                                 builder.CreateStruct(buffer).Union(), XXH3_64bits(data, size)));
+    };
+    appendEntry(pak::BufferType_Index, indices.data(), indices.size() * sizeof(uint32_t));
+    for (uint32_t type = pak::BufferType_Position; type <= pak::BufferType_Tangent; ++type)
+        appendEntry(static_cast<pak::BufferType>(type), positions.data(), positions.size() * sizeof(glm::vec3));
+
+    std::vector<pak::Mesh> meshes;
+    std::vector<pak::Instance> instances;
+    std::vector<uint64_t> meshIds;
+    std::vector<flatbuffers::Offset<pak::Cell>> cells;
+    const glm::mat4 identity(1.f);
+    for (uint32_t i = 0; i < meshCount; ++i)
+    {
+        const float x = static_cast<float>(i) * kCellSize * 10.f;
+        const glm::mat4 transform = glm::translate(identity, glm::vec3(x, 0.f, 0.f));
+        meshes.emplace_back(3, i * 3, static_cast<int32_t>(i * 3), 3, pak::Vec3(0.f, 0.f, 0.f),
+                            pak::Vec3(1.f, 1.f, 0.f));
+        instances.emplace_back(i, 0, flatbuffers::span<const float, 16>(glm::value_ptr(transform), 16));
+        meshIds.emplace_back(sys::makeAssetId(fmt::format("{}_{}", name, i)));
+
+        // One cell per instance, nothing is shared
+        if (partitioned)
+        {
+            const pak::Vec3 bbMin(x, 0.f, 0.f);
+            const pak::Vec3 bbMax(x + 1.f, 1.f, 0.f);
+            cells.emplace_back(
+                pak::CreateCell(builder, &bbMin, &bbMax, i, 1, i, 1, builder.CreateVector(std::vector<uint64_t>())));
+        }
+    }
+
+    const pak::Material material;
+    const std::vector<pak::Material> materials(1, material);
+    const std::vector<uint64_t> materialIds(1, sys::makeAssetId(name));
+    builder.Finish(pak::CreatePakArchive(
+        builder, builder.CreateVector(entries), builder.CreateVectorOfStructs(materials),
+        builder.CreateVectorOfStructs(instances), builder.CreateVectorOfStructs(meshes), builder.CreateVector(cells),
+        partitioned ? kCellSize : 0.f, builder.CreateVector(meshIds), builder.CreateVector(materialIds)));
+
+    const auto fbSize = static_cast<int64_t>(builder.GetSize());
+    if (sizeof(uint32_t) + sizeof(int64_t) + fbSize > kDataOffset)
+        return false;
+    std::memcpy(content.data(), "LEPK", sizeof(uint32_t));
+    std::memcpy(content.data() + sizeof(uint32_t), &fbSize, sizeof(int64_t));
+    std::memcpy(content.data() + sizeof(uint32_t) + sizeof(int64_t), builder.GetBufferPointer(), fbSize);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    return file.good();
+}
+
+// Meshes of the archive have landed at their global index
+static bool isResident(render::ResourceManager& mgr, std::string_view name, uint32_t meshCount)
+{
+    for (uint32_t i = 0; i < meshCount; ++i)
+    {
+        const std::optional<uint32_t> index = mgr.findMesh(sys::makeAssetId(fmt::format("{}_{}", name, i)));
+        if (!index.has_value() || mgr.getMeshBuffers().getMesh(*index).countIndex != 3)
+            return false;
+    }
+    return true;
+}
+
+// Moving one instance of a large scene uploads one range, through setTransform or a refreshed list
+static bool isUploadIncremental(const rhi::DevicePtr& device)
+{
+    render::RenderMeshList meshList;
+    std::vector<render::DrawInstance> instances(kSceneInstances);
+    meshList.installStaticScene(device, instances);
+    const render::RenderMeshList::Stats& stats = meshList.getStats();
+    const auto flush = [&] {
+        rhi::CommandPtr command = device->createCommand(rhi::QueueType::Graphics);
+        meshList.flush(command);
+        device->submitOneShot(command);
+    };
+
+    const glm::mat4 moved = glm::translate(glm::mat4(1.f), glm::vec3(1.f, 0.f, 0.f));
+    meshList.setTransform(kSceneInstances / 2, moved);
+    flush();
+    if (stats.ranges.get() != 1 || stats.uploadedBytes.get() != sizeof(render::DrawInstance))
+        return false;
+
+    instances[kSceneInstances / 2].model = moved;
+    instances[kSceneInstances / 4].model = moved;
+    meshList.replaceInstances(instances);
+    flush();
+    return stats.ranges.get() == 2 && stats.uploadedBytes.get() == 2 * sizeof(render::DrawInstance) &&
+           stats.scatters.get() == 0;
+}
+
+int main()
+{
+    log::setup(log::level::info);
+
+    rhi::DeviceConfig config;
+    config.debug = false;
+    config.extensions.emplace_back(VK_KHR_SURFACE_EXTENSION_NAME);
+    rhi::DevicePtr device = rhi::vulkan::CreateDevice(config);
+    rhi::BindlessTablePtr table = device->createBindlessTable(1024);
+    device->shaderAutoCompile();
+
+    const fs::path dir = fs::temp_directory_path();
+    const fs::path flat = dir / "ler_test_flat.pak";
+    const fs::path cells = dir / "ler_test_cells.pak";
+    if (!writeArchive(flat, "flat", 2, false) || !writeArchive(cells, "cells", 2, true))
+    {
+        log::error("Failed to write test archives in {}", dir.string());
+        return EXIT_FAILURE;
+    }
+
+    render::ResourceManager mgr;
+    mgr.setup(device, device->getStorage(), table);
+    if (!mgr.openArchive(device, flat) || !mgr.openArchive(device, cells))
+    {
+        log::error("Failed to open test archives");
+        return EXIT_FAILURE;
+    }
+
+    // Cell 0 is at the eye, cell 1 is out of reach
+    uint32_t frame = 0;
+    for (; frame < kMaxFrames && (mgr.getLoadProgress().loads > 0 || !isResident(mgr, "cells", 1)); ++frame)
+    {
+        mgr.streamCells(device, glm::vec3(0.f));
+        rhi::CommandPtr command = device->createCommand(rhi::QueueType::Graphics);
+        mgr.getMeshBuffers().flush(command);
+        device->submitOneShot(command);
+        device->runGarbageCollection();
+        mgr.update(device);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    int result = EXIT_SUCCESS;
+    if (!isUploadIncremental(device))
+    {
+        log::error("Moving one instance out of {} did not upload a single range", kSceneInstances);
+        result = EXIT_FAILURE;
+    }
+    if (!isResident(mgr, "flat", 2))
+    {
+        log::error("Meshes of the flat archive did not land after {} frames", frame);
+        result = EXIT_FAILURE;
+    }
+    if (!isResident(mgr, "cells", 1) || isResident(mgr, "cells", 2))
+    {
+        log::error("Cells of the partitioned archive did not stream around the eye after {} frames", frame);
+        result = EXIT_FAILURE;
+    }
+
+    mgr.closeArchive(flat);
+    mgr.closeArchive(cells);
+    for (uint32_t i = 0; i <= rhi::ISwapChain::FrameCount; ++i)
+        mgr.update(device);
+    device->waitIdle();
+
+    fs::remove(flat);
+    fs::remove(cells);
+    return result;
+}